@@ -0,0 +1,52 @@
+//@author A0096863M
+#include <QScopedPointer>
+#include "Commands.h"
+#include "Interpreter.h"
+#include "Tasuke.h"
+#include "Benchmark.h"
+
+static const int BATCH_SIZE = 10000;
+static const int BATCH_EDITS = 500;
+static const unsigned int SEED = 2103;
+
+// Measures marking 500 of 10k tasks done, reported per task marked. "batch/"
+// runs "done 1-500" as one composite command, which publishes and redraws
+// once, and "legacy/done-unbatched" makes the same edits one by one, each
+// rebuilding and publishing the list of tasks. "batch/done-one" marks a single
+// task done for comparison.
+void runBatchBenchmarks() {
+	IStorage& original = Tasuke::instance().getStorage();
+	BenchmarkStorage storage;
+	storage.load(Benchmark::generateTasks(BATCH_SIZE, SEED));
+	Tasuke::instance().setStorage(&storage);
+
+	QScopedPointer<ICommand> one(Interpreter::interpret("done 1"));
+	Benchmark::report("batch/done-one", 1, Benchmark::measure([&]() {
+		one->run();
+	}));
+	one->undo();
+
+	QScopedPointer<ICommand> composite(Interpreter::interpret(
+		"done 1-" + QString::number(BATCH_EDITS)));
+	Benchmark::report("batch/done " + QString::number(BATCH_EDITS),
+		BATCH_EDITS, Benchmark::measure([&]() {
+		composite->run();
+	}));
+	composite->undo();
+
+	QList<quint64> uids;
+	for (int i=0; i<BATCH_EDITS; i++) {
+		uids.push_back(storage.getTask(i).getUid());
+	}
+
+	Benchmark::report("legacy/done-unbatched " + QString::number(BATCH_EDITS),
+		BATCH_EDITS, Benchmark::measure([&]() {
+		foreach (quint64 uid, uids) {
+			Task task = storage.getTaskByUid(uid);
+			task.setDone(true);
+			storage.editTaskByUid(uid, task);
+		}
+	}));
+
+	Tasuke::instance().setStorage(&original);
+}
@@ -0,0 +1,226 @@
+//@author A0096863M
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "Benchmark.h"
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static const int TAG_POOL_SIZE = 50;
+static const int MAX_TAGS_PER_TASK = 3;
+static const int DAYS_AROUND_BASE = 60;
+static const int DONE_PERCENT = 30;
+
+static std::atomic<qint64> allocationCount(0);
+static QFile results;
+
+// Counts every allocation made through operator new, which is how tasks,
+// shared pointer control blocks and list nodes are allocated. The character
+// data of Qt strings and containers is allocated with malloc and not counted.
+void* operator new(std::size_t size) {
+	allocationCount++;
+	void* memory = std::malloc(size > 0 ? size : 1);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) throw() {
+	std::free(memory);
+}
+
+// Generates count tasks with a mix of descriptions, tags, begin and end times
+// and done status. The same seed always gives the same tasks.
+QList<Task> Benchmark::generateTasks(int count, unsigned int seed) {
+	std::mt19937 random(seed);
+	QDateTime base(QDate(2014, 4, 1), QTime(12, 0));
+	QList<Task> tasks;
+	tasks.reserve(count);
+
+	for (int i=0; i<count; i++) {
+		int word = random() % (count + 1);
+		Task task("task " + QString::number(word) + " of " + QString::number(i));
+
+		int shape = random() % 3;
+		if (shape != 0) {
+			int offset = (int) (random() % (2 * DAYS_AROUND_BASE * 24))
+				- DAYS_AROUND_BASE * 24;
+			QDateTime end = base.addSecs(offset * 3600);
+			task.setEnd(end);
+			if (shape == 2) {
+				task.setBegin(end.addSecs(-3600 * (1 + random() % 4)));
+			}
+		}
+
+		int tagCount = random() % (MAX_TAGS_PER_TASK + 1);
+		for (int j=0; j<tagCount; j++) {
+			int tag = random() % TAG_POOL_SIZE;
+			task.addTag("tag" + QString::number(tag));
+		}
+
+		task.setDone((int) (random() % 100) < DONE_PERCENT);
+		tasks.push_back(task);
+	}
+
+	return tasks;
+}
+
+// Runs function once and returns how long it took in nanoseconds.
+qint64 Benchmark::measure(std::function<void()> function) {
+	QElapsedTimer timer;
+	timer.start();
+	function();
+	return timer.nsecsElapsed();
+}
+
+// Appends one measurement to the results file, if one is open, as a line of
+// JSON with its name, number of tasks and the given values.
+static void record(QString name, int count, QJsonObject values) {
+	if (!results.isOpen()) {
+		return;
+	}
+
+	values.insert("name", name);
+	values.insert("tasks", count);
+	results.write(QJsonDocument(values).toJson(QJsonDocument::Compact));
+	results.write("\n");
+	results.flush();
+}
+
+// Prints one measurement.
+void Benchmark::report(QString name, int count, qint64 nsecs) {
+	double perTask = count > 0 ? (double) nsecs / count : 0;
+	printf("%s\t%d\t%.1f\t%.1f\n", name.toUtf8().constData(), count,
+		nsecs / 1000000.0, perTask);
+	fflush(stdout);
+
+	QJsonObject values;
+	values.insert("ns", nsecs);
+	values.insert("nsPerTask", perTask);
+	record(name, count, values);
+}
+
+// Prints one memory measurement.
+void Benchmark::reportBytes(QString name, int count, qint64 bytes) {
+	double perTask = count > 0 ? (double) bytes / count : 0;
+	printf("%s\t%d\t%lld\t%.1f\n", name.toUtf8().constData(), count,
+		bytes, perTask);
+	fflush(stdout);
+
+	QJsonObject values;
+	values.insert("bytes", bytes);
+	values.insert("bytesPerTask", perTask);
+	record(name, count, values);
+}
+
+// Prints one count.
+void Benchmark::reportCount(QString name, int count, qint64 total) {
+	double perTask = count > 0 ? (double) total / count : 0;
+	printf("%s\t%d\t%lld\t%.2f\n", name.toUtf8().constData(), count,
+		total, perTask);
+	fflush(stdout);
+
+	QJsonObject values;
+	values.insert("total", total);
+	values.insert("perTask", perTask);
+	record(name, count, values);
+}
+
+// Prints the time and allocations of operations run on count tasks.
+void Benchmark::reportOperation(QString name, int count, int operations,
+								qint64 nsecs, qint64 allocations) {
+	double nsPerOperation = operations > 0 ? (double) nsecs / operations : 0;
+	double allocationsPerOperation = operations > 0
+		? (double) allocations / operations : 0;
+	printf("%s\t%d\t%.1f\t%.2f\n", name.toUtf8().constData(), count,
+		nsPerOperation, allocationsPerOperation);
+	fflush(stdout);
+
+	QJsonObject values;
+	values.insert("operations", operations);
+	values.insert("nsPerOperation", nsPerOperation);
+	values.insert("allocationsPerOperation", allocationsPerOperation);
+	record(name, count, values);
+}
+
+// Starts writing every measurement to the file at path as well, replacing
+// whatever it held. Returns false if it cannot be written.
+bool Benchmark::openResults(QString path) {
+	closeResults();
+	results.setFileName(path);
+	return results.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+// Stops writing measurements to the results file.
+void Benchmark::closeResults() {
+	if (results.isOpen()) {
+		results.close();
+	}
+}
+
+// Returns the number of allocations made through operator new so far.
+qint64 Benchmark::allocations() {
+	return allocationCount;
+}
+
+// Returns the most memory the process has had resident at once so far, in
+// bytes.
+qint64 Benchmark::peakMemory() {
+#if defined(Q_OS_WIN)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+		sizeof(counters))) {
+		return 0;
+	}
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(Q_OS_MAC)
+	return usage.ru_maxrss;
+#else
+	return (qint64) usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// Returns a path in the temporary directory for files the benchmarks write.
+QString Benchmark::tempPath(QString fileName) {
+	return QDir::temp().absoluteFilePath("tasuke-benchmark-" + fileName);
+}
+
+// Replaces the tasks in memory with _tasks in a single pass.
+void BenchmarkStorage::load(const QList<Task>& _tasks) {
+	tasks.clear();
+	foreach (const Task& task, _tasks) {
+		tasks.push_back(QSharedPointer<Task>::create(task));
+	}
+	renumber();
+}
+
+// Returns roughly how many bytes the description index takes up.
+qint64 BenchmarkStorage::descriptionIndexBytes() const {
+	return descriptionIndex.memoryUsage();
+}
+
+void BenchmarkStorage::loadFile() {
+
+}
+
+void BenchmarkStorage::saveFile() {
+
+}
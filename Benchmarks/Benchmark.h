@@ -0,0 +1,58 @@
+//@author A0096863M
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <QList>
+#include <QString>
+#include "Task.h"
+#include "Storage.h"
+
+// Helpers shared by the benchmarks. Every benchmark reports one line per
+// measurement in the form "name<TAB>tasks<TAB>total ms<TAB>ns per task".
+// Memory is reported as "name<TAB>tasks<TAB>total bytes<TAB>bytes per task",
+// and counts, like allocations, as "name<TAB>tasks<TAB>total<TAB>per task".
+// Operations on a number of tasks are reported as
+// "name<TAB>tasks<TAB>ns per operation<TAB>allocations per operation".
+// Every measurement can also be written to a results file as JSON Lines, so
+// that runs on different commits can be compared.
+class Benchmark {
+public:
+	static QList<Task> generateTasks(int count, unsigned int seed);
+	static qint64 measure(std::function<void()> function);
+	static void report(QString name, int count, qint64 nsecs);
+	static void reportBytes(QString name, int count, qint64 bytes);
+	static void reportCount(QString name, int count, qint64 total);
+	static void reportOperation(QString name, int count, int operations,
+		qint64 nsecs, qint64 allocations);
+	static bool openResults(QString path);
+	static void closeResults();
+	static qint64 allocations();
+	static qint64 peakMemory();
+	static QString tempPath(QString fileName);
+};
+
+// Storage that only lives in memory, so that benchmarks measure the
+// in-memory operations without any disk I/O.
+class BenchmarkStorage : public IStorage {
+public:
+	void load(const QList<Task>& _tasks);
+	qint64 descriptionIndexBytes() const;
+	void loadFile() override;
+	void saveFile() override;
+};
+
+void runSnapshotBenchmarks();
+void runOrderBenchmarks();
+void runSearchBenchmarks();
+void runFreeTimeBenchmarks();
+void runFilterBenchmarks();
+void runMemoryBenchmarks();
+void runBatchBenchmarks();
+void runBulkBenchmarks();
+void runTransferBenchmarks();
+void runStorageBenchmarks();
+void runDateBenchmarks();
+void runSubstituteBenchmarks();
+
+#endif
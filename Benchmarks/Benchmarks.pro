@@ -0,0 +1,143 @@
+# Headless benchmarks for Tasuke. Links against the same sources as the
+# application, except main.cpp, and runs without showing any windows.
+
+TEMPLATE = app
+TARGET = TasukeBenchmarks
+QT += core widgets gui
+CONFIG += console c++11 release
+CONFIG -= app_bundle
+
+TASUKE = $$_PRO_FILE_PWD_/../Tasuke
+UNITTESTS = $$_PRO_FILE_PWD_/../UnitTests
+
+DEPENDPATH += . $$TASUKE $$UNITTESTS
+INCLUDEPATH += . $$TASUKE $$TASUKE/GeneratedFiles $$UNITTESTS
+UI_DIR += ./GeneratedFiles
+RCC_DIR += ./GeneratedFiles
+MOC_DIR += ./GeneratedFiles
+DESTDIR = ../bin/benchmarks
+
+HEADERS += ./Benchmark.h \
+    $$TASUKE/Interpreter.h \
+    $$TASUKE/Commands.h \
+    $$TASUKE/Constants.h \
+    $$TASUKE/Task.h \
+    $$TASUKE/Exceptions.h \
+    $$TASUKE/TaskWindow.h \
+    $$TASUKE/TutorialWidget.h \
+    $$TASUKE/AboutWindow.h \
+    $$TASUKE/SettingsWindow.h \
+    $$TASUKE/InputHighlighter.h \
+    $$TASUKE/HotKeyManager.h \
+    $$TASUKE/InputWindow.h \
+    $$TASUKE/HotKeyThread.h \
+    $$TASUKE/SystemTrayWidget.h \
+    $$TASUKE/SlidingStackedWidget.h \
+    $$TASUKE/TaskEntry.h \
+    $$TASUKE/Tasuke.h \
+    $$TASUKE/Storage.h \
+    $$TASUKE/TooltipWidget.h \
+    $$TASUKE/SubheadingEntry.h \
+    $$TASUKE/ThemeStylesheets.h \
+    $$TASUKE/NotificationManager.h \
+    $$TASUKE/Journal.h \
+    $$TASUKE/Snapshot.h \
+    $$TASUKE/PersistenceWorker.h \
+    $$TASUKE/TaskOrderIndex.h \
+    $$TASUKE/TimeSnapshot.h \
+    $$TASUKE/TagIndex.h \
+    $$TASUKE/TrigramIndex.h \
+    $$TASUKE/TaskView.h \
+    $$TASUKE/IntervalIndex.h \
+    $$TASUKE/Revision.h \
+    $$TASUKE/TaskTable.h \
+    $$TASUKE/TagDictionary.h \
+    $$TASUKE/TaskTransfer.h \
+    $$TASUKE/DateParser.h \
+    $$TASUKE/Substituter.h \
+    $$TASUKE/ParseCache.h \
+    $$UNITTESTS/DateFormats.h
+SOURCES += ./main.cpp \
+    ./Benchmark.cpp \
+    ./SnapshotBenchmark.cpp \
+    ./OrderBenchmark.cpp \
+    ./SearchBenchmark.cpp \
+    ./FreeTimeBenchmark.cpp \
+    ./FilterBenchmark.cpp \
+    ./MemoryBenchmark.cpp \
+    ./BatchBenchmark.cpp \
+    ./BulkBenchmark.cpp \
+    ./TransferBenchmark.cpp \
+    ./StorageBenchmark.cpp \
+    ./DateBenchmark.cpp \
+    ./SubstituteBenchmark.cpp \
+    $$TASUKE/AboutWindow.cpp \
+    $$TASUKE/HotKeyManager.cpp \
+    $$TASUKE/InputHighlighter.cpp \
+    $$TASUKE/Interpreter.cpp \
+    $$TASUKE/Commands.cpp \
+    $$TASUKE/HotKeyThread.cpp \
+    $$TASUKE/InputWindow.cpp \
+    $$TASUKE/SettingsWindow.cpp \
+    $$TASUKE/SlidingStackedWidget.cpp \
+    $$TASUKE/SystemTrayWidget.cpp \
+    $$TASUKE/Task.cpp \
+    $$TASUKE/Exceptions.cpp \
+    $$TASUKE/TaskEntry.cpp \
+    $$TASUKE/TaskWindow.cpp \
+    $$TASUKE/Tasuke.cpp \
+    $$TASUKE/Storage.cpp \
+    $$TASUKE/TutorialWidget.cpp \
+    $$TASUKE/TooltipWidget.cpp \
+    $$TASUKE/SubheadingEntry.cpp \
+    $$TASUKE/ThemeStylesheets.cpp \
+    $$TASUKE/NotificationManager.cpp \
+    $$TASUKE/Journal.cpp \
+    $$TASUKE/Snapshot.cpp \
+    $$TASUKE/PersistenceWorker.cpp \
+    $$TASUKE/TaskOrderIndex.cpp \
+    $$TASUKE/TimeSnapshot.cpp \
+    $$TASUKE/TagIndex.cpp \
+    $$TASUKE/TrigramIndex.cpp \
+    $$TASUKE/TaskView.cpp \
+    $$TASUKE/IntervalIndex.cpp \
+    $$TASUKE/Revision.cpp \
+    $$TASUKE/TaskTable.cpp \
+    $$TASUKE/TagDictionary.cpp \
+    $$TASUKE/TaskTransfer.cpp \
+    $$TASUKE/DateParser.cpp \
+    $$TASUKE/Substituter.cpp \
+    $$TASUKE/ParseCache.cpp \
+    $$UNITTESTS/DateFormats.cpp
+FORMS += $$TASUKE/TaskWindow.ui \
+    $$TASUKE/InputWindow.ui \
+    $$TASUKE/AboutWindow.ui \
+    $$TASUKE/TaskEntry.ui \
+    $$TASUKE/TutorialWidget.ui \
+    $$TASUKE/SettingsWindow.ui \
+    $$TASUKE/TooltipWidget.ui \
+    $$TASUKE/SubheadingEntry.ui
+RESOURCES += $$TASUKE/Resources.qrc
+
+win32 {
+    LIBS += -L$$_PRO_FILE_PWD_/../Win32/Release -llibglog
+    LIBS += -L$$_PRO_FILE_PWD_/../Win32/Release -llibhunspell
+    INCLUDEPATH += $$_PRO_FILE_PWD_/../hunspell-1.3.2/src
+    INCLUDEPATH += $$_PRO_FILE_PWD_/../glog-0.3.3/src/windows
+    DEFINES += GOOGLE_GLOG_DLL_DECL=
+    DEFINES += HUNSPELL_STATIC
+    LIBS += -lpsapi
+}
+
+unix {
+    LIBS += -L/usr/local/lib -L/usr/lib -lglog
+    LIBS += -L/usr/local/lib -L/usr/lib -lhunspell
+    INCLUDEPATH += /usr/local/include \
+        /usr/include
+}
+
+macx {
+    HEADERS += $$TASUKE/MacWindowActivator.h
+    OBJECTIVE_SOURCES += $$TASUKE/MacWindowActivator.mm
+    QMAKE_LFLAGS += -framework carbon -framework cocoa
+}
@@ -0,0 +1,46 @@
+//@author A0096863M
+#include <QScopedPointer>
+#include "Commands.h"
+#include "Constants.h"
+#include "Interpreter.h"
+#include "Tasuke.h"
+#include "Benchmark.h"
+
+static const int BULK_SIZE = 50000;
+static const unsigned int SEED = 2103;
+
+// Runs the command in commandString on storage and then undoes it, reporting
+// both per task in count.
+static void measureBulk(QString name, QString commandString, int count) {
+	QScopedPointer<ICommand> command(Interpreter::interpret(commandString));
+	Benchmark::report(name, count, Benchmark::measure([&]() {
+		command->run();
+	}));
+	Benchmark::report(name + " (undo)", count, Benchmark::measure([&]() {
+		command->undo();
+	}));
+}
+
+// Measures the commands that pick tasks by a condition on 50k tasks, with
+// tens of thousands of matches, reported per task matched. "bulk/" runs each
+// as a single pass over storage, and "legacy/done-each undone" marks the
+// same tasks done through one DoneCommand per task, like "done undone" does.
+void runBulkBenchmarks() {
+	IStorage& original = Tasuke::instance().getStorage();
+	BenchmarkStorage storage;
+	storage.load(Benchmark::generateTasks(BULK_SIZE, SEED));
+	Tasuke::instance().setStorage(&storage);
+
+	int undone = storage.query(PREDICATE_UNDONE).size();
+	measureBulk("bulk/done-where undone", "done where undone", undone);
+	measureBulk("legacy/done-each undone", "done undone", undone);
+
+	int done = storage.query(PREDICATE_DONE).size();
+	measureBulk("bulk/remove-where done", "remove where done", done);
+
+	int tagged = storage.queryWithTag("tag7").size();
+	measureBulk("bulk/retag", "retag #tag7 to #renamed", tagged);
+	measureBulk("bulk/remove-where #tag", "remove where #tag7", tagged);
+
+	Tasuke::instance().setStorage(&original);
+}
@@ -0,0 +1,33 @@
+//@author A0096863M
+#include <QStringList>
+#include "DateFormats.h"
+#include "Interpreter.h"
+#include "Benchmark.h"
+
+static const int PARSE_REPEATS = 100000;
+static const int LEGACY_REPEATS = 20;
+
+// Measures reading one date, reported per call, for a time, a day, a full
+// date and time, and two half typed inputs like those every dry run sees.
+// "legacy/date-formats" tries the generated formats in turn, like parseDate()
+// used to.
+void runDateBenchmarks() {
+	QStringList inputs;
+	inputs << "5pm" << "5 jan" << "5 jan 2014 10:30 pm" << "5 ja" << "5 jan 20";
+
+	foreach (const QString& input, inputs) {
+		Benchmark::report("date/parse \"" + input + "\"", PARSE_REPEATS,
+			Benchmark::measure([&]() {
+			for (int i=0; i<PARSE_REPEATS; i++) {
+				Interpreter::parseDate(input);
+			}
+		}));
+
+		Benchmark::report("legacy/date-formats \"" + input + "\"",
+			LEGACY_REPEATS, Benchmark::measure([&]() {
+			for (int i=0; i<LEGACY_REPEATS; i++) {
+				DateFormats::parse(input);
+			}
+		}));
+	}
+}
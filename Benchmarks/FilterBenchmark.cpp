@@ -0,0 +1,61 @@
+//@author A0096863M
+#include "Constants.h"
+#include "Benchmark.h"
+
+static const int FILTER_SIZE = 100000;
+static const int FILTER_REPEATS = 100;
+static const int BUILD_REPEATS = 10;
+static const unsigned int SEED = 2103;
+
+// Measures the done, overdue, due today and ongoing filters over 100k tasks,
+// reported per query. "filter/..." runs over the columns of the task table,
+// and "legacy/filter-scan ..." checks every task with the same predicate, like
+// search() used to. Building the table, which happens once per revision, is
+// reported separately.
+void runFilterBenchmarks() {
+	QList<Task> tasks = Benchmark::generateTasks(FILTER_SIZE, SEED);
+	BenchmarkStorage storage;
+	storage.load(tasks);
+
+	QVector< QSharedPointer<Task> > pointers;
+	foreach (const Task& task, tasks) {
+		pointers.push_back(QSharedPointer<Task>::create(task));
+	}
+
+	Benchmark::report("filter/build-table", BUILD_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<BUILD_REPEATS; i++) {
+			TaskTable table(pointers);
+		}
+	}));
+
+	QList<QString> names;
+	QList<TaskTable::Filter> filters;
+	QList< std::function<bool(const Task&)> > predicates;
+
+	names << "done" << "overdue" << "today" << "ongoing";
+	filters << PREDICATE_DONE << PREDICATE_OVERDUE << PREDICATE_TODAY
+		<< PREDICATE_ONGOING;
+	predicates << [](const Task& task) { return task.isDone(); }
+		<< [](const Task& task) { return task.isOverdue(); }
+		<< [](const Task& task) { return task.isDueToday(); }
+		<< [](const Task& task) { return task.isOngoing(); };
+
+	for (int f=0; f<filters.size(); f++) {
+		storage.query(filters[f]);
+
+		Benchmark::report("filter/" + names[f], FILTER_REPEATS,
+			Benchmark::measure([&]() {
+			for (int i=0; i<FILTER_REPEATS; i++) {
+				storage.query(filters[f]);
+			}
+		}));
+
+		Benchmark::report("legacy/filter-scan " + names[f], FILTER_REPEATS,
+			Benchmark::measure([&]() {
+			for (int i=0; i<FILTER_REPEATS; i++) {
+				storage.query(predicates[f]);
+			}
+		}));
+	}
+}
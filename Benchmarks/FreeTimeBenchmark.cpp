@@ -0,0 +1,60 @@
+//@author A0096863M
+#include "Benchmark.h"
+
+static const int FREE_TIME_SIZE = 100000;
+static const int FREE_TIME_REPEATS = 1000;
+static const int LEGACY_REPEATS = 10;
+static const int WINDOW_DAYS = 7;
+static const qint64 MSECS_IN_HOUR = 3600 * 1000;
+static const unsigned int SEED = 2103;
+
+// Measures free time queries over 100k tasks, reported per query.
+// "legacy/free-gaps-scan" walks every task for each query,
+// like nextFreeTime used to.
+void runFreeTimeBenchmarks() {
+	QList<Task> tasks = Benchmark::generateTasks(FREE_TIME_SIZE, SEED);
+	BenchmarkStorage storage;
+	storage.load(tasks);
+
+	QDateTime begin(QDate(2014, 4, 1), QTime(0, 0));
+	QDateTime end = begin.addDays(WINDOW_DAYS);
+
+	Benchmark::report("free-time/free-gaps 7 days", FREE_TIME_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<FREE_TIME_REPEATS; i++) {
+			storage.freeSlots(begin, end, MSECS_IN_HOUR);
+		}
+	}));
+
+	Benchmark::report("free-time/next-free-slot 3h", FREE_TIME_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<FREE_TIME_REPEATS; i++) {
+			storage.nextFreeSlot(3 * MSECS_IN_HOUR);
+		}
+	}));
+
+	Benchmark::report("free-time/overlapping 7 days", FREE_TIME_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<FREE_TIME_REPEATS; i++) {
+			storage.queryOverlapping(begin, end);
+		}
+	}));
+
+	Benchmark::report("legacy/free-gaps-scan 7 days", LEGACY_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<LEGACY_REPEATS; i++) {
+			QList<FreeSlot> gaps;
+			QDateTime cursor = begin;
+			foreach (const Task& task, storage.getTasks()) {
+				if (!task.isEvent() || task.getEnd() <= cursor
+					|| task.getBegin() >= end) {
+					continue;
+				}
+				if (cursor.msecsTo(task.getBegin()) >= MSECS_IN_HOUR) {
+					gaps.push_back(FreeSlot(cursor, task.getBegin()));
+				}
+				cursor = qMax(cursor, task.getEnd());
+			}
+		}
+	}));
+}
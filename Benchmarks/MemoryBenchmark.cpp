@@ -0,0 +1,150 @@
+//@author A0096863M
+#include <QFile>
+#include "Storage.h"
+#include "Snapshot.h"
+#include "Benchmark.h"
+
+static const int MEMORY_SIZE = 100000;
+static const unsigned int SEED = 2103;
+static const int SLAB_SIZE = 1024;
+
+// A slab allocator for tasks, which hands them out from blocks of SLAB_SIZE
+// and frees the blocks all at once when it is destroyed. It is only safe to
+// destroy once every task made from it is gone.
+class TaskSlab {
+public:
+	TaskSlab() : used(SLAB_SIZE) {
+
+	}
+
+	~TaskSlab() {
+		foreach (void* block, blocks) {
+			::operator delete(block);
+		}
+	}
+
+	// Returns a handle to a copy of task made in the slab. Its slot is given
+	// back to the slab when the last handle to it is gone.
+	QSharedPointer<Task> make(const Task& task) {
+		Task* slot;
+		if (!freed.isEmpty()) {
+			slot = freed.takeLast();
+		} else {
+			if (used == SLAB_SIZE) {
+				blocks.push_back(::operator new(sizeof(Task) * SLAB_SIZE));
+				used = 0;
+			}
+			slot = static_cast<Task*>(blocks.last()) + used;
+			used++;
+		}
+		new (slot) Task(task);
+		return QSharedPointer<Task>(slot, [this](Task* done) {
+			done->~Task();
+			freed.push_back(done);
+		});
+	}
+
+private:
+	QVector<void*> blocks;
+	QVector<Task*> freed;
+	int used;
+};
+
+// Measures loading 100k tasks from a snapshot, clearing them and importing
+// them in bulk, reporting the time, the allocations made and the peak
+// resident memory after each. The peak only ever grows, so each line is the
+// high-water mark up to the end of that step.
+// "legacy/handles" builds the handles to the tasks the way storage used to,
+// with a separate Task and control block per task in a QList, which also
+// allocates a node per element; "memory/handles" is how it is done now.
+// "pooled/handles" makes the tasks in a TaskSlab instead. QSharedPointer
+// still allocates a control block for each task it is given with a deleter,
+// so the slab saves no allocations over QSharedPointer::create(), which
+// already allocates each task together with its control block. The
+// "-release" lines time dropping the handles, as clearing does.
+void runMemoryBenchmarks() {
+	QList<Task> tasks = Benchmark::generateTasks(MEMORY_SIZE, SEED);
+	QString name = "memory-" + QString::number(MEMORY_SIZE);
+	QString iniPath = Benchmark::tempPath(name + ".ini");
+	QString snapshotPath = Benchmark::tempPath(name + ".snapshot");
+	Snapshot::write(snapshotPath, tasks, 0);
+
+	{
+		Storage storage(iniPath);
+		qint64 before = Benchmark::allocations();
+		Benchmark::report("memory/load", MEMORY_SIZE, Benchmark::measure([&]() {
+			storage.loadFile();
+		}));
+		Benchmark::reportCount("memory/load-allocations", MEMORY_SIZE,
+			Benchmark::allocations() - before);
+		Benchmark::reportBytes("memory/load-peak-rss", MEMORY_SIZE,
+			Benchmark::peakMemory());
+
+		before = Benchmark::allocations();
+		Benchmark::report("memory/clear", MEMORY_SIZE, Benchmark::measure([&]() {
+			storage.clearAllTasks();
+		}));
+		Benchmark::reportCount("memory/clear-allocations", MEMORY_SIZE,
+			Benchmark::allocations() - before);
+		Benchmark::reportBytes("memory/clear-peak-rss", MEMORY_SIZE,
+			Benchmark::peakMemory());
+	}
+
+	{
+		BenchmarkStorage storage;
+		qint64 before = Benchmark::allocations();
+		Benchmark::report("memory/import", MEMORY_SIZE, Benchmark::measure([&]() {
+			storage.load(tasks);
+		}));
+		Benchmark::reportCount("memory/import-allocations", MEMORY_SIZE,
+			Benchmark::allocations() - before);
+		Benchmark::reportBytes("memory/import-peak-rss", MEMORY_SIZE,
+			Benchmark::peakMemory());
+	}
+
+	qint64 before = Benchmark::allocations();
+	{
+		QVector< QSharedPointer<Task> > handles;
+		handles.reserve(tasks.size());
+		foreach (const Task& task, tasks) {
+			handles.push_back(QSharedPointer<Task>::create(task));
+		}
+		Benchmark::report("memory/handles-release", MEMORY_SIZE,
+			Benchmark::measure([&]() {
+			handles.clear();
+		}));
+	}
+	Benchmark::reportCount("memory/handles-allocations", MEMORY_SIZE,
+		Benchmark::allocations() - before);
+
+	before = Benchmark::allocations();
+	{
+		TaskSlab slab;
+		QVector< QSharedPointer<Task> > handles;
+		handles.reserve(tasks.size());
+		foreach (const Task& task, tasks) {
+			handles.push_back(slab.make(task));
+		}
+		Benchmark::report("pooled/handles-release", MEMORY_SIZE,
+			Benchmark::measure([&]() {
+			handles.clear();
+		}));
+	}
+	Benchmark::reportCount("pooled/handles-allocations", MEMORY_SIZE,
+		Benchmark::allocations() - before);
+
+	before = Benchmark::allocations();
+	{
+		QList< QSharedPointer<Task> > handles;
+		handles.reserve(tasks.size());
+		foreach (const Task& task, tasks) {
+			handles.push_back(QSharedPointer<Task>(new Task(task)));
+		}
+	}
+	Benchmark::reportCount("legacy/handles-allocations", MEMORY_SIZE,
+		Benchmark::allocations() - before);
+
+	QFile::remove(snapshotPath);
+	QFile::remove(iniPath);
+	QFile::remove(Benchmark::tempPath(name + "-0.journal"));
+}
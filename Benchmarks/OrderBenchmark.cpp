@@ -0,0 +1,78 @@
+//@author A0096863M
+#include "Constants.h"
+#include "Benchmark.h"
+
+static const int ORDER_SIZE = 100000;
+static const int ORDER_OPERATIONS = 1000;
+static const unsigned int SEED = 2103;
+
+// Sorts tasks the way storage used to after every change, with one stable
+// sort per key, from the least important key to the most important.
+static void sortBySixPasses(QList<Task>& tasks) {
+	qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+		return t1.getDescription().toLower() < t2.getDescription().toLower();
+	});
+	qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+		return t1.getEnd() < t2.getEnd();
+	});
+	qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+		return t1.isDueToday() > t2.isDueToday();
+	});
+	qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+		return t1.isOverdue() > t2.isOverdue();
+	});
+	qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+		return t1.getEnd().isValid() && !t2.getEnd().isValid();
+	});
+	qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+		return t1.isDone() < t2.isDone();
+	});
+}
+
+// Measures keeping 100k tasks in display order. "legacy/six-pass-sort" is
+// what every add, edit and remove used to cost. The status searches read the
+// clock once for all the tasks.
+void runOrderBenchmarks() {
+	QList<Task> tasks = Benchmark::generateTasks(ORDER_SIZE, SEED);
+	QList<Task> extra = Benchmark::generateTasks(ORDER_OPERATIONS, SEED + 1);
+	BenchmarkStorage storage;
+
+	Benchmark::report("order/rebuild", ORDER_SIZE, Benchmark::measure([&]() {
+		storage.load(tasks);
+	}));
+
+	Benchmark::report("order/add", ORDER_OPERATIONS, Benchmark::measure([&]() {
+		for (int i=0; i<ORDER_OPERATIONS; i++) {
+			storage.addTask(extra[i]);
+		}
+	}));
+
+	Benchmark::report("order/edit", ORDER_OPERATIONS, Benchmark::measure([&]() {
+		for (int i=0; i<ORDER_OPERATIONS; i++) {
+			int id = (i * 97) % storage.totalTasks();
+			Task task = storage.getTask(id);
+			task.setDone(!task.isDone());
+			storage.editTask(id, task);
+		}
+	}));
+
+	Benchmark::report("order/remove", ORDER_OPERATIONS, Benchmark::measure([&]() {
+		for (int i=0; i<ORDER_OPERATIONS; i++) {
+			storage.removeTask((i * 89) % storage.totalTasks());
+		}
+	}));
+
+	QList<Task> listed = storage.getTasks(false);
+	Benchmark::report("legacy/six-pass-sort", ORDER_SIZE, Benchmark::measure([&]() {
+		FrozenTime frozen;
+		sortBySixPasses(listed);
+	}));
+
+	Benchmark::report("status/search-overdue", ORDER_SIZE, Benchmark::measure([&]() {
+		storage.search(PREDICATE_OVERDUE);
+	}));
+
+	Benchmark::report("status/search-today", ORDER_SIZE, Benchmark::measure([&]() {
+		storage.search(PREDICATE_TODAY);
+	}));
+}
@@ -0,0 +1,48 @@
+//@author A0096863M
+#include <QStringList>
+#include "Benchmark.h"
+
+static const int SEARCH_SIZE = 100000;
+static const int SEARCH_REPEATS = 1000;
+static const int LEGACY_REPEATS = 10;
+static const unsigned int SEED = 2103;
+
+// Measures description and tag searches over 100k tasks, reported per search.
+// "legacy/description-scan" checks every description, like searchByDescription
+// used to.
+void runSearchBenchmarks() {
+	QList<Task> tasks = Benchmark::generateTasks(SEARCH_SIZE, SEED);
+	BenchmarkStorage storage;
+	storage.load(tasks);
+
+	Benchmark::reportBytes("search/description-index-bytes", SEARCH_SIZE,
+		storage.descriptionIndexBytes());
+
+	QStringList keywords;
+	keywords << "of 4242" << "task 17" << "Of";
+	foreach (const QString& keyword, keywords) {
+		Benchmark::report("search/description \"" + keyword + "\"",
+			SEARCH_REPEATS, Benchmark::measure([&]() {
+			for (int i=0; i<SEARCH_REPEATS; i++) {
+				storage.searchByDescription(keyword);
+			}
+		}));
+	}
+
+	Benchmark::report("search/tag \"tag4\"", SEARCH_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<SEARCH_REPEATS; i++) {
+			storage.searchByTag("tag4");
+		}
+	}));
+
+	Benchmark::report("legacy/description-scan \"of 4242\"", LEGACY_REPEATS,
+		Benchmark::measure([&]() {
+		for (int i=0; i<LEGACY_REPEATS; i++) {
+			storage.search([](Task task) -> bool {
+				return task.getDescription().contains("of 4242",
+					Qt::CaseInsensitive);
+			});
+		}
+	}));
+}
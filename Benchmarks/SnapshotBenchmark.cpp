@@ -0,0 +1,63 @@
+//@author A0096863M
+#include <QFile>
+#include "Storage.h"
+#include "Snapshot.h"
+#include "Benchmark.h"
+
+static const int SNAPSHOT_SIZES[] = { 10000, 100000, 1000000 };
+static const int INI_SIZE_LIMIT = 100000;
+static const unsigned int SEED = 2103;
+
+// Compares loading tasks from the binary snapshot with loading them from the
+// .ini file. The .ini file is skipped for the largest list as QSettings takes
+// far too long to parse it.
+void runSnapshotBenchmarks() {
+	foreach (int size, SNAPSHOT_SIZES) {
+		QList<Task> tasks = Benchmark::generateTasks(size, SEED);
+		QString name = QString::number(size);
+		QString iniPath = Benchmark::tempPath(name + ".ini");
+		QString snapshotPath = Benchmark::tempPath(name + ".snapshot");
+
+		Benchmark::report("snapshot/write", size, Benchmark::measure([&]() {
+			Snapshot::write(snapshotPath, tasks, 0);
+		}));
+
+		// only maps the file, no task is built yet
+		Benchmark::report("snapshot/open", size, Benchmark::measure([&]() {
+			Snapshot snapshot;
+			snapshot.open(snapshotPath);
+		}));
+
+		Benchmark::report("snapshot/first-task", size, Benchmark::measure([&]() {
+			Snapshot snapshot;
+			snapshot.open(snapshotPath);
+			snapshot.task(0);
+		}));
+
+		Benchmark::report("snapshot/all-tasks", size, Benchmark::measure([&]() {
+			Snapshot snapshot;
+			snapshot.open(snapshotPath);
+			for (int i=0; i<snapshot.size(); i++) {
+				snapshot.task(i);
+			}
+		}));
+
+		// includes replaying the (empty) journal and renumbering
+		Benchmark::report("storage/load", size, Benchmark::measure([&]() {
+			Storage storage(iniPath);
+			storage.loadFile();
+		}));
+
+		if (size <= INI_SIZE_LIMIT) {
+			Storage::writeIni(iniPath, tasks, 0);
+			Benchmark::report("ini/load", size, Benchmark::measure([&]() {
+				QVector< QSharedPointer<Task> > loaded;
+				Storage::readIni(iniPath, loaded);
+			}));
+		}
+
+		QFile::remove(snapshotPath);
+		QFile::remove(iniPath);
+		QFile::remove(Benchmark::tempPath(name + "-0.journal"));
+	}
+}
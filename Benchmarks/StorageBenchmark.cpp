@@ -0,0 +1,156 @@
+//@author A0096863M
+#include <random>
+#include <QDir>
+#include <QStringList>
+#include "Benchmark.h"
+
+static const int STORAGE_SIZES[] = { 1000, 10000, 100000, 1000000 };
+static const int STORAGE_SIZE_COUNT = 4;
+// Operations run per measurement at each size, so that every measurement
+// costs about the same whatever the number of tasks.
+static const int OPERATION_BUDGET = 10000000;
+static const int MAX_OPERATIONS = 1000;
+static const int MIN_OPERATIONS = 10;
+static const char* const STORAGE_FILE_PATTERN = "tasuke-benchmark-storage*";
+static const unsigned int SEED = 2103;
+
+// Runs operation the given number of times, passing the number of each run,
+// and reports the time and the allocations per run.
+static void measureOperation(QString name, int size, int operations,
+							 std::function<void(int)> operation) {
+	qint64 before = Benchmark::allocations();
+	qint64 nsecs = Benchmark::measure([&]() {
+		for (int i=0; i<operations; i++) {
+			operation(i);
+		}
+	});
+	Benchmark::reportOperation(name, size, operations, nsecs,
+		Benchmark::allocations() - before);
+}
+
+// Measures the operations every storage has on top of size tasks. Each name
+// is prefixed with backend. Tasks are added first and removed last, so that
+// there are still size tasks for the operations in between.
+static void runOperations(QString backend, IStorage& storage, int size) {
+	int operations = qBound(MIN_OPERATIONS, OPERATION_BUDGET / size,
+		MAX_OPERATIONS);
+	QList<Task> added = Benchmark::generateTasks(operations, SEED + 1);
+	std::mt19937 random(SEED);
+	QString prefix = "storage/" + backend + "/";
+
+	measureOperation(prefix + "addTask", size, operations, [&](int i) {
+		storage.addTask(added[i]);
+	});
+
+	measureOperation(prefix + "editTask", size, operations, [&](int i) {
+		int id = random() % storage.totalTasks();
+		Task task = storage.getTask(id);
+		task.setDescription("edited " + QString::number(i));
+		storage.editTask(id, task);
+	});
+
+	measureOperation(prefix + "renumber", size, qMax(1, operations / 10),
+		[&](int) {
+		storage.renumber();
+	});
+
+	measureOperation(prefix + "searchByDescription", size, operations,
+		[&](int i) {
+		storage.searchByDescription("of " + QString::number(i));
+	});
+
+	measureOperation(prefix + "searchByTag", size, operations, [&](int i) {
+		storage.searchByTag("tag" + QString::number(i % 50));
+	});
+
+	measureOperation(prefix + "search(filter)", size, operations, [&](int) {
+		storage.search(TaskTable::DUE_TODAY);
+	});
+
+	measureOperation(prefix + "search(predicate)", size,
+		qMax(1, operations / 10), [&](int) {
+		storage.search([](const Task& task) -> bool {
+			return task.isOverdue();
+		});
+	});
+
+	measureOperation(prefix + "nextFreeTime", size, operations, [&](int) {
+		storage.nextFreeTime();
+	});
+
+	measureOperation(prefix + "removeTask", size, operations, [&](int) {
+		storage.removeTask(random() % storage.totalTasks());
+	});
+}
+
+// Removes the files written by the benchmarks of the real storage.
+static void removeStorageFiles() {
+	QDir dir = QDir::temp();
+	QStringList files = dir.entryList(QStringList(STORAGE_FILE_PATTERN));
+	foreach (const QString& file, files) {
+		dir.remove(file);
+	}
+}
+
+// Measures every storage operation on 1k to 1M generated tasks, both in
+// memory only, like StorageStub, and with the real Storage, which also
+// journals every change. The real Storage additionally reports saveFile()
+// after a single edit, and loadFile() of the whole set. Each line gives the
+// nanoseconds and allocations per operation.
+void runStorageBenchmarks() {
+	for (int s=0; s<STORAGE_SIZE_COUNT; s++) {
+		int size = STORAGE_SIZES[s];
+		QList<Task> tasks = Benchmark::generateTasks(size, SEED);
+
+		{
+			BenchmarkStorage storage;
+			storage.load(tasks);
+			runOperations("memory", storage, size);
+		}
+
+		removeStorageFiles();
+		QString path = Benchmark::tempPath("storage.ini");
+		{
+			Storage storage(path);
+			storage.loadFile();
+			int next = 0;
+			storage.bulkLoad([&](Task& task) -> bool {
+				if (next >= tasks.size()) {
+					return false;
+				}
+				task = tasks[next++];
+				return true;
+			});
+			storage.saveFile();
+			storage.flush();
+
+			runOperations("disk", storage, size);
+
+			int operations = qBound(MIN_OPERATIONS, OPERATION_BUDGET / size,
+				MAX_OPERATIONS);
+			qint64 nsecs = 0;
+			qint64 allocations = 0;
+			for (int i=0; i<operations; i++) {
+				int id = i % storage.totalTasks();
+				Task task = storage.getTask(id);
+				task.setDone(!task.isDone());
+				storage.editTask(id, task);
+
+				qint64 before = Benchmark::allocations();
+				nsecs += Benchmark::measure([&]() {
+					storage.saveFile();
+					storage.flush();
+				});
+				allocations += Benchmark::allocations() - before;
+			}
+			Benchmark::reportOperation("storage/disk/saveFile", size,
+				operations, nsecs, allocations);
+		}
+
+		measureOperation("storage/disk/loadFile", size, 1, [&](int) {
+			Storage loaded(path);
+			loaded.loadFile();
+		});
+		removeStorageFiles();
+	}
+}
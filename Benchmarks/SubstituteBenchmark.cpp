@@ -0,0 +1,132 @@
+//@author A0096863M
+#include <QRegExp>
+#include <QStringList>
+#include "Constants.h"
+#include "DateParser.h"
+#include "Interpreter.h"
+#include "Benchmark.h"
+
+static const int KEYSTROKE_REPEATS = 1000;
+
+// Every text the input box holds while the command is typed one key at a time.
+static QStringList keystrokes(QString typed) {
+	QStringList texts;
+	for (int i=1; i<=typed.size(); i++) {
+		texts << typed.left(i);
+	}
+	return texts;
+}
+
+// The regular expressions substitute() used to run one after another.
+static QList<QRegExp> legacyCommandRegexes(QStringList& replacements) {
+	QList<QRegExp> regexes;
+	foreach (const QString& word, EQUIV_AT_WORDS) {
+		regexes << QRegExp("(?:\\s)" + word + "\\b");
+		replacements << EQUIV_AT_REPLACE;
+	}
+	for (int i=0; i<EQUIV_COMMAND_WORDS.size(); i++) {
+		foreach (const QString& word, EQUIV_COMMAND_WORDS[i]) {
+			regexes << QRegExp("^" + word + "\\b");
+			replacements << COMMANDS[i];
+		}
+	}
+	return regexes;
+}
+
+// The regular expressions substituteForDate() used to run one after another,
+// apart from the weekdays, which it replaced as plain text.
+static QList<QRegExp> legacyDateRegexes(QStringList& replacements) {
+	QList<QRegExp> regexes;
+	regexes << QRegExp(",\\b");
+	replacements << "";
+	foreach (const QString& word, REMOVE_DATE_WORDS) {
+		regexes << QRegExp("\\b" + word + "\\b");
+		replacements << "";
+	}
+	for (int i=0; i<DAY_ABBREVIATIONS.size(); i++) {
+		regexes << QRegExp("\\b" + DAY_ABBREVIATIONS[i] + "\\b");
+		replacements << DAY_ABBREVIATED[i];
+	}
+	for (int i=0; i<DAY_RELATIVE_NAMES.size(); i++) {
+		regexes << QRegExp("\\b" + DAY_RELATIVE_NAMES[i] + "\\b");
+		replacements << QDate::currentDate()
+			.addDays(DAY_RELATIVE_OFFSETS[i]).toString(DATE_FORMAT);
+	}
+	for (int i=0; i<DAY_NAMES.size(); i++) {
+		regexes << QRegExp(DAY_NAMES[i]);
+		replacements << QDate::currentDate()
+			.addDays((i + DAYS_IN_WEEK + 1 - QDate::currentDate().dayOfWeek())
+			% DAYS_IN_WEEK).toString(DATE_FORMAT);
+	}
+	for (int i=0; i<TIME_NAMES.size(); i++) {
+		regexes << QRegExp("\\b" + TIME_NAMES[i] + "\\b");
+		replacements << TIME_NAMED[i];
+	}
+	return regexes;
+}
+
+// Runs the regular expressions over the text in turn.
+static QString legacySubstitute(QString text, const QList<QRegExp>& regexes,
+								const QStringList& replacements) {
+	for (int i=0; i<regexes.size(); i++) {
+		text.replace(regexes[i], replacements[i]);
+	}
+	return text;
+}
+
+// Measures the substitutions made on every keystroke, reported per keystroke
+// over all the prefixes of a typed command. "substitute/keystroke-type" is
+// what getType() costs for the tooltip, and "substitute/keystroke-date" what
+// parseDate() costs on the date being typed. The "legacy/..." lines run the
+// regular expressions in turn instead, like substitute() and
+// substituteForDate() used to.
+void runSubstituteBenchmarks() {
+	QStringList commands = keystrokes(
+		"do buy milk for the trip by next friday, evening #errands");
+	QStringList dates = keystrokes("this fri, day after tomorrow night");
+
+	QStringList commandReplacements;
+	QList<QRegExp> commandRegexes = legacyCommandRegexes(commandReplacements);
+	QStringList dateReplacements;
+	QList<QRegExp> dateRegexes = legacyDateRegexes(dateReplacements);
+	QDate today = QDate::currentDate();
+
+	Benchmark::report("substitute/keystroke-type",
+		commands.size() * KEYSTROKE_REPEATS, Benchmark::measure([&]() {
+		for (int i=0; i<KEYSTROKE_REPEATS; i++) {
+			foreach (const QString& command, commands) {
+				Interpreter::getType(command);
+			}
+		}
+	}));
+
+	Benchmark::report("legacy/keystroke-type-regex",
+		commands.size() * KEYSTROKE_REPEATS, Benchmark::measure([&]() {
+		for (int i=0; i<KEYSTROKE_REPEATS; i++) {
+			foreach (const QString& command, commands) {
+				Interpreter::getType(legacySubstitute(command, commandRegexes,
+					commandReplacements), false);
+			}
+		}
+	}));
+
+	Benchmark::report("substitute/keystroke-date",
+		dates.size() * KEYSTROKE_REPEATS, Benchmark::measure([&]() {
+		for (int i=0; i<KEYSTROKE_REPEATS; i++) {
+			foreach (const QString& date, dates) {
+				Interpreter::parseDate(date);
+			}
+		}
+	}));
+
+	Benchmark::report("legacy/keystroke-date-regex",
+		dates.size() * KEYSTROKE_REPEATS, Benchmark::measure([&]() {
+		for (int i=0; i<KEYSTROKE_REPEATS; i++) {
+			foreach (const QString& date, dates) {
+				QString subbed = legacySubstitute(date.toLower(), dateRegexes,
+					dateReplacements);
+				DateParser::parse(subbed.trimmed(), today);
+			}
+		}
+	}));
+}
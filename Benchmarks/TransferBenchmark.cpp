@@ -0,0 +1,53 @@
+//@author A0096863M
+#include <QFile>
+#include "TaskTransfer.h"
+#include "Benchmark.h"
+
+static const int TRANSFER_SIZE = 1000000;
+static const unsigned int SEED = 2103;
+
+// Exports 1M tasks to a file in the given format and imports them back into
+// an empty storage, reporting both per task along with how many times
+// progress was reported and the peak memory of the process so far.
+static void measureTransfer(QString name, QString fileName,
+							const TaskView& tasks) {
+	QString path = Benchmark::tempPath(fileName);
+	int reports = 0;
+	TaskTransfer::Progress progress = [&reports](qint64 done, qint64 total) {
+		Q_UNUSED(done);
+		Q_UNUSED(total);
+		reports++;
+	};
+
+	Benchmark::report("transfer/export " + name, tasks.size(),
+		Benchmark::measure([&]() {
+		TaskTransfer::exportFile(path, tasks, progress);
+	}));
+	Benchmark::reportBytes("transfer/file " + name, tasks.size(),
+		QFile(path).size());
+
+	BenchmarkStorage storage;
+	int imported = 0;
+	Benchmark::report("transfer/import " + name, tasks.size(),
+		Benchmark::measure([&]() {
+		imported = TaskTransfer::importFile(path, storage, progress);
+	}));
+	Benchmark::reportCount("transfer/imported " + name, tasks.size(),
+		imported);
+	Benchmark::reportCount("transfer/progress-reports " + name, tasks.size(),
+		reports);
+	Benchmark::reportBytes("transfer/peak-memory " + name, tasks.size(),
+		Benchmark::peakMemory());
+
+	QFile::remove(path);
+}
+
+// Measures streaming 1M tasks out to and back in from CSV and JSON Lines.
+void runTransferBenchmarks() {
+	BenchmarkStorage storage;
+	storage.load(Benchmark::generateTasks(TRANSFER_SIZE, SEED));
+	TaskView tasks = storage.view(false);
+
+	measureTransfer("csv", "transfer.csv", tasks);
+	measureTransfer("jsonl", "transfer.jsonl", tasks);
+}
@@ -0,0 +1,38 @@
+//@author A0096863M
+#include <cstdio>
+#include <glog/logging.h>
+#include <QApplication>
+#include "Tasuke.h"
+#include "Benchmark.h"
+
+// The entry point for the benchmarks. Tasuke runs without its GUI, the same
+// way it does in the unit tests. If a path is given, the results are also
+// written there as JSON Lines.
+int main(int argc, char *argv[]) {
+	QApplication app(argc, argv);
+
+	google::InitGoogleLogging(argv[0]);
+	Tasuke::setGuiMode(false);
+	Tasuke::instance();
+
+	if (argc > 1 && !Benchmark::openResults(QString::fromLocal8Bit(argv[1]))) {
+		fprintf(stderr, "Could not write results to %s\n", argv[1]);
+		return 1;
+	}
+
+	runSnapshotBenchmarks();
+	runOrderBenchmarks();
+	runSearchBenchmarks();
+	runFreeTimeBenchmarks();
+	runFilterBenchmarks();
+	runMemoryBenchmarks();
+	runBatchBenchmarks();
+	runBulkBenchmarks();
+	runTransferBenchmarks();
+	runStorageBenchmarks();
+	runDateBenchmarks();
+	runSubstituteBenchmarks();
+
+	Benchmark::closeResults();
+	return 0;
+}
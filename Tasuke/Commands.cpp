@@ -4,7 +4,9 @@
 #include "Tasuke.h"
 #include "Constants.h"
 #include "Commands.h"
+#include "Exceptions.h"
 #include "Interpreter.h"
+#include "TaskTransfer.h"
 
 // Constructor for ICommand
 ICommand::ICommand() {
@@ -43,23 +45,25 @@ void AddCommand::run() {
 	ICommand::run();
 
 	task = Tasuke::instance().getStorage().addTask(task);
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
-	Tasuke::instance().highlightTask(task.getId());
-	Interpreter::setLast(task.getId()+1);
+	Tasuke::instance().refreshTaskWindow();
+	Tasuke::instance().highlightTask(task);
+	Interpreter::setLast(task.getUid());
 }
 
 // Undos adding the task.
 void AddCommand::undo() {
 	ICommand::undo();
 
-	Tasuke::instance().getStorage().removeTask(task.getId());
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().getStorage().removeTaskByUid(task.getUid());
+	Tasuke::instance().refreshTaskWindow();
 }
 
-// Constructor for RemoveCommand. Takes in an id of a task to remove
+// Constructor for RemoveCommand. Takes in an id of a task to remove. The
+// task is remembered by its unique ID, so removing other tasks first does
+// not change which task this removes.
 RemoveCommand::RemoveCommand(int _id) {
-	id = _id;
-	task = Tasuke::instance().getStorage().getTask(id);
+	task = Tasuke::instance().getStorage().getTask(_id);
+	uid = task.getUid();
 }
 
 // Destructor for RemoveCommand..
@@ -71,8 +75,8 @@ RemoveCommand::~RemoveCommand() {
 void RemoveCommand::run() {
 	ICommand::run();
 
-	Tasuke::instance().getStorage().removeTask(id);
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().getStorage().removeTaskByUid(uid);
+	Tasuke::instance().refreshTaskWindow();
 }
 
 // Undoes removing the task
@@ -80,13 +84,13 @@ void RemoveCommand::undo() {
 	ICommand::undo();
 
 	Tasuke::instance().getStorage().addTask(task);
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().refreshTaskWindow();
 }
 
 // Constructor for EditCommand. Takes in an id of a task to replace with the 
-// task given.
-EditCommand::EditCommand(int _id, Task& _task) : id(_id), task(_task) {
-	
+// task given. The task is remembered by its unique ID.
+EditCommand::EditCommand(int _id, Task& _task) : task(_task) {
+	uid = Tasuke::instance().getStorage().getTask(_id).getUid();
 }
 
 // Destructor for EditCommand
@@ -98,21 +102,21 @@ EditCommand::~EditCommand() {
 void EditCommand::run() {
 	ICommand::run();
 
-	old = Tasuke::instance().getStorage().getTask(id);
-	task = Tasuke::instance().getStorage().editTask(id, task);
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
-	Tasuke::instance().highlightTask(task.getId());
-	Interpreter::setLast(task.getId()+1);
+	old = Tasuke::instance().getStorage().getTaskByUid(uid);
+	task = Tasuke::instance().getStorage().editTaskByUid(uid, task);
+	Tasuke::instance().refreshTaskWindow();
+	Tasuke::instance().highlightTask(task);
+	Interpreter::setLast(uid);
 }
 
 // Undos the edit
 void EditCommand::undo() {
 	ICommand::undo();
 
-	Tasuke::instance().getStorage().editTask(task.getId(), old);
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
-	Tasuke::instance().highlightTask(old.getId());
-	Interpreter::setLast(task.getId()+1);
+	old = Tasuke::instance().getStorage().editTaskByUid(uid, old);
+	Tasuke::instance().refreshTaskWindow();
+	Tasuke::instance().highlightTask(old);
+	Interpreter::setLast(uid);
 }
 
 // Constructor for ClearCommand
@@ -131,23 +135,26 @@ void ClearCommand::run() {
 
 	old = QList<Task>(Tasuke::instance().getStorage().getTasks());
 	Tasuke::instance().getStorage().clearAllTasks();
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().refreshTaskWindow();
 }
 
-// Undos clearing all tasks
+// Undos clearing all tasks, adding them back as one batch.
 void ClearCommand::undo() {
 	ICommand::undo();
 
+	Tasuke::instance().beginBatch();
 	for (int i=0; i<old.size(); i++) {
 		Tasuke::instance().getStorage().addTask(old[i]);
 	}
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().refreshTaskWindow();
+	Tasuke::instance().commitBatch();
 }
 
 // Constructor for DoneCommand. Takes in an id of the task to mark and a bool
-// to mark as done or undone. Defaults to done
-DoneCommand::DoneCommand(int _id, bool _done) : id(_id), done(_done) {
-
+// to mark as done or undone. Defaults to done. The task is remembered by its
+// unique ID.
+DoneCommand::DoneCommand(int _id, bool _done) : done(_done) {
+	uid = Tasuke::instance().getStorage().getTask(_id).getUid();
 }
 
 // Desctuctor for DoneCommand.
@@ -159,14 +166,13 @@ DoneCommand::~DoneCommand() {
 void DoneCommand::run() {
 	ICommand::run();
 
-	Task task = Tasuke::instance().getStorage().getTask(id);
+	Task task = Tasuke::instance().getStorage().getTaskByUid(uid);
 	task.setDone(done);
-	task = Tasuke::instance().getStorage().editTask(id, task);
-	id = task.getId();
+	task = Tasuke::instance().getStorage().editTaskByUid(uid, task);
 	QString doneUndone = done ? "done" : "undone";
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().refreshTaskWindow();
 	if (!done) {
-		Tasuke::instance().highlightTask(task.getId());
+		Tasuke::instance().highlightTask(task);
 	}
 }
 
@@ -174,14 +180,13 @@ void DoneCommand::run() {
 void DoneCommand::undo() {
 	ICommand::undo();
 
-	Task task = Tasuke::instance().getStorage().getTask(id);
+	Task task = Tasuke::instance().getStorage().getTaskByUid(uid);
 	task.setDone(!done);
-	task = Tasuke::instance().getStorage().editTask(id, task);
-	id = task.getId();
+	task = Tasuke::instance().getStorage().editTaskByUid(uid, task);
 	QString doneUndone = done ? "done" : "undone";
-	Tasuke::instance().updateTaskWindow(Tasuke::instance().getStorage().getTasks());
+	Tasuke::instance().refreshTaskWindow();
 	if (!done) {
-		Tasuke::instance().highlightTask(task.getId());
+		Tasuke::instance().highlightTask(task);
 	}
 }
 
@@ -196,21 +201,149 @@ CompositeCommand::~CompositeCommand() {
 	
 }
 
-// Runs all the ICommands in the order given in the constructor.
+// Runs all the ICommands in the order given in the constructor. They are
+// run as one batch, so the tasks are renumbered and redrawn only once.
 void CompositeCommand::run() {
 	ICommand::run();
 
+	Tasuke::instance().beginBatch();
 	foreach(QSharedPointer<ICommand> command, commands) {
 		command->run();
 	}
+	Tasuke::instance().commitBatch();
 }
 
-// Undos all the ICommands in the reverse order given in the constructor.
+// Undos all the ICommands in the reverse order given in the constructor, as
+// one batch.
 void CompositeCommand::undo() {
 	ICommand::undo();
 
 	// must be in reverse order
+	Tasuke::instance().beginBatch();
 	for(int i=commands.size()-1; i>=0; i--) {
 		commands[i]->undo();
 	}
+	Tasuke::instance().commitBatch();
+}
+
+// Constructor for BulkCommand. Takes in the selector that picks the tasks.
+BulkCommand::BulkCommand(TaskSelector _selector) : selector(_selector) {
+	selected = false;
+}
+
+// Destructor for BulkCommand.
+BulkCommand::~BulkCommand() {
+
+}
+
+// Returns the unique IDs of the tasks picked by the selector, running it
+// only the first time.
+const QVector<quint64>& BulkCommand::selection() {
+	if (!selected) {
+		uids = selector();
+		selected = true;
+	}
+	return uids;
+}
+
+// Constructor for RemoveWhereCommand. Takes in the selector that picks the
+// tasks to remove.
+RemoveWhereCommand::RemoveWhereCommand(TaskSelector _selector)
+	: BulkCommand(_selector) {
+
+}
+
+// Destructor for RemoveWhereCommand.
+RemoveWhereCommand::~RemoveWhereCommand() {
+
+}
+
+// Removes all the selected tasks at once, keeping them for undo.
+void RemoveWhereCommand::run() {
+	ICommand::run();
+
+	removed = Tasuke::instance().getStorage().removeTasksByUid(selection());
+	Tasuke::instance().refreshTaskWindow();
+}
+
+// Undoes removing the tasks by adding them all back at once.
+void RemoveWhereCommand::undo() {
+	ICommand::undo();
+
+	Tasuke::instance().getStorage().addTasks(removed);
+	removed.clear();
+	Tasuke::instance().refreshTaskWindow();
+}
+
+// Constructor for EditWhereCommand. Takes in the selector that picks the
+// tasks to edit and the change to make to each of them.
+EditWhereCommand::EditWhereCommand(TaskSelector _selector,
+								   std::function<void(Task&)> _change)
+	: BulkCommand(_selector), change(_change) {
+
+}
+
+// Destructor for EditWhereCommand.
+EditWhereCommand::~EditWhereCommand() {
+
+}
+
+// Changes all the selected tasks at once, keeping the ones that changed as
+// they were for undo.
+void EditWhereCommand::run() {
+	ICommand::run();
+
+	old = Tasuke::instance().getStorage().editTasksByUid(selection(), change);
+	Tasuke::instance().refreshTaskWindow();
+}
+
+// Undoes the change by putting back the tasks as they were at once.
+void EditWhereCommand::undo() {
+	ICommand::undo();
+
+	Tasuke::instance().getStorage().replaceTasks(old);
+	old.clear();
+	Tasuke::instance().refreshTaskWindow();
+}
+// Constructor for ImportCommand. Takes in the path of the file to import.
+ImportCommand::ImportCommand(QString _path) : path(_path) {
+	imported = false;
+}
+
+// Destructor for ImportCommand.
+ImportCommand::~ImportCommand() {
+
+}
+
+// Adds the tasks in the file in one bulk load the first time, and adds back
+// the same tasks after an undo.
+// throws ExceptionBadCommand if the file cannot be read
+void ImportCommand::run() {
+	ICommand::run();
+
+	if (imported) {
+		Tasuke::instance().getStorage().addTasks(removed);
+		removed.clear();
+		Tasuke::instance().refreshTaskWindow();
+		return;
+	}
+
+	int count = TaskTransfer::importFile(path,
+		Tasuke::instance().getStorage(), TaskTransfer::Progress(), &uids);
+	if (count < 0) {
+		throw ExceptionBadCommand(ERROR_CANT_READ(path), WHERE_PATH);
+	}
+	imported = true;
+
+	Tasuke::instance().refreshTaskWindow();
+	Tasuke::instance().showMessage(MSG_TRANSFER_IMPORTED(count));
+}
+
+// Undoes the import by removing the imported tasks at once, keeping them for
+// redo.
+void ImportCommand::undo() {
+	ICommand::undo();
+
+	removed = Tasuke::instance().getStorage().removeTasksByUid(uids);
+	Tasuke::instance().refreshTaskWindow();
 }
\ No newline at end of file
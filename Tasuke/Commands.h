@@ -3,6 +3,8 @@
 #ifndef COMMANDS_H
 #define COMMANDS_H
 
+#include <functional>
+#include <QVector>
 #include "Task.h"
 
 // This is an interface for all user commands. The intended method to intialize
@@ -33,7 +35,7 @@ public:
 // This command removes a task from storage.
 class RemoveCommand : public ICommand {
 private:
-	int id;
+	quint64 uid;
 	Task task;
 public:
 	RemoveCommand(int _id);
@@ -46,7 +48,7 @@ public:
 // This command edits a task in storage.
 class EditCommand : public ICommand {
 private:
-	int id;
+	quint64 uid;
 	Task old;
 	Task task;
 public:
@@ -72,7 +74,7 @@ public:
 // This command marks a task in storage as done/undone
 class DoneCommand : public ICommand {
 private:
-	int id;
+	quint64 uid;
 	bool done;
 public:
 	DoneCommand(int _id, bool _done = true);
@@ -94,4 +96,64 @@ public:
 	void undo() override;
 };
 
+// Picks the unique IDs of the tasks that a bulk command applies to.
+typedef std::function<QVector<quint64>()> TaskSelector;
+
+// This is a base for commands that apply to every task picked by a selector.
+// The selector only runs the first time the command is run, so redoing the
+// command applies to the same tasks.
+class BulkCommand : public ICommand {
+private:
+	TaskSelector selector;
+	QVector<quint64> uids;
+	bool selected;
+protected:
+	const QVector<quint64>& selection();
+public:
+	BulkCommand(TaskSelector _selector);
+	~BulkCommand();
+};
+
+// This command removes every task picked by a selector in one pass
+class RemoveWhereCommand : public BulkCommand {
+private:
+	QList<Task> removed;
+public:
+	RemoveWhereCommand(TaskSelector _selector);
+	~RemoveWhereCommand();
+
+	void run() override;
+	void undo() override;
+};
+
+// This command changes every task picked by a selector in one pass
+class EditWhereCommand : public BulkCommand {
+private:
+	std::function<void(Task&)> change;
+	QList<Task> old;
+public:
+	EditWhereCommand(TaskSelector _selector, std::function<void(Task&)> _change);
+	~EditWhereCommand();
+
+	void run() override;
+	void undo() override;
+};
+
+// This command adds every task in a CSV or JSON Lines file in one bulk load.
+// The file is only read the first time the command is run, so redoing the
+// command adds back the same tasks.
+class ImportCommand : public ICommand {
+private:
+	QString path;
+	QVector<quint64> uids;
+	QList<Task> removed;
+	bool imported;
+public:
+	ImportCommand(QString _path);
+	~ImportCommand();
+
+	void run() override;
+	void undo() override;
+};
+
 #endif
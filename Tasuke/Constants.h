@@ -3,11 +3,14 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include <limits>
 #include <QStringList>
+#include <QDataStream>
 #include <QList>
 #include <QTime>
 #include <QDate>
 #include "Task.h"
+#include "TaskTable.h"
 
 // General app metadata
 const char* const TASUKE = "Tasuke";
@@ -56,6 +59,12 @@ enum class Theme : char {
 	THEME_LAST_ITEM
 };
 
+enum class DurabilityPolicy : char {
+	IMMEDIATE,
+	INTERVAL,
+	IDLE
+};
+
 enum class IconSet : char {
 	NYANSUKE,
 	SYMBOLS,
@@ -101,6 +110,7 @@ const char* const MSG_TASUKE_UNDO = "Undoing command";
 const char* const MSG_TASUKE_NO_UNDO ="Nothing to undo";
 const char* const MSG_TASUKE_REDO = "Redoing command";
 const char* const MSG_TASUKE_NO_REDO = "Nothing to redo";
+const char* const MSG_TASUKE_REUSING_DRY_RUN = "Reusing the command built by the dry run";
 
 #define MSG_TASUKE_ERROR_PARSING(message) \
 	"Error parsing command" << QString(message).toStdString()
@@ -132,6 +142,12 @@ const char* const MSG_SYSTEMTRAYWIDGET_DESTROYED = "SystemTrayWidget destroyed";
 const char* const MSG_STORAGE_ADDING_TASK = "Adding task ";
 const char* const MSG_STORAGE_REPLACING_TASK = "Replacing task ";
 const char* const MSG_STORAGE_REMOVING_TASK = "Removing task with ID ";
+const char* const MSG_STORAGE_REMOVING_TASK_BY_UID = 
+	"Removing task with unique ID ";
+const char* const MSG_STORAGE_ADDING_TASKS = "Adding tasks: ";
+const char* const MSG_STORAGE_REPLACING_TASKS = "Replacing tasks: ";
+const char* const MSG_STORAGE_REMOVING_TASKS = "Removing tasks: ";
+const char* const MSG_STORAGE_BULK_LOADED = "Bulk loaded tasks: ";
 const char* const MSG_STORAGE_POP_TASK = "Popping task from the back.";
 const char* const MSG_STORAGE_RETRIEVE_NEXT_TASK = 
 	"Retrieving the next upcoming task.";
@@ -140,19 +156,14 @@ const char* const MSG_STORAGE_SEARCH_BY_DESCRIPTION =
 	"Searching for tasks in description for keyword ";
 const char* const MSG_STORAGE_SEARCH_BY_TAG = 
 	"Searching for tasks in tags for keyword ";
+const char* const MSG_STORAGE_DESCRIPTION_INDEX = 
+	"Description index built. Trigrams, postings and approximate bytes: ";
 const char* const MSG_STORAGE_NEXT_FREE_TIME = 
 	"Searching for the next free time.";
-const char* const MSG_STORAGE_SORT_BY_END_DATE = "Sorting by end date.";
-const char* const MSG_STORAGE_SORT_BY_BEGIN_DATE = "Sorting by begin date.";
-const char* const MSG_STORAGE_SORT_BY_DESCRIPTION = "Sorting by description.";
-const char* const MSG_STORAGE_SORT_BY_ONGOING_STATUS = 
-	"Sorting by ongoing status.";
-const char* const MSG_STORAGE_SORT_BY_DUE_TODAY = 
-	"Sorting by whether or not task is due today.";
-const char* const MSG_STORAGE_SORT_BY_OVERDUE = "Sorting by overdue status.";
-const char* const MSG_STORAGE_SORT_BY_DONE_STATUS = "Sorting by done status.";
-const char* const MSG_STORAGE_SORT_BY_HAS_END_DATE = 
-	"Sorting by existence of an end date.";
+const char* const MSG_STORAGE_NEXT_FREE_SLOT = 
+	"Searching for the next free slot of milliseconds: ";
+const char* const MSG_STORAGE_FINDING_FREE_SLOTS = 
+	"Searching for free slots in ";
 const char* const MSG_STORAGE_CLEAR_ALL_DONE_TASKS = 
 	"Clearing all tasks marked as done.";
 const char* const MSG_STORAGE_CLEAR_ALL_TASKS = 
@@ -164,9 +175,116 @@ const char* const MSG_STORAGE_INSTANCE_CREATED_NONDEFAULT =
 const char* const MSG_STORAGE_LOAD_FILE_START = "Loading file...";
 const char* const MSG_STORAGE_LOAD_FILE_END = "File loaded.";
 const char* const MSG_STORAGE_SAVE_FILE_START = "Saving file...";
-const char* const MSG_STORAGE_SAVE_FILE_END = "File saved.";
+const char* const MSG_STORAGE_SAVE_FILE_END = "File save scheduled.";
+const char* const MSG_STORAGE_WRITE_START = "Writing changes to disk...";
+const char* const MSG_STORAGE_WRITE_END = "Changes written to disk.";
 const char* const MSG_STORAGE_FREE_NOW = "You have no ongoing events at the moment.";
 const char* const MSG_STORAGE_FREE_IN = "You will be free in ";
+const char* const MSG_FREE_SLOT_AT = "Your next free slot starts ";
+const char* const MSG_FREE_SLOTS = "You are free ";
+const char* const MSG_NO_FREE_SLOTS = 
+	"You have no free time long enough in that period.";
+const char* const FORMAT_FREE_SLOT = "ddd d MMM h:mm ap";
+const char* const DELIMITER_FREE_SLOT = " to ";
+const char* const DELIMITER_FREE_SLOTS = ", ";
+const char* const MSG_STORAGE_COMPACTING_JOURNAL = 
+	"Compacting journal into a new snapshot.";
+const char* const MSG_STORAGE_SNAPSHOT_FAILED = "Could not write snapshot to ";
+const char* const MSG_STORAGE_UPGRADING = 
+	"Upgrading saved tasks to the current format.";
+const char* const MSG_STORAGE_ARCHIVING = "Archiving old done tasks: ";
+const char* const MSG_STORAGE_ARCHIVE_FAILED = "Could not write archive to ";
+const char* const MSG_STORAGE_LOADING_ARCHIVE = "Reading archived tasks: ";
+const char* const MSG_STORAGE_UNARCHIVING_TASK = "Bringing back archived task: ";
+const char* const MSG_STORAGE_DROPPING_UNARCHIVED = "Dropping tasks brought back from the archive: ";
+const char* const MSG_STORAGE_EXPORTING = "Exporting tasks to ";
+const char* const MSG_STORAGE_EXPORT_FAILED = "Could not export tasks to ";
+const char* const MSG_STORAGE_RELOADING = 
+	"Saved tasks were changed outside Tasuke, reloading.";
+const char* const MSG_STORAGE_RELOADED = "Tasks changed on disk: ";
+const char* const MSG_STORAGE_RELOAD_RETRY = 
+	"Tasks changed while they were reloaded, reloading again.";
+const char* const MSG_STORAGE_INI_NEWER = 
+	"The .ini file is newer than the snapshot, importing it: ";
+
+// Log messages for Snapshot class
+const char* const MSG_SNAPSHOT_BAD_HEADER = 
+	"Ignoring snapshot with unknown header: ";
+const char* const MSG_SNAPSHOT_TRUNCATED = 
+	"Ignoring snapshot with an unexpected size: ";
+const char* const MSG_SNAPSHOT_MAP_FAILED = "Could not memory map snapshot: ";
+
+// Log messages for PersistenceWorker class
+const char* const MSG_PERSISTENCE_FLUSH = "Flushing pending writes to disk.";
+
+// Log messages for Journal class
+const char* const MSG_JOURNAL_WRITE_FAILED = "Could not write to journal: ";
+const char* const MSG_JOURNAL_BAD_HEADER = 
+	"Ignoring journal with unknown header: ";
+const char* const MSG_JOURNAL_TRUNCATED = 
+	"Journal ends with an incomplete record: ";
+const char* const MSG_JOURNAL_UNKNOWN_RECORD = 
+	"Skipping journal record of unknown type ";
+const char* const MSG_JOURNAL_REPLAYED = "Journal records replayed: ";
+
+// Journal file format
+const quint32 JOURNAL_MAGIC = 0x5441534A;
+const quint16 JOURNAL_VERSION = 2;
+// Version 1 journals identify tasks by their content instead of unique ID
+const quint16 JOURNAL_VERSION_WITHOUT_UIDS = 1;
+const QDataStream::Version JOURNAL_STREAM_VERSION = QDataStream::Qt_5_0;
+const char* const JOURNAL_EXTENSION = ".journal";
+const char* const SNAPSHOT_TEMP_SUFFIX = ".tmp";
+
+// Number of records after which the journal is compacted into the snapshot
+static const int JOURNAL_COMPACTION_THRESHOLD = 256;
+
+// Milliseconds the persistence worker waits to coalesce writes, for the
+// INTERVAL and IDLE durability policies
+static const int DURABILITY_INTERVAL_DEFAULT = 1000;
+
+// Milliseconds to wait after the saved tasks change on disk before they are
+// reloaded, so that a sync tool can finish writing every file first
+static const int RELOAD_DELAY = 500;
+
+// Binary snapshot file format
+const quint32 SNAPSHOT_MAGIC = 0x5441534B;
+const quint16 SNAPSHOT_VERSION = 2;
+// Version 1 snapshots have shorter records without unique IDs
+const quint16 SNAPSHOT_VERSION_WITHOUT_UIDS = 1;
+const char* const SNAPSHOT_EXTENSION = ".snapshot";
+// The archive of old done tasks is written in the snapshot format
+const char* const ARCHIVE_EXTENSION = ".archive";
+// Days after which done tasks are archived by default. 0 turns it off.
+static const int ARCHIVE_AGE_DEFAULT = 30;
+const qint64 SNAPSHOT_NO_TIME = std::numeric_limits<qint64>::min();
+static const int SNAPSHOT_HEADER_SIZE = 32;
+static const int SNAPSHOT_RECORD_SIZE = 40;
+static const int SNAPSHOT_RECORD_SIZE_WITHOUT_UIDS = 32;
+
+// Log messages for TaskTransfer class
+const char* const MSG_TRANSFER_IMPORTING = "Importing tasks from ";
+const char* const MSG_TRANSFER_EXPORTING = "Exporting tasks to ";
+const char* const MSG_TRANSFER_OPEN_FAILED = "Could not open for transfer: ";
+const char* const MSG_TRANSFER_SKIPPED = "Skipped unreadable rows: ";
+#define MSG_TRANSFER_IMPORTED(count) \
+	QString("Imported %1 task(s).").arg(count)
+#define MSG_TRANSFER_EXPORTED(count, path) \
+	QString("Exported %1 task(s) to %2.").arg(QString::number(count), path)
+
+// CSV and JSON Lines transfer formats
+const char* const TRANSFER_CSV_HEADER = "description,begin,end,done,tags";
+const char* const TRANSFER_JSONL_EXTENSION = "jsonl";
+const char* const TRANSFER_KEY_DESCRIPTION = "description";
+const char* const TRANSFER_KEY_BEGIN = "begin";
+const char* const TRANSFER_KEY_END = "end";
+const char* const TRANSFER_KEY_DONE = "done";
+const char* const TRANSFER_KEY_TAGS = "tags";
+static const int TRANSFER_CSV_FIELDS = 5;
+// Rows between progress reports
+static const int TRANSFER_PROGRESS_INTERVAL = 4096;
+// Bytes of output collected before each write to the file
+static const int TRANSFER_BUFFER_SIZE = 1 << 16;
 
 const char* const MSG_STORAGESTUB_INSTANCE_CREATED = 
 	"StorageStub created destroyed";
@@ -250,17 +368,20 @@ const char* const COMMAND_ABOUT = "about";
 const char* const COMMAND_NEXT = "next";
 const char* const COMMAND_SETTINGS = "settings";
 const char* const COMMAND_EXIT = "exit";
+const char* const COMMAND_RETAG = "retag";
+const char* const COMMAND_IMPORT = "import";
+const char* const COMMAND_EXPORT = "export";
 
 // List of command keywords
 const QStringList COMMANDS = QStringList() << COMMAND_ADD << COMMAND_EDIT
 	<< COMMAND_REMOVE << COMMAND_SHOW << COMMAND_HIDE << COMMAND_DONE
 	<< COMMAND_UNDONE << COMMAND_UNDO << COMMAND_REDO << COMMAND_CLEAR
 	<< COMMAND_HELP << COMMAND_ABOUT << COMMAND_NEXT << COMMAND_SETTINGS
-	<< COMMAND_EXIT;
+	<< COMMAND_EXIT << COMMAND_RETAG << COMMAND_IMPORT << COMMAND_EXPORT;
 
 // Command formats
 const char* const FORMAT_ALL = "add | edit | done | undone | remove "
-	"| show | undo | redo | settings | help | exit";
+	"| retag | show | undo | redo | import | export | settings | help | exit";
 const char* const FORMAT_ADD =
 	"add {description}[my task]{/description} {tag}#tag{/tag}";
 const char* const FORMAT_ADD_PERIOD = 
@@ -271,16 +392,19 @@ const char* const FORMAT_ADD_DEADLINE =
 	"{/date} {tag}#tag{/tag}";
 const char* const FORMAT_REMOVE = 
 	"remove {id}[task no]{/id} | remove [task no], [task no], ... | "
-	"remove [task no] - [task no]";
+	"remove [task no] - [task no] | remove where {condition}#tag | done | "
+	"overdue | ...{/condition}";
 const char* const FORMAT_EDIT = 
 	"edit {id}[task no]{/id} {description}[thing to change] "
 	"-[thing to remove]{/description}";
 const char* const FORMAT_DONE = 
 	"done {id}[task no]{/id} | done [task no], [task no], ... | "
-	"done [task no] - [task no]";
+	"done [task no] - [task no] | done where {condition}#tag | overdue | "
+	"today | ...{/condition}";
 const char* const FORMAT_UNDONE = 
 	"undone {id}[task no]{/id} | undone [task no], [task no], ... | "
-	"undone [task no] - [task no]";
+	"undone [task no] - [task no] | undone where {condition}#tag | done | "
+	"...{/condition}";
 const char* const FORMAT_SHOW = 
 	"show [keyword] | done | undone | overdue | ongoing | today | tomorrow";
 const char* const FORMAT_HIDE = "hide";
@@ -288,10 +412,15 @@ const char* const FORMAT_UNDO = "undo {times}[times]{/times} | max";
 const char* const FORMAT_REDO = "redo {times}[times]{/times} | max";
 const char* const FORMAT_CLEAR = "clear";
 const char* const FORMAT_HELP = "help";
-const char* const FORMAT_NEXT = "next";
+const char* const FORMAT_NEXT = 
+	"next {duration}for [duration]{/duration} | next for [duration] "
+	"from {date}{begin}[start]{/begin} to {end}[end]{/end}{/date}";
 const char* const FORMAT_SETTINGS = "settings";
 const char* const FORMAT_ABOUT = "about";
 const char* const FORMAT_EXIT = "exit";
+const char* const FORMAT_RETAG = "retag {tag}#[old tag] to #[new tag]{/tag}";
+const char* const FORMAT_IMPORT = "import {path}[file.csv] | [file.jsonl]{/path}";
+const char* const FORMAT_EXPORT = "export {path}[file.csv] | [file.jsonl]{/path}";
 
 // Command descriptions
 const char* const DESCRIPTION_ALL = "Use one of these keywords to begin";
@@ -308,15 +437,23 @@ const char* const DESCRIPTION_UNDO = "Undos your last command(s).";
 const char* const DESCRIPTION_REDO = "Redos your last command(s).";
 const char* const DESCRIPTION_CLEAR = "Clears all tasks in your list.";
 const char* const DESCRIPTION_HELP = "Shows the tutorial.";
-const char* const DESCRIPTION_NEXT = "Shows the next free time.";
+const char* const DESCRIPTION_NEXT = 
+	"Shows the next free time, or free slots in a time period.";
 const char* const DESCRIPTION_SETTINGS = "Open the settings window.";
 const char* const DESCRIPTION_ABOUT = "Shows about Tasuke.";
 const char* const DESCRIPTION_EXIT = "Exits the program.";
+const char* const DESCRIPTION_RETAG = "Renames a tag on all tasks.";
+const char* const DESCRIPTION_IMPORT = "Adds the tasks in a CSV or JSON Lines file.";
+const char* const DESCRIPTION_EXPORT = "Saves all tasks to a CSV or JSON Lines file.";
 
 // Some command regex
 const QRegExp ADD_DEADLINE_REGEX = QRegExp("\\b(by|at|on)\\b");
 const QRegExp ADD_PREIOD_REGEX = QRegExp("\\bfrom\\b");
+const QRegExp WHERE_REGEX = QRegExp("^where\\b");
+const QRegExp RETAG_REGEX = QRegExp("^#(\\S+)\\s+(?:to\\s+)?#(\\S+)$");
 const QRegExp BRACE_REGEX = QRegExp("\\{(.*)\\}");
+const QRegExp DURATION_REGEX = QRegExp("(\\d+)\\s*(minutes|minute|mins|min|m|"
+	"hours|hour|hrs|hr|h|days|day|d)\\b", Qt::CaseInsensitive);
 
 // HTML markup for tooltip widget
 const char* const HTML_ERROR_BEGIN = "<font color='#FA7597'>";
@@ -356,6 +493,9 @@ const char* const KEYWORD_EVERYTHING = "everything";
 const char* const KEYWORD_MAX = "max";
 const char* const KEYWORD_LAST = "last";
 const char* const KEYWORD_BACKSLASH = "\\";
+const char* const KEYWORD_FOR = "for";
+const char* const KEYWORD_WHERE = "where";
+const char CHAR_QUOTE = '"';
 
 // Titles for task view
 const char* const TITLE_DONE = "done tasks";
@@ -365,24 +505,14 @@ const char* const TITLE_OVERDUE = "overdue tasks";
 const char* const TITLE_TODAY = "tasks due today";
 const char* const TITLE_TOMORROW = "tasks due tomorrow";
 
-const auto PREDICATE_DONE = [](Task task) -> bool {
-	return task.isDone();
-};
-const auto PREDICATE_UNDONE = [](Task task) -> bool {
-	return !task.isDone();
-};
-const auto PREDICATE_ONGOING = [](Task task) -> bool {
-	return task.isOngoing();
-};
-const auto PREDICATE_OVERDUE = [](Task task) -> bool {
-	return task.isOverdue();
-};
-const auto PREDICATE_TODAY = [](Task task) -> bool {
-	return task.isDueToday();
-};
-const auto PREDICATE_TOMORROW = [](Task task) -> bool {
-	return task.isDueTomorrow();
-};
+// Filters for the special task views. These run over the columns of the
+// TaskTable rather than task by task.
+const TaskTable::Filter PREDICATE_DONE = TaskTable::DONE;
+const TaskTable::Filter PREDICATE_UNDONE = TaskTable::UNDONE;
+const TaskTable::Filter PREDICATE_ONGOING = TaskTable::ONGOING;
+const TaskTable::Filter PREDICATE_OVERDUE = TaskTable::OVERDUE;
+const TaskTable::Filter PREDICATE_TODAY = TaskTable::DUE_TODAY;
+const TaskTable::Filter PREDICATE_TOMORROW = TaskTable::DUE_TOMORROW;
 
 // Error descriptions
 const char* const ERROR_MULTIPLE_DATES =
@@ -403,8 +533,11 @@ const char* const ERROR_DONE_NO_ID =
 	"You need to tell me what to mark as done.";
 const char* const ERROR_UNDONE_NO_ID = 
 	"You need to tell me what to mark as undone.";
+const char* const ERROR_RETAG_NO_TAGS =
+	"You need to tell me which tag to rename, and what to.";
 const char* const ERROR_NO_LAST = "There is no last task.";
 const char* const ERROR_NO_ID = "You need to give me a task number.";
+const char* const ERROR_NO_PATH = "You need to give me a file.";
 const char* const ERROR_DATE_BEGIN =
 	"Please give me a valid start time for this task.";
 const char* const ERROR_DATE_END = 
@@ -424,10 +557,18 @@ const char* const ERROR_DATE_END =
 	QString("There is no task '%1'." \
 	"Please give a number between 1 and %2.")\
 	.arg(QString::number(id), QString::number(numTasks))
+#define ERROR_WHERE_UNKNOWN(condition) \
+	QString("I can't pick tasks by '%1'.").arg(condition)
 #define ERROR_NOT_A_NUMBER(number) \
 	QString("'%1' doesn't look like a number.").arg(number)
 #define ERROR_DONT_KNOW(what) \
 	QString("I don't know what to do for '%1'").arg(what)
+#define ERROR_NOT_A_DURATION(duration) \
+	QString("'%1' doesn't look like a duration.").arg(duration)
+#define ERROR_CANT_READ(path) \
+	QString("I can't read tasks from '%1'.").arg(path)
+#define ERROR_CANT_WRITE(path) \
+	QString("I can't write tasks to '%1'.").arg(path)
 
 const char* const EXCEPTION_NULL_PTR = "attempt to dereference null pointer";
 const char* const EXCEPTION_NOT_IMPLEMENTED = "not implemented";
@@ -440,59 +581,34 @@ const char* const WHERE_DATE = "date";
 const char* const WHERE_TAG = "tag";
 const char* const WHERE_DESCRIPTION = "description";
 const char* const WHERE_ID = "id";
+const char* const WHERE_CONDITION = "condition";
 const char* const WHERE_TIMES = "times";
 const char* const WHERE_BEGIN = "begin";
 const char* const WHERE_END = "end";
+const char* const WHERE_DURATION = "duration";
+const char* const WHERE_PATH = "path";
 
 // Time constants
 const QTime TIME_BEFORE_MIDNIGHT = QTime(23,59);
 const QTime TIME_MIDNIGHT = QTime(0,0);
 const char* const TIME_AM = "am";
 const char* const TIME_PM = "pm";
+const char* const TIME_HRS = "hrs";
 const char* const TIME_FORMAT = "hh:mm ap";
 const int YEARS_MILIENIUM = 2000;
 const int YEARS_CENTURY = 100;
 const char* const DATE_FORMAT = "dd/MM/yyyy";
 
-// Regex for removing things when parsing dates
-const QList<QRegExp> REMOVE_DATE_REGEX = QList<QRegExp>() 
-	<< QRegExp(",\\b") << QRegExp("\\bthis\\b") << QRegExp("\\bnext\\b")
-	<< QRegExp("\\bnthe\\b");
-
-// Regex to match named days
-const QRegExp DAY_2DAY_REGEX = QRegExp("\\b2day\\b");
-const QRegExp DAY_TMR_REGEX = QRegExp("\\btmr\\b");
-const QRegExp DAY_TML_REGEX = QRegExp("\\btml\\b");
-const QRegExp DAY_MON_REGEX = QRegExp("\\bmon\\b");
-const QRegExp DAY_TUE_REGEX = QRegExp("\\btue\\b");
-const QRegExp DAY_TUES_REGEX = QRegExp("\\btues\\b");
-const QRegExp DAY_WED_REGEX = QRegExp("\\bwed\\b");
-const QRegExp DAY_THU_REGEX = QRegExp("\\bthu\\b");
-const QRegExp DAY_THUR_REGEX = QRegExp("\\bthur\\b");
-const QRegExp DAY_THURS_REGEX = QRegExp("\\bthurs\\b");
-const QRegExp DAY_FRI_REGEX = QRegExp("\\bfri\\b");
-const QRegExp DAY_SAT_REGEX = QRegExp("\\bsat\\b");
-const QRegExp DAY_SUN_REGEX = QRegExp("\\bsun\\b");
-
-// Regex to match special days
-const QRegExp DAY_YESTERDAY_REGEX = QRegExp("\\byesterday\\b");
-const QRegExp DAY_TODAY_REGEX = QRegExp("\\btoday\\b");
-const QRegExp DAY_TOMORROW_REGEX = QRegExp("\\btomorrow\\b");
-const QRegExp DAY_AFTER_TOMORROW_REGEX = QRegExp("\\bday after tomorrow\\b");
-
-// Macros for special days that relative to current time
-#define DATE_YESTERDAY \
-	QDate::currentDate().addDays(-1).toString(DATE_FORMAT)
-#define DATE_TODAY \
-	QDate::currentDate().toString(DATE_FORMAT)
-#define DATE_TOMORROW \
-	QDate::currentDate().addDays(1).toString(DATE_FORMAT)
-#define DATE_AFTER_TOMORROW \
-	QDate::currentDate().addDays(2).toString(DATE_FORMAT)
+// Words removed when parsing dates, and commas right before a word
+const QStringList REMOVE_DATE_WORDS = QStringList() << "this" << "next"
+	<< "nthe";
+const char CHAR_COMMA = ',';
 
 // Names of days
+const char* const DAY_YESTERDAY = "yesterday";
 const char* const DAY_TODAY = "today";
 const char* const DAY_TOMORROW = "tomorrow";
+const char* const DAY_AFTER_TOMORROW = "day after tomorrow";
 const char* const DAY_MONDAY = "monday";
 const char* const DAY_TUESDAY = "tuesday";
 const char* const DAY_WEDNESDAY = "wednesday";
@@ -506,12 +622,24 @@ const QStringList DAY_NAMES = QStringList() << DAY_MONDAY << DAY_TUESDAY
 	<< DAY_WEDNESDAY << DAY_THURSDAY << DAY_FRIDAY << DAY_SATURDAY
 	<< DAY_SUNDAY;
 
+// List of names of days relative to today, and how many days after today
+// each is
+const QStringList DAY_RELATIVE_NAMES = QStringList() << DAY_YESTERDAY
+	<< DAY_TODAY << DAY_TOMORROW << DAY_AFTER_TOMORROW;
+const QList<int> DAY_RELATIVE_OFFSETS = QList<int>() << -1 << 0 << 1 << 2;
+
+// List of abbreviations of days, and the names they stand for
+const QStringList DAY_ABBREVIATIONS = QStringList() << "2day" << "tmr"
+	<< "tml" << "mon" << "tue" << "tues" << "wed" << "thu" << "thur"
+	<< "thurs" << "fri" << "sat" << "sun";
+const QStringList DAY_ABBREVIATED = QStringList() << DAY_TODAY
+	<< DAY_TOMORROW << DAY_TOMORROW << DAY_MONDAY << DAY_TUESDAY
+	<< DAY_TUESDAY << DAY_WEDNESDAY << DAY_THURSDAY << DAY_THURSDAY
+	<< DAY_THURSDAY << DAY_FRIDAY << DAY_SATURDAY << DAY_SUNDAY;
+
 // List of named times names
-const QList<QRegExp> TIME_NAMES_REGEX = QList<QRegExp>() 
-	<< QRegExp("\\bdawn\\b") << QRegExp("\\bmorning\\b")
-	<< QRegExp("\\bnoon\\b") << QRegExp("\\bafternoon\\b")
-	<< QRegExp("\\bevening\\b") << QRegExp("\\bnight\\b")
-	<< QRegExp("\\bmidnight\\b");
+const QStringList TIME_NAMES = QStringList() << "dawn" << "morning"
+	<< "noon" << "afternoon" << "evening" << "night" << "midnight";
 
 // List of named times
 const QStringList TIME_NAMED = QStringList()
@@ -523,50 +651,42 @@ const QStringList TIME_NAMED = QStringList()
 	<< QTime(22,0).toString(TIME_FORMAT)
 	<< QTime(23,59).toString(TIME_FORMAT);
 
-// List of substitution regexes
+// List of substitutions. Words equivalent to "@" must come after a space,
+// and words equivalent to a command must start the command.
 const char* const EQUIV_AT_REPLACE = " @";
-const QList<QRegExp> EQUIV_AT_REGEX = QList<QRegExp>()
-	<< QRegExp("(?:\\s)by\\b") << QRegExp("(?:\\s)at\\b")
-	<< QRegExp("(?:\\s)from\\b") << QRegExp("(?:\\s)on\\b");
-const QList<QRegExp> EQUIV_ADD_REGEX = QList<QRegExp>()
-	<< QRegExp("^do\\b") << QRegExp("^create\\b") << QRegExp("^a\\b");
-const QList<QRegExp> EQUIV_EDIT_REGEX = QList<QRegExp>()
-	<< QRegExp("^change\\b") << QRegExp("^update\\b")
-	<< QRegExp("^modify\\b") << QRegExp("^e\\b");
-const QList<QRegExp> EQUIV_REMOVE_REGEX = QList<QRegExp>()
-	<< QRegExp("^rm\\b") << QRegExp("^delete\\b");
-const QList<QRegExp> EQUIV_SHOW_REGEX = QList<QRegExp>()
-	<< QRegExp("^ls\\b") << QRegExp("^search\\b") << QRegExp("^find\\b")
-	<< QRegExp("^list\\b") << QRegExp("^display\\b");
-const QList<QRegExp> EQUIV_HIDE_REGEX = QList<QRegExp>();
-const QList<QRegExp> EQUIV_DONE_REGEX = QList<QRegExp>()
-	<< QRegExp("^d\\b");
-const QList<QRegExp> EQUIV_UNDONE_REGEX = QList<QRegExp>()
-	<< QRegExp("^nd\\b") << QRegExp("^not done\\b");
-const QList<QRegExp> EQUIV_UNDO_REGEX = QList<QRegExp>()
-	<< QRegExp("^u\\b");
-const QList<QRegExp> EQUIV_REDO_REGEX = QList<QRegExp>()
-	<< QRegExp("^r\\b");
-const QList<QRegExp> EQUIV_CLEAR_REGEX = QList<QRegExp>();
-const QList<QRegExp> EQUIV_HELP_REGEX = QList<QRegExp>()
-	<< QRegExp("^tutorial\\b") << QRegExp("^guide\\b")
-	<< QRegExp("^instructions\\b");
-const QList<QRegExp> EQUIV_ABOUT_REGEX = QList<QRegExp>();
-const QList<QRegExp> EQUIV_NEXT_REGEX = QList<QRegExp>()
-	<< QRegExp("^next free time\\b");
-const QList<QRegExp> EQUIV_SETTINGS_REGEX = QList<QRegExp>()
-	<< QRegExp("^options\\b");
-const QList<QRegExp> EQUIV_EXIT_REGEX = QList<QRegExp>()
-	<< QRegExp("^quit\\b") << QRegExp("^q\\b");
+const QStringList EQUIV_AT_WORDS = QStringList() << "by" << "at" << "from"
+	<< "on";
+const QStringList EQUIV_ADD_WORDS = QStringList() << "do" << "create" << "a";
+const QStringList EQUIV_EDIT_WORDS = QStringList() << "change" << "update"
+	<< "modify" << "e";
+const QStringList EQUIV_REMOVE_WORDS = QStringList() << "rm" << "delete";
+const QStringList EQUIV_SHOW_WORDS = QStringList() << "ls" << "search"
+	<< "find" << "list" << "display";
+const QStringList EQUIV_HIDE_WORDS = QStringList();
+const QStringList EQUIV_DONE_WORDS = QStringList() << "d";
+const QStringList EQUIV_UNDONE_WORDS = QStringList() << "nd" << "not done";
+const QStringList EQUIV_UNDO_WORDS = QStringList() << "u";
+const QStringList EQUIV_REDO_WORDS = QStringList() << "r";
+const QStringList EQUIV_CLEAR_WORDS = QStringList();
+const QStringList EQUIV_HELP_WORDS = QStringList() << "tutorial" << "guide"
+	<< "instructions";
+const QStringList EQUIV_ABOUT_WORDS = QStringList();
+const QStringList EQUIV_NEXT_WORDS = QStringList() << "next free time";
+const QStringList EQUIV_SETTINGS_WORDS = QStringList() << "options";
+const QStringList EQUIV_EXIT_WORDS = QStringList() << "quit" << "q";
+const QStringList EQUIV_RETAG_WORDS = QStringList() << "rename tag";
+const QStringList EQUIV_IMPORT_WORDS = QStringList();
+const QStringList EQUIV_EXPORT_WORDS = QStringList();
 const QRegExp EQUIV_TO_REGEX = QRegExp("\\bto\\b");
 
-const QList< QList<QRegExp> > EQUIV_COMMAND_REGEX = 
-	QList< QList<QRegExp> >() << EQUIV_ADD_REGEX << EQUIV_EDIT_REGEX
-	<< EQUIV_REMOVE_REGEX << EQUIV_SHOW_REGEX << EQUIV_HIDE_REGEX
-	<< EQUIV_DONE_REGEX << EQUIV_UNDONE_REGEX << EQUIV_UNDO_REGEX
-	<< EQUIV_REDO_REGEX << EQUIV_CLEAR_REGEX << EQUIV_HELP_REGEX
-	<< EQUIV_ABOUT_REGEX << EQUIV_NEXT_REGEX << EQUIV_SETTINGS_REGEX
-	<< EQUIV_EXIT_REGEX;
+const QList<QStringList> EQUIV_COMMAND_WORDS = 
+	QList<QStringList>() << EQUIV_ADD_WORDS << EQUIV_EDIT_WORDS
+	<< EQUIV_REMOVE_WORDS << EQUIV_SHOW_WORDS << EQUIV_HIDE_WORDS
+	<< EQUIV_DONE_WORDS << EQUIV_UNDONE_WORDS << EQUIV_UNDO_WORDS
+	<< EQUIV_REDO_WORDS << EQUIV_CLEAR_WORDS << EQUIV_HELP_WORDS
+	<< EQUIV_ABOUT_WORDS << EQUIV_NEXT_WORDS << EQUIV_SETTINGS_WORDS
+	<< EQUIV_EXIT_WORDS << EQUIV_RETAG_WORDS << EQUIV_IMPORT_WORDS
+	<< EQUIV_EXPORT_WORDS;
 
 // Special tag for format display
 #define PSEUDO_TAG_BEGIN(tag) \
@@ -585,5 +705,7 @@ const char* const TRAY_MENU_ABOUT = "&About Tasuke";
 const char* const STARTUP_LNK_PATH = "Startup/Tasuke.lnk";
 
 const int UNDO_LIMIT = 10;
+const int PARSE_CACHE_LIMIT = 16;
+const int FREE_SLOTS_SHOWN = 3;
 
 #endif
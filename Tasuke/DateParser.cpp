@@ -0,0 +1,420 @@
+//@author A0096863M
+#include <QLocale>
+#include <QStringList>
+#include "Constants.h"
+#include "DateParser.h"
+
+// The number of tokens in a day, like "5 jan", and in a date, like "5 jan 14".
+static const int DAY_TOKENS = 3;
+static const int DATE_TOKENS = 5;
+static const int MAX_DIGITS = 4;
+static const int HOURS_ON_CLOCK = 12;
+// A number may start with '+', and so may the minutes of "hhmm". These are
+// the bits of Token::plus for those places.
+static const ushort PLUS = '+';
+static const int PLUS_FIRST = 1;
+static const int PLUS_MINUTES = 4;
+// QDateTime::fromString() checks days without a year against this year.
+static const int YEAR_WITHOUT_YEAR = 1900;
+
+// The ways a day can be written, in the order their formats are tried.
+enum DayForm {
+	DAY_MONTH,
+	MONTH_DAY,
+	NUMERIC
+};
+
+// Returns the lower case names of the months in the system locale, which is
+// what QDateTime::fromString() reads, January first.
+static QStringList monthNames(QLocale::FormatType format) {
+	QLocale locale = QLocale::system();
+	QStringList names;
+	for (int month=1; month<=MONTHS_IN_YEAR; month++) {
+		names.push_back(locale.monthName(month, format).toLower());
+	}
+	return names;
+}
+
+static const QStringList SHORT_MONTHS = monthNames(QLocale::ShortFormat);
+static const QStringList LONG_MONTHS = monthNames(QLocale::LongFormat);
+static const QString AM_TEXT = TIME_AM;
+static const QString PM_TEXT = TIME_PM;
+static const QString HRS_TEXT = TIME_HRS;
+
+// Returns true if the length characters at word spell name.
+static bool spells(const QChar* word, int length, const QString& name) {
+	if (length != name.size()) {
+		return false;
+	}
+
+	const QChar* letters = name.constData();
+	for (int i=0; i<length; i++) {
+		if (word[i] != letters[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Returns the date and time in text, which must already be trimmed and in
+// lower case, or an invalid date time if it is not one. A date without a time
+// is at the end of the day if isEnd, and at its start otherwise. A time or day
+// without a date or year is on today or in its year.
+QDateTime DateParser::parse(const QString& text, const QDate& today,
+							bool isEnd) {
+	Tokens tokens;
+	if (!tokenize(text, tokens)) {
+		return QDateTime();
+	}
+
+	int size = tokens.size;
+	QTime dayTime = isEnd ? TIME_BEFORE_MIDNIGHT : TIME_MIDNIGHT;
+	int day = 0;
+	int month = 0;
+
+	// a time today
+	QTime leadingTime;
+	int timeEnd = matchTime(tokens, 0, leadingTime);
+	if (timeEnd == size) {
+		return QDateTime(today, leadingTime);
+	}
+	bool timeFirst = timeEnd > 0 && kindAt(tokens, timeEnd) == SPACE;
+
+	// a day this year
+	if (matchDay(tokens, 0, size, day, month) >= 0
+		&& QDate::isValid(YEAR_WITHOUT_YEAR, month, day)) {
+		return QDateTime(QDate(today.year(), month, day), dayTime);
+	}
+
+	// a day this year with a time after or before it
+	int best = -1;
+	QDateTime result;
+	QTime time;
+	int form = matchDay(tokens, 0, DAY_TOKENS, day, month);
+	if (form >= 0 && kindAt(tokens, DAY_TOKENS) == SPACE
+		&& matchTime(tokens, DAY_TOKENS + 1, time) == size
+		&& QDate::isValid(YEAR_WITHOUT_YEAR, month, day)) {
+		best = form * 2;
+		result = QDateTime(QDate(today.year(), month, day), time);
+	}
+	if (timeFirst) {
+		form = matchDay(tokens, timeEnd + 1, size, day, month);
+		if (form >= 0 && (best < 0 || form * 2 + 1 < best)
+			&& QDate::isValid(YEAR_WITHOUT_YEAR, month, day)) {
+			best = form * 2 + 1;
+			result = QDateTime(QDate(today.year(), month, day), leadingTime);
+		}
+	}
+	if (best >= 0) {
+		return result;
+	}
+
+	// a date
+	QDate date;
+	if (matchDate(tokens, 0, size, date) >= 0) {
+		return QDateTime(date, dayTime);
+	}
+
+	// a date with a time after or before it
+	int rank = matchDate(tokens, 0, DATE_TOKENS, date);
+	if (rank >= 0 && kindAt(tokens, DATE_TOKENS) == SPACE
+		&& matchTime(tokens, DATE_TOKENS + 1, time) == size) {
+		best = rank * 2;
+		result = QDateTime(date, time);
+	}
+	if (timeFirst) {
+		rank = matchDate(tokens, timeEnd + 1, size, date);
+		if (rank >= 0 && (best < 0 || rank * 2 + 1 < best)) {
+			best = rank * 2 + 1;
+			result = QDateTime(date, leadingTime);
+		}
+	}
+
+	return result;
+}
+
+// Splits text into tokens in one pass. Returns false as soon as it finds
+// something that cannot be part of a date or time, or too many tokens.
+bool DateParser::tokenize(const QString& text, Tokens& tokens) {
+	const QChar* data = text.constData();
+	int length = text.size();
+	tokens.size = 0;
+
+	int i = 0;
+	while (i < length) {
+		if (tokens.size == MAX_TOKENS) {
+			return false;
+		}
+		Token& token = tokens.at[tokens.size];
+		token.value = 0;
+		token.digits = 0;
+		token.plus = 0;
+
+		ushort c = data[i].unicode();
+		if ((c >= '0' && c <= '9') || c == PLUS) {
+			// a '+' is read as a 0, so that "12+5hrs" is 1205
+			token.kind = NUMBER;
+			while (i < length && ((data[i].unicode() >= '0'
+				&& data[i].unicode() <= '9') || data[i].unicode() == PLUS)) {
+				// no format has longer numbers, so give up before the value
+				// or the bits of the '+'s can overflow
+				if (token.digits == MAX_DIGITS) {
+					return false;
+				}
+				ushort digit = data[i].unicode();
+				if (digit == PLUS) {
+					token.plus |= 1 << token.digits;
+					digit = '0';
+				}
+				token.value = token.value * 10 + (digit - '0');
+				token.digits++;
+				i++;
+			}
+		} else if (data[i].isLetter()) {
+			int begin = i;
+			while (i < length && data[i].isLetter()) {
+				i++;
+			}
+
+			const QChar* word = data + begin;
+			int wordLength = i - begin;
+			if (spells(word, wordLength, AM_TEXT)) {
+				token.kind = AM;
+			} else if (spells(word, wordLength, PM_TEXT)) {
+				token.kind = PM;
+			} else if (spells(word, wordLength, HRS_TEXT)) {
+				token.kind = HRS;
+			} else {
+				token.kind = MONTH;
+				token.value = monthOf(word, wordLength);
+				if (token.value == 0) {
+					return false;
+				}
+			}
+		} else {
+			switch (c) {
+			case ' ':
+				token.kind = SPACE;
+				break;
+			case ':':
+				token.kind = COLON;
+				break;
+			case '.':
+				token.kind = DOT;
+				break;
+			case '/':
+				token.kind = SLASH;
+				break;
+			case '-':
+				token.kind = DASH;
+				break;
+			default:
+				return false;
+			}
+			i++;
+		}
+
+		tokens.size++;
+	}
+
+	return true;
+}
+
+// Returns the number of the month named by the length characters at word,
+// in full or abbreviated, or 0 if they are not a month.
+int DateParser::monthOf(const QChar* word, int length) {
+	for (int month=0; month<SHORT_MONTHS.size(); month++) {
+		if (spells(word, length, SHORT_MONTHS[month])) {
+			return month + 1;
+		}
+	}
+	for (int month=0; month<LONG_MONTHS.size(); month++) {
+		if (spells(word, length, LONG_MONTHS[month])) {
+			return month + 1;
+		}
+	}
+	return 0;
+}
+
+// Returns the kind of the i-th token, or NONE past either end.
+DateParser::Kind DateParser::kindAt(const Tokens& tokens, int i) {
+	if (i < 0 || i >= tokens.size) {
+		return NONE;
+	}
+	return tokens.at[i].kind;
+}
+
+// Returns true if the i-th token is a number written with minDigits to
+// maxDigits digits, which may only start with a '+' if a digit follows it.
+bool DateParser::isNumber(const Tokens& tokens, int i, int minDigits,
+						  int maxDigits) {
+	if (kindAt(tokens, i) != NUMBER) {
+		return false;
+	}
+
+	const Token& token = tokens.at[i];
+	return token.digits >= minDigits && token.digits <= maxDigits
+		&& (token.plus == 0 || (token.plus == PLUS_FIRST && token.digits > 1));
+}
+
+// Matches a time starting at token begin. Returns the token after it and sets
+// time, or returns -1 if there is no time there. An am or pm right after the
+// time is always part of it.
+int DateParser::matchTime(const Tokens& tokens, int begin, QTime& time) {
+	if (kindAt(tokens, begin) != NUMBER) {
+		return -1;
+	}
+
+	int hour = tokens.at[begin].value;
+	int minute = 0;
+
+	// military time, like 1430hrs
+	if (tokens.at[begin].digits > 2) {
+		if (tokens.at[begin].digits != MAX_DIGITS
+			|| (tokens.at[begin].plus & ~(PLUS_FIRST | PLUS_MINUTES)) != 0
+			|| kindAt(tokens, begin + 1) != HRS) {
+			return -1;
+		}
+		hour /= 100;
+		minute = tokens.at[begin].value % 100;
+		if (hour >= HOURS_IN_DAY || minute >= MINUTES_IN_HOUR) {
+			return -1;
+		}
+		time = QTime(hour, minute);
+		return begin + 2;
+	}
+
+	if (!isNumber(tokens, begin, 1, 2)) {
+		return -1;
+	}
+
+	int end = begin + 1;
+	Kind separator = kindAt(tokens, end);
+	if ((separator == SPACE || separator == COLON || separator == DOT)
+		&& isNumber(tokens, end + 1, 2, 2)) {
+		minute = tokens.at[end + 1].value;
+		end += 2;
+		if (minute >= MINUTES_IN_HOUR) {
+			return -1;
+		}
+	}
+
+	Kind ap = kindAt(tokens, end);
+	if (ap == AM || ap == PM) {
+		end++;
+	} else if (ap == SPACE && (kindAt(tokens, end + 1) == AM
+		|| kindAt(tokens, end + 1) == PM)) {
+		ap = kindAt(tokens, end + 1);
+		end += 2;
+	} else {
+		ap = NONE;
+	}
+
+	if (ap == NONE) {
+		// a number alone is not a time
+		if (end == begin + 1 || hour >= HOURS_IN_DAY) {
+			return -1;
+		}
+	} else {
+		if (hour > HOURS_ON_CLOCK) {
+			return -1;
+		}
+		hour = hour % HOURS_ON_CLOCK + (ap == PM ? HOURS_ON_CLOCK : 0);
+	}
+
+	time = QTime(hour, minute);
+	return end;
+}
+
+// Matches a day without a year in exactly the tokens from begin to end. Sets
+// day and month and returns its DayForm, or returns -1 if there is none. The
+// day is not checked against the month.
+int DateParser::matchDay(const Tokens& tokens, int begin, int end, int& day,
+						 int& month) {
+	if (end - begin != DAY_TOKENS) {
+		return -1;
+	}
+
+	Kind separator = kindAt(tokens, begin + 1);
+	if (isNumber(tokens, begin, 1, 2) && separator == SPACE
+		&& kindAt(tokens, begin + 2) == MONTH) {
+		day = tokens.at[begin].value;
+		month = tokens.at[begin + 2].value;
+		return DAY_MONTH;
+	}
+	if (kindAt(tokens, begin) == MONTH && separator == SPACE
+		&& isNumber(tokens, begin + 2, 1, 2)) {
+		day = tokens.at[begin + 2].value;
+		month = tokens.at[begin].value;
+		return MONTH_DAY;
+	}
+	if (isNumber(tokens, begin, 1, 2) && (separator == SLASH
+		|| separator == DASH) && isNumber(tokens, begin + 2, 1, 2)) {
+		day = tokens.at[begin].value;
+		month = tokens.at[begin + 2].value;
+		return NUMERIC;
+	}
+	return -1;
+}
+
+// Returns the year written by the i-th token, before any century is added,
+// or 0 if it is not one. Two digit years are in the 1900s.
+int DateParser::yearAt(const Tokens& tokens, int i) {
+	if (isNumber(tokens, i, 2, 2)) {
+		return YEARS_MILIENIUM - YEARS_CENTURY + tokens.at[i].value;
+	}
+	if (isNumber(tokens, i, MAX_DIGITS, MAX_DIGITS)) {
+		return tokens.at[i].value;
+	}
+	return 0;
+}
+
+// Matches a date with a year in exactly the tokens from begin to end. Sets
+// date and returns the rank of the first format that reads it, lowest first,
+// or returns -1 if there is none. Years before 2000 are moved on a century.
+int DateParser::matchDate(const Tokens& tokens, int begin, int end,
+						  QDate& date) {
+	if (end - begin != DATE_TOKENS) {
+		return -1;
+	}
+
+	// for each way of writing the day: year after with 2 digits, before with
+	// 2 digits, after with 4 digits, before with 4 digits
+	int best = -1;
+	int day = 0;
+	int month = 0;
+	int form = matchDay(tokens, begin, end - 2, day, month);
+	int year = yearAt(tokens, end - 1);
+	if (form >= 0 && kindAt(tokens, end - 2) == SPACE && year > 0
+		&& QDate::isValid(year, month, day)) {
+		best = form * 4 + (tokens.at[end - 1].digits == 2 ? 0 : 2);
+		date = QDate(year, month, day);
+	}
+
+	form = matchDay(tokens, begin + 2, end, day, month);
+	year = yearAt(tokens, begin);
+	int rank = form * 4 + (tokens.at[begin].digits == 2 ? 0 : 2) + 1;
+	if (form >= 0 && kindAt(tokens, begin + 1) == SPACE && year > 0
+		&& (best < 0 || rank < best) && QDate::isValid(year, month, day)) {
+		best = rank;
+		date = QDate(year, month, day);
+	}
+
+	// d/M/yy and the like come after every other way
+	Kind separator = kindAt(tokens, begin + 1);
+	year = yearAt(tokens, end - 1);
+	if (best < 0 && isNumber(tokens, begin, 1, 2)
+		&& (separator == SLASH || separator == DASH)
+		&& isNumber(tokens, begin + 2, 1, 2)
+		&& kindAt(tokens, begin + 3) == separator && year > 0
+		&& QDate::isValid(year, tokens.at[begin + 2].value,
+			tokens.at[begin].value)) {
+		best = NUMERIC * 4 + 4;
+		date = QDate(year, tokens.at[begin + 2].value, tokens.at[begin].value);
+	}
+
+	if (best >= 0 && date.year() < YEARS_MILIENIUM) {
+		date = date.addYears(YEARS_CENTURY);
+	}
+	return best;
+}
@@ -0,0 +1,83 @@
+//@author A0096863M
+#ifndef DATEPARSER_H
+#define DATEPARSER_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QString>
+#include <QTime>
+
+// Reads the dates and times the Interpreter accepts in a single pass over the
+// text, instead of trying thousands of formats with QDateTime::fromString()
+// one after the other.
+//
+// The text is first split into tokens: numbers of up to 4 digits, month
+// names, "am", "pm", "hrs" and the separators ' ', ':', '.', '/' and '-'.
+// Like QDateTime::fromString(), a number may start with '+', which counts as
+// one of its digits, and so may the minutes of "hhmm".
+// Anything else rejects the text straight away. The tokens are then matched
+// against this grammar, where d, M and h have 1 or 2 digits, mm has 2 and a
+// year has 2 or 4:
+//
+//   time  = h (' ' | ':' | '.') mm [[' '] ap] | h [' '] ap | hhmm "hrs"
+//   day   = d ' ' month | month ' ' d | d ('/' | '-') M
+//   date  = day ' ' year | year ' ' day | d '/' M '/' year | d '-' M '-' year
+//   input = time | day | day ' ' time | time ' ' day
+//         | date | date ' ' time | time ' ' date
+//
+// When the text fits more than one alternative, the one whose format comes
+// first in the Interpreter's format lists wins, so the result is always the
+// same as trying the formats in order. That includes the quirks of
+// QDateTime::fromString(): a day without a year must exist in 1900, two
+// digit years are read as 19yy, and years before 2000 are moved on a century.
+class DateParser {
+public:
+	static QDateTime parse(const QString& text, const QDate& today,
+		bool isEnd = true);
+
+private:
+	enum Kind {
+		NONE,
+		NUMBER,
+		MONTH,
+		AM,
+		PM,
+		HRS,
+		SPACE,
+		COLON,
+		DOT,
+		SLASH,
+		DASH
+	};
+
+	// A number keeps its value, how many digits it was written with, and
+	// which of them are '+', one bit each from the first. A month keeps its
+	// number.
+	typedef struct {
+		Kind kind;
+		int value;
+		int digits;
+		int plus;
+	} Token;
+
+	static const int MAX_TOKENS = 16;
+
+	typedef struct {
+		Token at[MAX_TOKENS];
+		int size;
+	} Tokens;
+
+	static bool tokenize(const QString& text, Tokens& tokens);
+	static int monthOf(const QChar* word, int length);
+	static Kind kindAt(const Tokens& tokens, int i);
+	static bool isNumber(const Tokens& tokens, int i, int minDigits,
+		int maxDigits);
+	static int matchTime(const Tokens& tokens, int begin, QTime& time);
+	static int matchDay(const Tokens& tokens, int begin, int end, int& day,
+		int& month);
+	static int yearAt(const Tokens& tokens, int i);
+	static int matchDate(const Tokens& tokens, int begin, int end,
+		QDate& date);
+};
+
+#endif
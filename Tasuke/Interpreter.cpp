@@ -3,55 +3,110 @@
 #include <cassert>
 #include <glog/logging.h>
 #include <QApplication>
+#include <QDir>
+#include <QFileInfo>
 #include <QString>
 #include <QStringList>
-#include <QMutexLocker>
 #include "Tasuke.h"
 #include "Commands.h"
 #include "Constants.h"
+#include "DateParser.h"
 #include "Exceptions.h"
 #include "Interpreter.h"
+#include "Substituter.h"
+#include "TaskTransfer.h"
 
-// This private mutex and bool is only used by initFormats() for thread safety
-QMutex Interpreter::mutex;
-bool Interpreter::formatsAlreadyInit = false;
+// This private int stores the unique ID of the last task edited, or 0 if
+// there is none.
+quint64 Interpreter::last = 0;
 
-// This private int stores the last task edited.
-int Interpreter::last = -1;
+// Setter for the unique ID of the last task. This should is intended for
+// commands to change publicly
+void Interpreter::setLast(quint64 _last) {
+	last = _last;
+}
 
-// These private lists stores datetime formats generated by initFormats
-QStringList Interpreter::timeFormats;
-QStringList Interpreter::dateFormatsWithoutYear;
-QStringList Interpreter::dateFormats;
-QStringList Interpreter::dateTimeFormats;
-QStringList Interpreter::dateTimeFormatsWithoutYear;
+// IDs of the replacements made by the date substituter. Each name of a day or
+// time gets its own ID, counting on from the first of its kind.
+static const int DATE_ID_REMOVE = 0;
+static const int DATE_ID_RELATIVE_DAY = 1;
+static const int DATE_ID_WEEKDAY = DATE_ID_RELATIVE_DAY
+	+ DAY_RELATIVE_NAMES.size();
+static const int DATE_ID_TIME = DATE_ID_WEEKDAY + DAY_NAMES.size();
+
+// Builds the substituter used by substitute(). A word equivalent to a command
+// gets the index of the command as its ID, and a word equivalent to "@" gets
+// the number of commands.
+static Substituter commandSubstituter() {
+	Substituter substituter;
+
+	for (int i=0; i<EQUIV_COMMAND_WORDS.size(); i++) {
+		foreach(QString word, EQUIV_COMMAND_WORDS[i]) {
+			substituter.add(word, Substituter::START, i);
+		}
+	}
 
-// These have am/pm in the format
-QStringList Interpreter::timeFormatsAp;
-QStringList Interpreter::dateTimeFormatsAp;
-QStringList Interpreter::dateTimeFormatsWithoutYearAp;
+	foreach(QString word, EQUIV_AT_WORDS) {
+		substituter.add(word, Substituter::AFTER_SPACE, COMMANDS.size());
+	}
 
-// Setter for last id. This should is intended for commands to change
-// publicly
-void Interpreter::setLast(int _last) {
-	last = _last;
+	return substituter;
 }
 
-// Substitutes parts of command with understandable equivalents
-// and returns the new string. This should only be used by interpret()
-QString Interpreter::substitute(QString text) {
-	QString subbedText = text;
-	foreach(QRegExp regex, EQUIV_AT_REGEX) {
-		subbedText.replace(regex, EQUIV_AT_REPLACE);
+// Builds the substituter used by substituteForDate(). Abbreviations are given
+// the ID of the name they stand for, so they are replaced by the date straight
+// away. Names of weekdays are replaced even inside words.
+static Substituter dateSubstituter() {
+	Substituter substituter;
+	substituter.dropBeforeWords(CHAR_COMMA);
+
+	foreach(QString word, REMOVE_DATE_WORDS) {
+		substituter.add(word, Substituter::WORDS, DATE_ID_REMOVE);
 	}
 
-	for (int i=0; i<COMMANDS.size(); i++) {
-		foreach(QRegExp regex, EQUIV_COMMAND_REGEX[i]) {
-			subbedText.replace(regex, COMMANDS[i]);
+	for (int i=0; i<DAY_RELATIVE_NAMES.size(); i++) {
+		substituter.add(DAY_RELATIVE_NAMES[i], Substituter::WORDS,
+			DATE_ID_RELATIVE_DAY + i);
+	}
+
+	for (int i=0; i<DAY_NAMES.size(); i++) {
+		substituter.add(DAY_NAMES[i], Substituter::ANYWHERE,
+			DATE_ID_WEEKDAY + i);
+	}
+
+	for (int i=0; i<DAY_ABBREVIATIONS.size(); i++) {
+		int weekday = DAY_NAMES.indexOf(DAY_ABBREVIATED[i]);
+		if (weekday >= 0) {
+			substituter.add(DAY_ABBREVIATIONS[i], Substituter::WORDS,
+				DATE_ID_WEEKDAY + weekday);
+		} else {
+			int day = DAY_RELATIVE_NAMES.indexOf(DAY_ABBREVIATED[i]);
+			assert(day >= 0);
+			substituter.add(DAY_ABBREVIATIONS[i], Substituter::WORDS,
+				DATE_ID_RELATIVE_DAY + day);
 		}
 	}
 
-	return subbedText;
+	for (int i=0; i<TIME_NAMES.size(); i++) {
+		substituter.add(TIME_NAMES[i], Substituter::WORDS, DATE_ID_TIME + i);
+	}
+
+	return substituter;
+}
+
+static const Substituter COMMAND_SUBSTITUTER = commandSubstituter();
+static const Substituter DATE_SUBSTITUTER = dateSubstituter();
+
+// Substitutes parts of command with understandable equivalents
+// and returns the new string. This should only be used by interpret()
+// and getType(). All the words are replaced in a single pass.
+QString Interpreter::substitute(QString text) {
+	return COMMAND_SUBSTITUTER.apply(text, [](int id) -> QString {
+		if (id < COMMANDS.size()) {
+			return COMMANDS[id];
+		}
+		return EQUIV_AT_REPLACE;
+	});
 }
 
 // Substitute parts of ranges with understandable equivalents
@@ -92,48 +147,22 @@ QDate Interpreter::nextWeekday(int weekday) {
 
 // Substitute parts of dates with understandable equivalents and
 // returns the new string. This is used by interpretDate() to
-// undestand named dates and times
+// undestand named dates and times. Commas before a word and filler words
+// are removed, and named days and times replaced, in a single pass.
 QString Interpreter::substituteForDate(QString text) {
-	QString subbedText = text.toLower();
-
-	// strip commas
-	foreach(QRegExp regex, REMOVE_DATE_REGEX) {
-		subbedText.remove(regex);
-	}
-
-	// expand out abbreviations
-	subbedText.replace(DAY_2DAY_REGEX, DAY_TODAY);
-	subbedText.replace(DAY_TMR_REGEX, DAY_TOMORROW);
-	subbedText.replace(DAY_TML_REGEX, DAY_TOMORROW);
-	subbedText.replace(DAY_MON_REGEX, DAY_MONDAY);
-	subbedText.replace(DAY_TUE_REGEX, DAY_TUESDAY);
-	subbedText.replace(DAY_TUES_REGEX, DAY_TUESDAY);
-	subbedText.replace(DAY_WED_REGEX, DAY_WEDNESDAY);
-	subbedText.replace(DAY_THU_REGEX, DAY_THURSDAY);
-	subbedText.replace(DAY_THUR_REGEX, DAY_THURSDAY);
-	subbedText.replace(DAY_THURS_REGEX, DAY_THURSDAY);
-	subbedText.replace(DAY_FRI_REGEX, DAY_FRIDAY);
-	subbedText.replace(DAY_SAT_REGEX, DAY_SATURDAY);
-	subbedText.replace(DAY_SUN_REGEX, DAY_SUNDAY);
-
-	// today, tomorrow etc.
-	subbedText.replace(DAY_YESTERDAY_REGEX, DATE_YESTERDAY);
-	subbedText.replace(DAY_TODAY_REGEX, DATE_TODAY);
-	subbedText.replace(DAY_TOMORROW_REGEX, DATE_TOMORROW);
-	subbedText.replace(DAY_AFTER_TOMORROW_REGEX, DATE_AFTER_TOMORROW);
-
-	// weekdays
-	for (int i=0; i<DAY_NAMES.size(); i++) {
-		subbedText.replace(DAY_NAMES[i],
-			nextWeekday(i+1).toString(DATE_FORMAT));
-	}
-
-	// time of days
-	for (int i=0; i<TIME_NAMED.size(); i++) {
-		subbedText.replace(TIME_NAMES_REGEX[i], TIME_NAMED[i]);
-	}
-
-	return subbedText;
+	return DATE_SUBSTITUTER.apply(text.toLower(), [](int id) -> QString {
+		if (id >= DATE_ID_TIME) {
+			return TIME_NAMED[id - DATE_ID_TIME];
+		} else if (id >= DATE_ID_WEEKDAY) {
+			return nextWeekday(id - DATE_ID_WEEKDAY + 1)
+				.toString(DATE_FORMAT);
+		} else if (id >= DATE_ID_RELATIVE_DAY) {
+			int offset = DAY_RELATIVE_OFFSETS[id - DATE_ID_RELATIVE_DAY];
+			return QDate::currentDate().addDays(offset)
+				.toString(DATE_FORMAT);
+		}
+		return QString();
+	});
 }
 
 // Decompose a command so that it is easy to parse
@@ -251,12 +280,12 @@ QString Interpreter::getType(QString commandString, bool doSub) {
 // represents the user's command. The caller must clean up using delete. Takes
 // in the user input and a boolean dry. If dry is true, nothing is actually 
 // done. defaults to false. throws ExceptionBadCommand if unable to parse
-// Parsing commands that utilize dates may take some time at the start because
-// the interpreter must wait for the thread generating date formats
-// to finish before running.
 ICommand* Interpreter::interpret(QString commandString, bool dry) {
 	LOG(INFO) << MSG_INTERPRETER_INTERPRETTING(commandString);
 
+	// paths are read from the text as it was typed, as substitution could
+	// change words in them
+	QString typedString = commandString;
 	commandString = substitute(commandString);
 
 	QString commandType = getType(commandString, false);
@@ -276,10 +305,18 @@ ICommand* Interpreter::interpret(QString commandString, bool dry) {
 		return createUndoneCommand(commandString);
 	} else if (commandType == COMMAND_CLEAR) {
 		return createClearCommand(commandString);
+	} else if (commandType == COMMAND_RETAG) {
+		return createRetagCommand(commandString);
+	} else if (commandType == COMMAND_IMPORT) {
+		return createImportCommand(typedString);
 	} else if (commandType == COMMAND_UNDO) {
 		doUndo(commandString, dry);
 	} else if (commandType == COMMAND_REDO) {
 		doRedo(commandString, dry);
+	} else if (commandType == COMMAND_NEXT) {
+		doNextFreeTime(commandString, dry);
+	} else if (commandType == COMMAND_EXPORT) {
+		doExport(typedString, dry);
 	}
 	
 	// if this was a dry run, don't actually do anything
@@ -296,8 +333,6 @@ ICommand* Interpreter::interpret(QString commandString, bool dry) {
 		doHelp();
 	} else if (commandType == COMMAND_SETTINGS) {
 		doSettings();
-	} else if (commandType == COMMAND_NEXT) {
-		doNextFreeTime();
 	} else if (commandType == COMMAND_ABOUT) {
 		doAbout();
 	} else if (commandType == COMMAND_EXIT) {
@@ -357,6 +392,11 @@ ICommand* Interpreter::createRemoveCommand(QString commandString) {
 		throw ExceptionBadCommand(ERROR_REMOVE_NO_ID, WHERE_ID);
 	}
 
+	if (commandString.contains(WHERE_REGEX)) {
+		commandString = removeBefore(commandString, KEYWORD_WHERE);
+		return new RemoveWhereCommand(parseWhere(commandString));
+	}
+
 	QList<int> ids = parseIdList(commandString);
 	QList< QSharedPointer<ICommand> > commands;
 
@@ -435,6 +475,12 @@ ICommand* Interpreter::createDoneCommand(QString commandString) {
 		throw ExceptionBadCommand(ERROR_DONE_NO_ID, WHERE_ID);
 	}
 
+	if (commandString.contains(WHERE_REGEX)) {
+		commandString = removeBefore(commandString, KEYWORD_WHERE);
+		return new EditWhereCommand(parseWhere(commandString),
+			[](Task& task) { task.setDone(true); });
+	}
+
 	QList<int> ids = parseIdList(commandString);
 	QList< QSharedPointer<ICommand> > commands;
 
@@ -460,6 +506,12 @@ ICommand* Interpreter::createUndoneCommand(QString commandString) {
 		throw ExceptionBadCommand(ERROR_UNDONE_NO_ID, WHERE_ID);
 	}
 
+	if (commandString.contains(WHERE_REGEX)) {
+		commandString = removeBefore(commandString, KEYWORD_WHERE);
+		return new EditWhereCommand(parseWhere(commandString),
+			[](Task& task) { task.setDone(false); });
+	}
+
 	QList<int> ids = parseIdList(commandString);
 	QList< QSharedPointer<ICommand> > commands;
 
@@ -474,50 +526,99 @@ ICommand* Interpreter::createUndoneCommand(QString commandString) {
 	return new CompositeCommand(commands);
 }
 
+// Creates a retag command, which renames a tag on all tasks that have it.
+// Takes in a string from user input
+// throws ExceptionBadCommand if unable to parse
+// Should only be used by interpret()
+ICommand* Interpreter::createRetagCommand(QString commandString) {
+	commandString = removeBefore(commandString, COMMAND_RETAG);
+	commandString = commandString.trimmed();
+
+	QRegExp retagRegex = RETAG_REGEX;
+	if (retagRegex.indexIn(commandString) < 0) {
+		throw ExceptionBadCommand(ERROR_RETAG_NO_TAGS, WHERE_TAG);
+	}
+
+	QString from = retagRegex.cap(1);
+	QString to = retagRegex.cap(2);
+	QString folded = from.toCaseFolded();
+
+	return new EditWhereCommand(parseWhere(DELIMITER_HASH + from),
+		[folded, to](Task& task) {
+		bool had = false;
+		foreach (const QString& tag, task.getTags()) {
+			if (tag.toCaseFolded() == folded) {
+				had = task.removeTag(tag) || had;
+			}
+		}
+		if (had) {
+			task.addTag(to);
+		}
+	});
+}
+
+// Creates an import command, which adds every task in a CSV or JSON Lines
+// file in one bulk load. Takes in a string from user input
+// throws ExceptionBadCommand if no readable file is given
+// Should only be used by interpret()
+ICommand* Interpreter::createImportCommand(QString commandString) {
+	QString path = parsePath(removeBefore(commandString, COMMAND_IMPORT));
+
+	QFileInfo file(path);
+	if (!file.isFile() || !file.isReadable()) {
+		throw ExceptionBadCommand(ERROR_CANT_READ(path), WHERE_PATH);
+	}
+
+	return new ImportCommand(path);
+}
+
 // Does the show action. takes in a string from user input.
 // This method doesn't throw because any string input is valid.
+// Showing done tasks and searching also list the archived tasks that match.
 // Should only be used by interpret()
 void Interpreter::doShow(QString commandString) {
 	commandString = removeBefore(commandString, COMMAND_SHOW);
 	commandString = commandString.trimmed();
 
 	if (commandString == KEYWORD_DONE) {
-		QList<Task> results = 
-			Tasuke::instance().getStorage().search(PREDICATE_DONE);
+		TaskView results = 
+			Tasuke::instance().getStorage().query(PREDICATE_DONE, true);
 		Tasuke::instance().updateTaskWindow(results, TITLE_DONE);
 	} else if (commandString == KEYWORD_UNDONE) {
-		QList<Task> results =
-			Tasuke::instance().getStorage().search(PREDICATE_UNDONE);
+		TaskView results =
+			Tasuke::instance().getStorage().query(PREDICATE_UNDONE);
 		Tasuke::instance().updateTaskWindow(results, TITLE_UNDONE);
 	} else if (commandString == KEYWORD_ONGOING) {
-		QList<Task> results = 
-			Tasuke::instance().getStorage().search(PREDICATE_ONGOING);
+		TaskView results = 
+			Tasuke::instance().getStorage().query(PREDICATE_ONGOING);
 		Tasuke::instance().updateTaskWindow(results, TITLE_ONGOING);
 	} else if (commandString == KEYWORD_OVERDUE) {
-		QList<Task> results = 
-			Tasuke::instance().getStorage().search(PREDICATE_OVERDUE);
+		TaskView results = 
+			Tasuke::instance().getStorage().query(PREDICATE_OVERDUE);
 		Tasuke::instance().updateTaskWindow(results, TITLE_OVERDUE);
 	} else if (commandString == KEYWORD_TODAY) {
-		QList<Task> results = 
-			Tasuke::instance().getStorage().search(PREDICATE_TODAY);
+		TaskView results = 
+			Tasuke::instance().getStorage().query(PREDICATE_TODAY);
 		Tasuke::instance().updateTaskWindow(results, TITLE_TODAY);
 	} else if (commandString == KEYWORD_TOMORROW) {
-		QList<Task> results = 
-			Tasuke::instance().getStorage().search(PREDICATE_TOMORROW);
+		TaskView results = 
+			Tasuke::instance().getStorage().query(PREDICATE_TOMORROW);
 		Tasuke::instance().updateTaskWindow(results, TITLE_TOMORROW);
 	} else  if (commandString == KEYWORD_NIL || commandString == KEYWORD_ALL
 		|| commandString == KEYWORD_EVERYTHING) {
-		QList<Task> tasks =Tasuke::instance().getStorage().getTasks();
+		TaskView tasks = Tasuke::instance().getStorage().view();
 		Tasuke::instance().updateTaskWindow(tasks);
 	} else if (commandString.startsWith(DELIMITER_HASH) 
 		&& !commandString.contains(" ")) {
 		QString tag = commandString.remove(0,1);
-		QList<Task> results = Tasuke::instance().getStorage().searchByTag(tag);
+		TaskView results = Tasuke::instance().getStorage().queryByTag(tag,
+			Qt::CaseInsensitive, true);
 		Tasuke::instance().updateTaskWindow(results, DELIMITER_HASH + tag);
 	} else {
 		commandString = substituteForDescription(commandString);
-		QList<Task> results = 
-			Tasuke::instance().getStorage().searchByDescription(commandString);
+		TaskView results = 
+			Tasuke::instance().getStorage().queryByDescription(commandString,
+			Qt::CaseInsensitive, true);
 		Tasuke::instance().updateTaskWindow(results, "\""+commandString+"\"");
 	}
 
@@ -597,11 +698,97 @@ void Interpreter::doRedo(QString commandString, bool dry) {
 	}
 }
 
-// Does the next free time action.
+// Does the next free time action. Takes in a string from user input.
+// With no arguments, shows when the current events are over. With a
+// duration, shows when the next free slot that long starts. With a time
+// period, shows the free slots in it that are at least the duration long.
+// if dry is true, nothing is done. defaults to false
+// throws ExceptionBadCommand if unable to parse
+// Should only be used by interpret()
+void Interpreter::doNextFreeTime(QString commandString, bool dry) {
+	commandString = removeBefore(commandString, COMMAND_NEXT);
+	commandString = commandString.trimmed();
+
+	if (commandString.isEmpty()) {
+		if (!dry) {
+			QString timeString = Tasuke::instance().getStorage().nextFreeTime();
+			Tasuke::instance().showMessage(timeString);
+		}
+		return;
+	}
+
+	QHash<QString, QString> parts = decompose(commandString);
+
+	QString durationString = parts[""].trimmed();
+	if (durationString.startsWith(KEYWORD_FOR)) {
+		durationString.remove(0, QString(KEYWORD_FOR).size());
+	}
+
+	qint64 length = 0;
+	if (!durationString.trimmed().isEmpty()) {
+		length = parseDuration(durationString);
+	}
+
+	bool hasPeriod = parts.contains(DELIMITER_AT);
+	TIME_PERIOD period;
+	if (hasPeriod) {
+		period = parseTimePeriod(parts[DELIMITER_AT].trimmed());
+	}
+
+	if (dry) {
+		return;
+	}
+
+	IStorage& storage = Tasuke::instance().getStorage();
+
+	if (!hasPeriod) {
+		QDateTime slot = storage.nextFreeSlot(length);
+		Tasuke::instance().showMessage(MSG_FREE_SLOT_AT 
+			+ slot.toString(FORMAT_FREE_SLOT));
+		return;
+	}
+
+	if (!period.begin.isValid()) {
+		period.begin = QDateTime::currentDateTime();
+	}
+
+	QList<FreeSlot> gaps = storage.freeSlots(period.begin, period.end,
+		qMax(length, (qint64) MSECS_IN_SECOND * SECONDS_IN_MINUTE));
+
+	if (gaps.isEmpty()) {
+		Tasuke::instance().showMessage(MSG_NO_FREE_SLOTS);
+		return;
+	}
+
+	QStringList gapStrings;
+	for (int i=0; i<gaps.size() && i<FREE_SLOTS_SHOWN; i++) {
+		gapStrings.push_back(gaps[i].first.toString(FORMAT_FREE_SLOT)
+			+ DELIMITER_FREE_SLOT + gaps[i].second.toString(FORMAT_FREE_SLOT));
+	}
+	Tasuke::instance().showMessage(MSG_FREE_SLOTS
+		+ gapStrings.join(DELIMITER_FREE_SLOTS));
+}
+
+// Does the export action. Writes every task, archived tasks included, to the
+// file given, as JSON Lines if it ends in .jsonl and as CSV otherwise.
+// if dry is true, nothing is done. defaults to false
+// throws ExceptionBadCommand if no file is given or it cannot be written
 // Should only be used by interpret()
-void Interpreter::doNextFreeTime() {
-	QString timeString = Tasuke::instance().getStorage().nextFreeTime();
-	Tasuke::instance().showMessage(timeString);
+void Interpreter::doExport(QString commandString, bool dry) {
+	QString path = parsePath(removeBefore(commandString, COMMAND_EXPORT));
+
+	if (dry) {
+		return;
+	}
+
+	IStorage& storage = Tasuke::instance().getStorage();
+	storage.loadArchive();
+	TaskView tasks = storage.view(false, true);
+	if (!TaskTransfer::exportFile(path, tasks)) {
+		throw ExceptionBadCommand(ERROR_CANT_WRITE(path), WHERE_PATH);
+	}
+
+	Tasuke::instance().showMessage(MSG_TRANSFER_EXPORTED(tasks.size(), path));
 }
 
 // Does the settings action.
@@ -622,6 +809,24 @@ void Interpreter::doExit() {
 	QApplication::quit();
 }
 
+// Try to parse the path of a file from a string input, which may be in
+// double quotes. A relative path is taken from the home directory.
+// Returns the absolute path if parsed successfully
+// throws ExceptionBadCommand if there is no path
+QString Interpreter::parsePath(QString pathString) {
+	pathString = pathString.trimmed();
+	if (pathString.size() >= 2 && pathString.startsWith(CHAR_QUOTE)
+		&& pathString.endsWith(CHAR_QUOTE)) {
+		pathString = pathString.mid(1, pathString.size() - 2);
+	}
+
+	if (pathString.isEmpty()) {
+		throw ExceptionBadCommand(ERROR_NO_PATH, WHERE_PATH);
+	}
+
+	return QDir::home().absoluteFilePath(pathString);
+}
+
 // Try to parse the id from a string input
 // Returns an int id if parsed successfully
 // throws ExceptionBadCommand if unable to parse
@@ -629,10 +834,11 @@ int Interpreter::parseId(QString idString) {
 	idString = idString.trimmed();
 
 	if (idString == KEYWORD_LAST) {
-		if (last < 0) {
+		int lastId = Tasuke::instance().getStorage().idOf(last);
+		if (lastId < 0) {
 			throw ExceptionBadCommand(ERROR_NO_LAST, WHERE_ID);
 		}
-		return last;
+		return lastId + 1;
 	}
 
 	bool ok = false;
@@ -642,7 +848,8 @@ int Interpreter::parseId(QString idString) {
 		throw ExceptionBadCommand(ERROR_NO_ID, WHERE_ID);
 	}
 
-	int numTasks = Tasuke::instance().getStorage().totalTasks();
+	// archived tasks that are listed have IDs after the tasks in memory
+	int numTasks = Tasuke::instance().getStorage().totalTasks(true);
 
 	if (id < 1 || id > numTasks) {
 		throw ExceptionBadCommand(ERROR_ID_OUT_OF_RANGE(id, numTasks), 
@@ -684,25 +891,26 @@ QList<int> Interpreter::parseIdRange(QString idRangeString) {
 	idRangeString = idRangeString.trimmed();
 	
 	QList<int> results;
-	QList<Task> special;
+	TaskView special;
 	if (idRangeString == KEYWORD_DONE) {
-		special = Tasuke::instance().getStorage().search(PREDICATE_DONE);
+		special = Tasuke::instance().getStorage().query(PREDICATE_DONE);
 	} else if (idRangeString == KEYWORD_UNDONE) {
-		special = Tasuke::instance().getStorage().search(PREDICATE_UNDONE);
+		special = Tasuke::instance().getStorage().query(PREDICATE_UNDONE);
 	} else if (idRangeString == KEYWORD_ONGOING) {
-		special = Tasuke::instance().getStorage().search(PREDICATE_ONGOING);
+		special = Tasuke::instance().getStorage().query(PREDICATE_ONGOING);
 	} else if (idRangeString == KEYWORD_OVERDUE) {
-		special = Tasuke::instance().getStorage().search(PREDICATE_OVERDUE);
+		special = Tasuke::instance().getStorage().query(PREDICATE_OVERDUE);
 	} else if (idRangeString == KEYWORD_TODAY) {
-		special = Tasuke::instance().getStorage().search(PREDICATE_TODAY);
+		special = Tasuke::instance().getStorage().query(PREDICATE_TODAY);
 	} else if (idRangeString == KEYWORD_TOMORROW) {
-		special = Tasuke::instance().getStorage().search(PREDICATE_TOMORROW);
+		special = Tasuke::instance().getStorage().query(PREDICATE_TOMORROW);
 	}
 
-	// if this is a sepcial range
+	// if this is a sepcial range, the IDs are the positions of the tasks in
+	// the revision they were found in, without copying any task
 	if (special.size() > 0) {
-		foreach(Task task, special) {
-			results.push_back(task.getId()+1);
+		for (int i=0; i<special.size(); i++) {
+			results.push_back(special.idAt(i)+1);
 		}
 
 		return results;
@@ -732,6 +940,62 @@ QList<int> Interpreter::parseIdRange(QString idRangeString) {
 	return results;
 }
 
+// Try to parse the condition of a bulk command, which is either a single
+// #tag or one of the keywords that show takes, such as overdue.
+// Returns a selector that picks the unique IDs of the tasks that meet the
+// condition, so that nothing is looked up while the command is being typed.
+// Tags and done tasks also pick the archived tasks that meet the condition,
+// which are only brought back into memory if the command changes them.
+// throws ExceptionBadCommand if unable to parse
+TaskSelector Interpreter::parseWhere(QString condition) {
+	condition = condition.trimmed();
+
+	if (condition.startsWith(DELIMITER_HASH) && !condition.contains(" ")) {
+		QString tag = condition.mid(1);
+		if (tag.isEmpty()) {
+			throw ExceptionBadCommand(ERROR_TAG_NO_NAME, WHERE_CONDITION);
+		}
+
+		return [tag]() {
+			return uidsOf(Tasuke::instance().getStorage().queryWithTag(tag,
+				true));
+		};
+	}
+
+	TaskTable::Filter filter;
+	if (condition == KEYWORD_DONE) {
+		filter = PREDICATE_DONE;
+	} else if (condition == KEYWORD_UNDONE) {
+		filter = PREDICATE_UNDONE;
+	} else if (condition == KEYWORD_ONGOING) {
+		filter = PREDICATE_ONGOING;
+	} else if (condition == KEYWORD_OVERDUE) {
+		filter = PREDICATE_OVERDUE;
+	} else if (condition == KEYWORD_TODAY) {
+		filter = PREDICATE_TODAY;
+	} else if (condition == KEYWORD_TOMORROW) {
+		filter = PREDICATE_TOMORROW;
+	} else {
+		throw ExceptionBadCommand(ERROR_WHERE_UNKNOWN(condition),
+			WHERE_CONDITION);
+	}
+
+	return [filter]() {
+		return uidsOf(Tasuke::instance().getStorage().query(filter,
+			filter == PREDICATE_DONE));
+	};
+}
+
+// Returns the unique IDs of tasks, in the same order.
+QVector<quint64> Interpreter::uidsOf(const TaskView& tasks) {
+	QVector<quint64> uids;
+	uids.reserve(tasks.size());
+	for (int i=0; i<tasks.size(); i++) {
+		uids.push_back(tasks[i].getUid());
+	}
+	return uids;
+}
+
 // Try to parse the time period from a string input
 // Returns a TIME_PERIOD struct with begin and end if parsed succesfully
 // throws ExceptionBadCommand if unable to parse
@@ -770,304 +1034,55 @@ Interpreter::TIME_PERIOD Interpreter::parseTimePeriod(
 	return timePeriod;
 }
 
-// Try to parse the date from a string input
-// Returns a date time if parsed successfully
+// Try to parse a duration such as "2 hours" or "1h 30min" from a string input
+// Returns the duration in milliseconds if parsed successfully
 // throws ExceptionBadCommand if unable to parse
-QDateTime Interpreter::parseDate(QString dateString, bool isEnd) {
-	dateString = substituteForDate(dateString);
-	dateString = dateString.trimmed();
-	dateString = dateString.toLower();
-
-	QDate currentDate = QDate::currentDate();
-	QTime timePart = TIME_BEFORE_MIDNIGHT;
-	if (!isEnd) {
-		timePart = TIME_MIDNIGHT;
-	}
-
-	if (!formatsAlreadyInit) {
-		initFormats();
-	}
-
-	QDateTime retVal;
-
-	if (dateString.contains(TIME_AM) || dateString.contains(TIME_PM)) {
-		// if the datetime contains am/pm means we can cut our search space
-
-		// these formats need the date added
-		foreach(QString timeFormat, timeFormatsAp) {
-			QTime timePart = QTime::fromString(dateString, timeFormat);
-			if (timePart.isValid()) {
-				retVal.setDate(currentDate);
-				retVal.setTime(timePart);
-				return retVal;
-			}
-		}
-
-		// these formats need the year added
-		foreach(QString dateTimeFormat, dateTimeFormatsWithoutYearAp) {
-			retVal = QDateTime::fromString(dateString, dateTimeFormat);
-			if (retVal.isValid()) {
-				QDate date = retVal.date();
-				retVal.setDate(QDate(currentDate.year(), date.month(), 
-					date.day()));
-				return retVal;
-			}
-		}
-
-		// these formats are complete
-		foreach(QString dateTimeFormat, dateTimeFormatsAp) {
-			retVal = QDateTime::fromString(dateString, dateTimeFormat);
-			if (retVal.isValid()) {
-				QDate date = retVal.date();
-				if (date.year() < 2000) {
-					// add a century
-					date = date.addYears(100);
-					retVal.setDate(date);
-				}
-				return retVal;
-			}
-		}
-
-		// the other formats do not include am/pm so probably invalid
-		return retVal;
-	}
-
-	// these formats need the date added
-	foreach(QString timeFormat, timeFormats) {
-		QTime timePart = QTime::fromString(dateString, timeFormat);
-		if (timePart.isValid()) {
-			retVal.setDate(currentDate);
-			retVal.setTime(timePart);
-			return retVal;
-		}
-	}
-
-	// these formats need the current year and time added
-	foreach(QString dateFormat, dateFormatsWithoutYear) {
-		retVal = QDateTime::fromString(dateString, dateFormat);
-		if (retVal.isValid()) {
-			QDate date = retVal.date();
-			retVal.setDate(QDate(currentDate.year(), date.month(), 
-				date.day()));
-			retVal.setTime(timePart);
-			return retVal;
-		}
-	}
-	
-	// these formats need the year added
-	foreach(QString dateTimeFormat, dateTimeFormatsWithoutYear) {
-		retVal = QDateTime::fromString(dateString, dateTimeFormat);
-		if (retVal.isValid()) {
-			QDate date = retVal.date();
-			retVal.setDate(QDate(currentDate.year(), date.month(), 
-				date.day()));
-			return retVal;
-		}
-	}
-
-	// these formats need the time added
-	foreach(QString dateFormat, dateFormats) {
-		retVal = QDateTime::fromString(dateString, dateFormat);
-		if (retVal.isValid()) {
-			QDate date = retVal.date();
-			if (date.year() < YEARS_MILIENIUM) {
-				// add a century
-				date = date.addYears(YEARS_CENTURY);
-				retVal.setDate(date);
-			}
-			retVal.setTime(timePart);
-			return retVal;
+qint64 Interpreter::parseDuration(QString durationString) {
+	durationString = durationString.trimmed();
+
+	QRegExp regex = DURATION_REGEX;
+	qint64 duration = 0;
+	int pos = 0;
+
+	while (pos < durationString.size()) {
+		int found = regex.indexIn(durationString, pos);
+		if (found != pos) {
+			throw ExceptionBadCommand(ERROR_NOT_A_DURATION(durationString),
+				WHERE_DURATION);
 		}
-	}
-
-	// these formats are complete
-	foreach(QString dateTimeFormat, dateTimeFormats) {
-		retVal = QDateTime::fromString(dateString, dateTimeFormat);
-		if (retVal.isValid()) {
-			QDate date = retVal.date();
-			if (date.year() < YEARS_MILIENIUM) {
-				// add a century
-				date = date.addYears(YEARS_CENTURY);
-				retVal.setDate(date);
-			}
-			return retVal;
-		}
-	}
-
-	return retVal;
-}
-
-// generate all date formats
-// WARNING: this method blocks for very long time.
-// run this method on another thread at start up
-// this method is threadsafe
-void Interpreter::initFormats() {
-	QMutexLocker locker(&mutex);
-
-	if (formatsAlreadyInit) {
-		return;
-	}
-
-	generateTimeFormats();
-	generateDateFormatsWithoutYear();
-	generateDateFormats();
-	generateDateTimeFormatsWithoutYear();
-	generateDateTimeFormats();
-
-	formatsAlreadyInit = true;
-}
-
-// generate formats for time only
-// do not call this directly. use initFormats() to run
-void Interpreter::generateTimeFormats() {
-	assert(formatsAlreadyInit == false);
-
-	QStringList hourFormats;
-	QStringList minuteFomats;
-	QStringList amPmFormats;
-	QStringList separators;
-	QStringList optionalSpaces;
-	
-	hourFormats << "h" << "hh";
-	minuteFomats << "mm";
-	amPmFormats << "ap";
-	separators << " " << ":" << ".";
-	optionalSpaces << " " << "";
-
-	QStringList toAdd;
-	foreach(QString hourFormat, hourFormats) {
-		foreach(QString minuteFormat, minuteFomats) {
-			foreach(QString separator, separators) {
-				timeFormats << (hourFormat + separator + minuteFormat);
-			}
-		}
-	}
-	foreach(QString timeFormat, timeFormats) {
-		foreach(QString amPmFormat, amPmFormats) {
-			foreach(QString optionalSpace, optionalSpaces) {
-				timeFormatsAp << (timeFormat + optionalSpace + amPmFormat);
-			}
-		}
-	}
-	
-	// special constructions
-	// military time:
-	timeFormats << "hhmm'hrs'";;
-	// 5pm:
-	foreach(QString hourFormat, hourFormats) {
-		foreach(QString amPmFormat, amPmFormats) {
-			foreach(QString optionalSpace, optionalSpaces) {
-				timeFormatsAp << (hourFormat + optionalSpace + amPmFormat);
-			}
-		}
-	}
-}
 
-// generates date formats without any year
-// do not call this directly. use initFormats() to run
-void Interpreter::generateDateFormatsWithoutYear() {
-	assert(formatsAlreadyInit == false);
-
-	QStringList dayFormats;
-	QStringList speltMonthFormats;
-	QStringList monthFormats;
-	QStringList dateSeparators;
-
-	dayFormats << "d" << "dd";
-	speltMonthFormats << "MMM" << "MMMM";
-	monthFormats << "M" << "MM";
-	dateSeparators << "/" << "-"; 
-
-	foreach(QString dayFormat, dayFormats) {
-		foreach(QString speltMonthFormat, speltMonthFormats) {
-			dateFormatsWithoutYear << (dayFormat + " " + speltMonthFormat);
-			// american format:
-			dateFormatsWithoutYear << (speltMonthFormat + " " + dayFormat);
+		qint64 amount = regex.cap(1).toLongLong();
+		QChar unit = regex.cap(2).toLower()[0];
+		qint64 minutes = amount;
+		if (unit == 'h') {
+			minutes = amount * MINUTES_IN_HOUR;
+		} else if (unit == 'd') {
+			minutes = amount * MINUTES_IN_HOUR * HOURS_IN_DAY;
 		}
-	}
+		duration += minutes * SECONDS_IN_MINUTE * MSECS_IN_SECOND;
 
-	//special constructions
-	foreach(QString dayFormat, dayFormats) {
-		foreach(QString monthFormat, monthFormats) {
-			foreach(QString dateSeparator, dateSeparators) {
-				dateFormatsWithoutYear << (dayFormat + dateSeparator + 
-					monthFormat);
-			}
+		pos = found + regex.matchedLength();
+		while (pos < durationString.size() && durationString[pos].isSpace()) {
+			pos++;
 		}
 	}
-}
 
-// generates date formats with the years
-// do not call this directly. use initFormats() to run
-void Interpreter::generateDateFormats() {
-	assert(formatsAlreadyInit == false);
-
-	QStringList dayFormats;
-	QStringList monthFormats;
-	QStringList yearFormats;
-	QStringList dateSeparators;
-
-	dayFormats << "d" << "dd";
-	monthFormats << "M" << "MM";
-	yearFormats << "yy" << "yyyy";
-	dateSeparators << "/" << "-"; 
-
-	foreach(QString dateFormatWithoutYear, dateFormatsWithoutYear) {
-		foreach(QString yearFormat, yearFormats) {
-			dateFormats << (dateFormatWithoutYear + " " + yearFormat);
-			dateFormats << (yearFormat + " " + dateFormatWithoutYear);
-		}
+	if (duration <= 0) {
+		throw ExceptionBadCommand(ERROR_NOT_A_DURATION(durationString),
+			WHERE_DURATION);
 	}
 
-	// special construction
-	foreach(QString dayFormat, dayFormats) {
-		foreach(QString monthFormat, monthFormats) {
-			foreach(QString yearFormat, yearFormats) {
-				foreach(QString dateSeparator, dateSeparators) {
-					dateFormats << (dayFormat + dateSeparator + monthFormat
-						+ dateSeparator + yearFormat);
-				}
-			}
-		}
-	}
-}
-
-// generates date + time formats without any year
-// do not call this directly. use initFormats() to run
-void Interpreter::generateDateTimeFormatsWithoutYear() {
-	assert(formatsAlreadyInit == false);
-
-	foreach(QString dateFormatWithoutYear, dateFormatsWithoutYear) {
-		foreach(QString timeFormat, timeFormats) {
-			dateTimeFormatsWithoutYear 
-				<< (dateFormatWithoutYear + " " + timeFormat);
-			dateTimeFormatsWithoutYear 
-				<< (timeFormat + " " + dateFormatWithoutYear);
-		}
-
-		foreach(QString timeFormatAp, timeFormatsAp) {
-			dateTimeFormatsWithoutYearAp 
-				<< (dateFormatWithoutYear + " " + timeFormatAp);
-			dateTimeFormatsWithoutYearAp 
-				<< (timeFormatAp + " " + dateFormatWithoutYear);
-		}
-	}
+	return duration;
 }
 
-// generates date + time formats with the year
-// do not call this directly. use initFormats() to run
-void Interpreter::generateDateTimeFormats() {
-	assert(formatsAlreadyInit == false);
-
-	foreach(QString dateFormat, dateFormats) {
-		foreach(QString timeFormat, timeFormats) {
-			dateTimeFormats << (dateFormat + " " + timeFormat);
-			dateTimeFormats << (timeFormat + " " + dateFormat);
-		}
+// Try to parse the date from a string input
+// Returns a date time if parsed successfully, or an invalid one if not.
+// The date is read in a single pass by DateParser, which accepts exactly
+// what the generated formats do.
+QDateTime Interpreter::parseDate(QString dateString, bool isEnd) {
+	dateString = substituteForDate(dateString);
+	dateString = dateString.trimmed();
+	dateString = dateString.toLower();
 
-		foreach(QString timeFormatAp, timeFormatsAp) {
-			dateTimeFormatsAp << (dateFormat + " " + timeFormatAp);
-			dateTimeFormatsAp << (timeFormatAp + " " + dateFormat);
-		}
-	}
+	return DateParser::parse(dateString, QDate::currentDate(), isEnd);
 }
\ No newline at end of file
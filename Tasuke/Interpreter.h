@@ -3,8 +3,8 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
-#include <QMutex>
 #include "Commands.h"
+#include "TaskView.h"
 
 // This class acts as an interpreter. It either returns an ICommand object
 // or a nullptr. If it returns an ICommand object the caller must manage
@@ -16,39 +16,22 @@ private:
 		QDateTime end;
 	} TIME_PERIOD;
 
-	static int last;
+	static quint64 last;
 
-	static QStringList timeFormats;
-	static QStringList dateFormatsWithoutYear;
-	static QStringList dateFormats;
-	static QStringList dateTimeFormatsWithoutYear;
-	static QStringList dateTimeFormats;
-
-	static QStringList timeFormatsAp;
-	static QStringList dateTimeFormatsAp;
-	static QStringList dateTimeFormatsWithoutYearAp;
-
-	static bool formatsAlreadyInit;
-	static QMutex mutex;
-	
-	static QString substitute(QString text);
 	static QString substituteForRange(QString text);
-	static QString substituteForDate(QString text);
 	static QString substituteForDescription(QString text);
 
 	static QHash<QString, QString> decompose(QString text);
 	static QString removeBefore(QString text, QString before);
+	static QString parsePath(QString pathString);
 	static int parseId(QString idString);
 	static QList<int> parseIdList(QString idListString);
 	static QList<int> parseIdRange(QString idRangeString);
+	static TaskSelector parseWhere(QString condition);
+	static QVector<quint64> uidsOf(const TaskView& tasks);
 	static TIME_PERIOD parseTimePeriod(QString timePeriod);
-	static QDateTime parseDate(QString dateString, bool isEnd = true);
+	static qint64 parseDuration(QString durationString);
 	static QDate nextWeekday(int weekday);
-	static void generateTimeFormats();
-	static void generateDateFormatsWithoutYear();
-	static void generateDateFormats();
-	static void generateDateTimeFormatsWithoutYear();
-	static void generateDateTimeFormats();
 
 	static ICommand* createAddCommand(QString commandString);
 	static ICommand* createRemoveCommand(QString commandString);
@@ -56,6 +39,8 @@ private:
 	static ICommand* createClearCommand(QString commandString);
 	static ICommand* createDoneCommand(QString commandString);
 	static ICommand* createUndoneCommand(QString commandString);
+	static ICommand* createRetagCommand(QString commandString);
+	static ICommand* createImportCommand(QString commandString);
 
 	static void doShow(QString commandString);
 	static void doAbout();
@@ -63,15 +48,18 @@ private:
 	static void doUndo(QString commandString, bool dry = false);
 	static void doRedo(QString commandString, bool dry = false);
 	static void doHelp();
-	static void doNextFreeTime();
+	static void doNextFreeTime(QString commandString, bool dry = false);
+	static void doExport(QString commandString, bool dry = false);
 	static void doSettings();
 	static void doExit();
 
 public:	
-	static void setLast(int _last);
+	static void setLast(quint64 _last);
 	static QString getType(QString commandString, bool doSub = true);
 	static ICommand* interpret(QString commandString, bool dry = false);
-	static void initFormats();
+	static QDateTime parseDate(QString dateString, bool isEnd = true);
+	static QString substitute(QString text);
+	static QString substituteForDate(QString text);
 };
 
 #endif
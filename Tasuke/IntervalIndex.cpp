@@ -0,0 +1,168 @@
+//@author A0096863M
+#include "IntervalIndex.h"
+
+IntervalIndex::IntervalIndex() {
+
+}
+
+// Removes every event from the index.
+void IntervalIndex::clear() {
+	blocks.clear();
+}
+
+// Adds task to the index if it is an event.
+void IntervalIndex::insert(const Task* task) {
+	Interval interval;
+	if (!toInterval(task, interval)) {
+		return;
+	}
+
+	Block block;
+	block.end = interval.second;
+	block.tasks.push_back(task);
+	merge(interval.first, block);
+}
+
+// Removes task from the index. The other events in its block are added back
+// one by one, as the block may have fallen apart without it.
+void IntervalIndex::remove(const Task* task) {
+	Interval interval;
+	if (!toInterval(task, interval)) {
+		return;
+	}
+
+	QMap<qint64, Block>::iterator it = blocks.upperBound(interval.first);
+	if (it == blocks.begin()) {
+		return;
+	}
+	--it;
+
+	if (!it.value().tasks.removeOne(task)) {
+		return;
+	}
+
+	QList<const Task*> others = it.value().tasks;
+	blocks.erase(it);
+	foreach (const Task* other, others) {
+		insert(other);
+	}
+}
+
+// Returns every event that overlaps the period from begin to end.
+QList<const Task*> IntervalIndex::overlapping(qint64 begin, qint64 end) const {
+	QList<const Task*> results;
+
+	QMap<qint64, Block>::const_iterator it;
+	for (it = firstBlockEndingAfter(begin);
+		it != blocks.constEnd() && it.key() < end; it++) {
+		foreach (const Task* task, it.value().tasks) {
+			Interval interval;
+			toInterval(task, interval);
+			if (interval.first < end && interval.second > begin) {
+				results.push_back(task);
+			}
+		}
+	}
+
+	return results;
+}
+
+// Returns the gaps between events from begin to end that are at least
+// minimum long, earliest first.
+QList<IntervalIndex::Interval> IntervalIndex::freeSlots(qint64 begin,
+														qint64 end,
+														qint64 minimum) const {
+	QList<Interval> results;
+	qint64 cursor = begin;
+
+	QMap<qint64, Block>::const_iterator it;
+	for (it = firstBlockEndingAfter(begin);
+		it != blocks.constEnd() && it.key() < end; it++) {
+		if (it.key() > cursor && it.key() - cursor >= minimum) {
+			results.push_back(Interval(cursor, it.key()));
+		}
+		cursor = qMax(cursor, it.value().end);
+	}
+
+	if (cursor < end && end - cursor >= minimum) {
+		results.push_back(Interval(cursor, end));
+	}
+
+	return results;
+}
+
+// Returns the earliest time at or after from that begins a gap between events
+// at least length long. With a length of 0, this is when the events going on
+// at from are over.
+qint64 IntervalIndex::nextFreeSlot(qint64 from, qint64 length) const {
+	qint64 cursor = from;
+
+	QMap<qint64, Block>::const_iterator it;
+	for (it = firstBlockEndingAfter(from); it != blocks.constEnd(); it++) {
+		if (it.key() > cursor && it.key() - cursor >= length) {
+			return cursor;
+		}
+		cursor = qMax(cursor, it.value().end);
+	}
+
+	return cursor;
+}
+
+// Returns the number of busy blocks.
+int IntervalIndex::blockCount() const {
+	return blocks.size();
+}
+
+// Adds a block of events from begin to the end of block, merging it with any
+// block it overlaps or touches.
+void IntervalIndex::merge(qint64 begin, const Block& block) {
+	Block merged = block;
+
+	QMap<qint64, Block>::iterator it = blocks.upperBound(begin);
+	if (it != blocks.begin()) {
+		QMap<qint64, Block>::iterator previous = it;
+		--previous;
+		if (previous.value().end >= begin) {
+			it = previous;
+		}
+	}
+
+	while (it != blocks.end() && it.key() <= merged.end) {
+		begin = qMin(begin, it.key());
+		merged.end = qMax(merged.end, it.value().end);
+		merged.tasks.append(it.value().tasks);
+		it = blocks.erase(it);
+	}
+
+	blocks.insert(begin, merged);
+}
+
+// Returns the first block that ends after time. Blocks never overlap, so
+// only the block just before the first one to begin after time can also
+// contain it.
+QMap<qint64, IntervalIndex::Block>::const_iterator
+	IntervalIndex::firstBlockEndingAfter(qint64 time) const {
+	QMap<qint64, Block>::const_iterator it = blocks.upperBound(time);
+
+	if (it != blocks.constBegin()) {
+		QMap<qint64, Block>::const_iterator previous = it;
+		--previous;
+		if (previous.value().end > time) {
+			return previous;
+		}
+	}
+
+	return it;
+}
+
+// Gets the period of task if it is an event. Returns false if it is not, or
+// if it ends before it begins.
+bool IntervalIndex::toInterval(const Task* task, Interval& interval) {
+	if (!task->isEvent()) {
+		return false;
+	}
+
+	interval.first = task->getBegin().toMSecsSinceEpoch();
+	interval.second = task->getEnd().toMSecsSinceEpoch();
+	return interval.first < interval.second;
+}
@@ -0,0 +1,50 @@
+//@author A0096863M
+#ifndef INTERVALINDEX_H
+#define INTERVALINDEX_H
+
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include "Task.h"
+
+// Answers questions about when events are and when there is free time
+// between them, without walking every task.
+//
+// Events, the tasks with both a begin and an end, are grouped into busy
+// blocks: maximal runs of events that overlap or touch, stored in a balanced
+// tree by the time they begin. Free time is exactly the gaps between blocks,
+// so finding the free gaps or the events in a period only visits the blocks
+// that fall in it. Adding an event merges the blocks it touches. Removing one
+// only regroups the events of the block it was in.
+//
+// All times are in milliseconds since the epoch, and periods include their
+// begin but not their end.
+class IntervalIndex {
+public:
+	typedef QPair<qint64, qint64> Interval;
+
+	IntervalIndex();
+
+	void clear();
+	void insert(const Task* task);
+	void remove(const Task* task);
+
+	QList<const Task*> overlapping(qint64 begin, qint64 end) const;
+	QList<Interval> freeSlots(qint64 begin, qint64 end, qint64 minimum) const;
+	qint64 nextFreeSlot(qint64 from, qint64 length) const;
+	int blockCount() const;
+
+private:
+	struct Block {
+		qint64 end;
+		QList<const Task*> tasks;
+	};
+
+	QMap<qint64, Block> blocks;
+
+	void merge(qint64 begin, const Block& block);
+	QMap<qint64, Block>::const_iterator firstBlockEndingAfter(qint64 time) const;
+	static bool toInterval(const Task* task, Interval& interval);
+};
+
+#endif
@@ -0,0 +1,380 @@
+//@author A0096863M
+#include <glog/logging.h>
+#include <QDataStream>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "Constants.h"
+#include "Journal.h"
+
+Journal::Journal() : records(0) {
+
+}
+
+// The journal is flushed one last time before it is destroyed so no
+// buffered records are lost.
+Journal::~Journal() {
+	close();
+}
+
+// Opens the journal file at path for appending. If the file is new, the
+// journal header is written first. existingRecords is the number of records
+// already in the file, which is known to the caller after a replay.
+void Journal::open(QString path, int existingRecords) {
+	close();
+
+	file.setFileName(path);
+	file.open(QIODevice::WriteOnly | QIODevice::Append);
+	records = existingRecords;
+
+	if (file.size() == 0) {
+		QDataStream out(&file);
+		out.setVersion(JOURNAL_STREAM_VERSION);
+		out << JOURNAL_MAGIC << JOURNAL_VERSION;
+		file.flush();
+	}
+}
+
+// Flushes whatever is buffered and closes the journal file.
+void Journal::close() {
+	if (file.isOpen()) {
+		flush();
+		file.close();
+	}
+	records = 0;
+}
+
+// Returns true if the journal has a file open for appending.
+bool Journal::isOpen() const {
+	return file.isOpen();
+}
+
+// Writes all buffered records to the journal file in a single write.
+// Returns false if the journal is not open or the write fails, in which
+// case the records are kept so the next flush can try again.
+bool Journal::flush() {
+	if (pending.isEmpty()) {
+		return true;
+	}
+
+	if (!file.isOpen()) {
+		return false;
+	}
+
+	qint64 written = file.write(pending);
+	file.flush();
+
+	if (written != pending.size()) {
+		LOG(ERROR) << MSG_JOURNAL_WRITE_FAILED
+			<< file.errorString().toStdString();
+		return false;
+	}
+
+	pending.clear();
+	return true;
+}
+
+// Asks the operating system to commit everything written to the journal
+// file to the disk, so that it survives a power failure. Call after flush().
+void Journal::sync() {
+	if (!file.isOpen()) {
+		return;
+	}
+
+#ifdef Q_OS_WIN
+	_commit(file.handle());
+#else
+	fsync(file.handle());
+#endif
+}
+
+// Records that task was added.
+void Journal::appendAdd(const Task& task) {
+	QByteArray record;
+	QDataStream out(&record, QIODevice::WriteOnly);
+	out.setVersion(JOURNAL_STREAM_VERSION);
+	out << (quint8) RecordType::ADD << task.getUid() << task;
+	append(record);
+}
+
+// Records that task was removed.
+void Journal::appendRemove(const Task& task) {
+	QByteArray record;
+	QDataStream out(&record, QIODevice::WriteOnly);
+	out.setVersion(JOURNAL_STREAM_VERSION);
+	out << (quint8) RecordType::REMOVE << task.getUid();
+	append(record);
+}
+
+// Records that oldTask was replaced by newTask, which has the same unique
+// ID. If only the done status changed, a smaller DONE record which does not
+// repeat the task is written.
+void Journal::appendEdit(const Task& oldTask, const Task& newTask) {
+	QByteArray record;
+	QDataStream out(&record, QIODevice::WriteOnly);
+	out.setVersion(JOURNAL_STREAM_VERSION);
+
+	Task doneChanged = oldTask;
+	doneChanged.setDone(newTask.isDone());
+
+	if (doneChanged == newTask) {
+		out << (quint8) RecordType::DONE << oldTask.getUid() << newTask.isDone();
+	} else {
+		out << (quint8) RecordType::EDIT << oldTask.getUid() << newTask;
+	}
+	append(record);
+}
+
+// Records that all tasks, or only all done tasks, were removed.
+void Journal::appendClear(bool doneOnly) {
+	QByteArray record;
+	QDataStream out(&record, QIODevice::WriteOnly);
+	out.setVersion(JOURNAL_STREAM_VERSION);
+	out << (quint8) (doneOnly ? RecordType::CLEAR_DONE : RecordType::CLEAR);
+	append(record);
+}
+
+// Returns the number of records in the journal file, including those that
+// are still buffered.
+int Journal::recordCount() const {
+	return records;
+}
+
+// Returns true if there are records that have not been flushed yet.
+bool Journal::hasPending() const {
+	return !pending.isEmpty();
+}
+
+// Buffers a record. Each record is length prefixed so a record that was
+// only partially written before a crash can be detected during replay.
+void Journal::append(const QByteArray& record) {
+	QDataStream out(&pending, QIODevice::WriteOnly | QIODevice::Append);
+	out.setVersion(JOURNAL_STREAM_VERSION);
+	out << record;
+	records++;
+}
+
+// Applies every record in the journal file at path to tasks, in the order
+// they were written. Tasks are found by unique ID through a hash of their
+// positions, so each record takes constant time. Journals written before
+// tasks had unique IDs match tasks by content instead. The order of tasks is
+// not kept. Stops at the first incomplete record. Returns the number of
+// records applied, or 0 if there is no journal at path.
+int Journal::replay(QString path, QVector< QSharedPointer<Task> >& tasks) {
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return 0;
+	}
+
+	QDataStream in(&file);
+	in.setVersion(JOURNAL_STREAM_VERSION);
+
+	quint32 magic = 0;
+	quint16 version = 0;
+	in >> magic >> version;
+	if (magic != JOURNAL_MAGIC || (version != JOURNAL_VERSION
+		&& version != JOURNAL_VERSION_WITHOUT_UIDS)) {
+		LOG(ERROR) << MSG_JOURNAL_BAD_HEADER << path.toStdString();
+		return 0;
+	}
+
+	QHash<quint64, int> positions;
+	if (version == JOURNAL_VERSION) {
+		positions.reserve(tasks.size());
+		for (int i=0; i<tasks.size(); i++) {
+			positions.insert(tasks[i]->getUid(), i);
+		}
+	}
+
+	int applied = 0;
+	while (!in.atEnd()) {
+		QByteArray record;
+		in >> record;
+		if (in.status() != QDataStream::Ok) {
+			LOG(WARNING) << MSG_JOURNAL_TRUNCATED << path.toStdString();
+			break;
+		}
+
+		QDataStream body(record);
+		body.setVersion(JOURNAL_STREAM_VERSION);
+		quint8 type = 0;
+		body >> type;
+
+		bool known = false;
+		if (version == JOURNAL_VERSION) {
+			known = applyRecord(body, type, tasks, positions);
+		} else {
+			known = applyRecordWithoutUids(body, type, tasks);
+		}
+
+		if (!known) {
+			LOG(WARNING) << MSG_JOURNAL_UNKNOWN_RECORD << (int) type;
+			continue;
+		}
+
+		applied++;
+	}
+
+	LOG(INFO) << MSG_JOURNAL_REPLAYED << applied;
+	return applied;
+}
+
+// Returns the version of the journal file at path, or 0 if there is no
+// journal at path.
+int Journal::version(QString path) {
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return 0;
+	}
+
+	QDataStream in(&file);
+	in.setVersion(JOURNAL_STREAM_VERSION);
+
+	quint32 magic = 0;
+	quint16 version = 0;
+	in >> magic >> version;
+	if (magic != JOURNAL_MAGIC) {
+		return 0;
+	}
+
+	return version;
+}
+
+// Applies a record of type, whose body is the rest of the record, to tasks.
+// positions maps the unique ID of every task to its position in tasks and
+// is kept up to date. Returns false if type is unknown.
+bool Journal::applyRecord(QDataStream& body, quint8 type,
+						  QVector< QSharedPointer<Task> >& tasks,
+						  QHash<quint64, int>& positions) {
+	Task task;
+	quint64 uid = 0;
+	bool done = false;
+	int index = -1;
+
+	switch ((RecordType) type) {
+	case RecordType::ADD:
+		body >> uid >> task;
+		task.setUid(uid);
+		positions.insert(uid, tasks.size());
+		tasks.push_back(QSharedPointer<Task>::create(task));
+		break;
+	case RecordType::REMOVE:
+		body >> uid;
+		index = positions.value(uid, -1);
+		if (index != -1) {
+			removeAt(tasks, positions, index);
+		}
+		break;
+	case RecordType::EDIT:
+		body >> uid >> task;
+		index = positions.value(uid, -1);
+		if (index != -1) {
+			task.setUid(uid);
+			tasks.replace(index, QSharedPointer<Task>::create(task));
+		}
+		break;
+	case RecordType::DONE:
+		body >> uid >> done;
+		index = positions.value(uid, -1);
+		if (index != -1) {
+			tasks[index]->setDone(done);
+		}
+		break;
+	case RecordType::CLEAR:
+		tasks.clear();
+		positions.clear();
+		break;
+	case RecordType::CLEAR_DONE:
+		for (int i=tasks.size()-1; i>=0; i--) {
+			if (tasks[i]->isDone()) {
+				removeAt(tasks, positions, i);
+			}
+		}
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+// Same as applyRecord(), for journals written before tasks had unique IDs,
+// which repeat the whole task to name the one they change.
+bool Journal::applyRecordWithoutUids(QDataStream& body, quint8 type,
+									 QVector< QSharedPointer<Task> >& tasks) {
+	Task task;
+	Task other;
+	bool done = false;
+	int index = -1;
+
+	switch ((RecordType) type) {
+	case RecordType::ADD:
+		body >> task;
+		tasks.push_back(QSharedPointer<Task>::create(task));
+		break;
+	case RecordType::REMOVE:
+		body >> task;
+		index = indexOf(tasks, task);
+		if (index != -1) {
+			tasks.removeAt(index);
+		}
+		break;
+	case RecordType::EDIT:
+		body >> task >> other;
+		index = indexOf(tasks, task);
+		if (index != -1) {
+			other.setUid(tasks[index]->getUid());
+			tasks.replace(index, QSharedPointer<Task>::create(other));
+		}
+		break;
+	case RecordType::DONE:
+		body >> task >> done;
+		index = indexOf(tasks, task);
+		if (index != -1) {
+			tasks[index]->setDone(done);
+		}
+		break;
+	case RecordType::CLEAR:
+		tasks.clear();
+		break;
+	case RecordType::CLEAR_DONE:
+		for (int i=tasks.size()-1; i>=0; i--) {
+			if (tasks[i]->isDone()) {
+				tasks.removeAt(i);
+			}
+		}
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+// Removes the task at index by moving the last task into its place, so that
+// only one position in positions changes.
+void Journal::removeAt(QVector< QSharedPointer<Task> >& tasks,
+					   QHash<quint64, int>& positions, int index) {
+	positions.remove(tasks[index]->getUid());
+
+	int last = tasks.size() - 1;
+	if (index != last) {
+		tasks[index] = tasks[last];
+		positions.insert(tasks[index]->getUid(), index);
+	}
+	tasks.removeLast();
+}
+
+// Returns the position of the first task in tasks with the same content as
+// task, or -1 if there is none.
+int Journal::indexOf(const QVector< QSharedPointer<Task> >& tasks,
+					 const Task& task) {
+	for (int i=0; i<tasks.size(); i++) {
+		if (*tasks[i] == task) {
+			return i;
+		}
+	}
+	return -1;
+}
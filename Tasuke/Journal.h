@@ -0,0 +1,66 @@
+//@author A0096863M
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
+#include <QString>
+#include "Task.h"
+
+// An append-only log of changes made to the list of tasks. Instead of
+// rewriting every task on every command, Storage appends one small record per
+// change and only rewrites the whole file when the journal is compacted.
+// Records are buffered in memory and only hit the disk on flush().
+// Records name the task they change by its unique ID.
+class Journal {
+public:
+	enum class RecordType : quint8 {
+		ADD = 1,
+		REMOVE,
+		EDIT,
+		DONE,
+		CLEAR,
+		CLEAR_DONE
+	};
+
+	Journal();
+	~Journal();
+
+	void open(QString path, int existingRecords = 0);
+	void close();
+	bool isOpen() const;
+	bool flush();
+	void sync();
+
+	void appendAdd(const Task& task);
+	void appendRemove(const Task& task);
+	void appendEdit(const Task& oldTask, const Task& newTask);
+	void appendClear(bool doneOnly);
+
+	int recordCount() const;
+	bool hasPending() const;
+
+	static int replay(QString path, QVector< QSharedPointer<Task> >& tasks);
+	static int version(QString path);
+
+private:
+	QFile file;
+	QByteArray pending;
+	int records;
+
+	void append(const QByteArray& record);
+	static bool applyRecord(QDataStream& body, quint8 type,
+		QVector< QSharedPointer<Task> >& tasks, QHash<quint64, int>& positions);
+	static bool applyRecordWithoutUids(QDataStream& body, quint8 type,
+		QVector< QSharedPointer<Task> >& tasks);
+	static void removeAt(QVector< QSharedPointer<Task> >& tasks,
+		QHash<quint64, int>& positions, int index);
+	static int indexOf(const QVector< QSharedPointer<Task> >& tasks,
+		const Task& task);
+};
+
+#endif
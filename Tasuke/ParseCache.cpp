@@ -0,0 +1,111 @@
+//@author A0096863M
+#include "Constants.h"
+#include "ParseCache.h"
+
+ParseCache::ParseCache() {
+
+}
+
+// Keeps the command the dry run built from text at revision. The cache takes
+// ownership of the command.
+void ParseCache::putCommand(const QString& text, quint64 revision,
+							ICommand* command) {
+	Entry entry;
+	entry.revision = revision;
+	entry.minute = currentMinute();
+	entry.command = QSharedPointer<ICommand>(command);
+	entry.failed = false;
+	put(text, entry);
+}
+
+// Keeps the error the dry run found in text at revision.
+void ParseCache::putError(const QString& text, quint64 revision,
+						  const ExceptionBadCommand& exception) {
+	Entry entry;
+	entry.revision = revision;
+	entry.minute = currentMinute();
+	entry.failed = true;
+	entry.errorString = exception.what();
+	entry.errorWhere = exception.where();
+	put(text, entry);
+}
+
+// Takes the entry for text out of the cache if it was parsed at revision and
+// returns true, with the command it built in command. If the text could not
+// be understood, throws the same ExceptionBadCommand the dry run did. Returns
+// false if there is no such entry.
+bool ParseCache::take(const QString& text, quint64 revision,
+					  QSharedPointer<ICommand>& command) {
+	Entry entry;
+
+	{
+		QMutexLocker lock(&mutex);
+		QHash<QString, Entry>::iterator it = entries.find(text);
+		if (it == entries.end()) {
+			return false;
+		}
+		entry = it.value();
+		entries.erase(it);
+	}
+
+	if (!isCurrent(entry, revision)) {
+		return false;
+	}
+
+	if (entry.failed) {
+		throw ExceptionBadCommand(entry.errorString, entry.errorWhere);
+	}
+
+	command = entry.command;
+	return true;
+}
+
+// Drops every entry that was not parsed at revision this minute. Should be run
+// whenever storage changes.
+void ParseCache::evict(quint64 revision) {
+	QMutexLocker lock(&mutex);
+	QHash<QString, Entry>::iterator it = entries.begin();
+	while (it != entries.end()) {
+		if (isCurrent(it.value(), revision)) {
+			++it;
+		} else {
+			it = entries.erase(it);
+		}
+	}
+}
+
+// Drops every entry.
+void ParseCache::clear() {
+	QMutexLocker lock(&mutex);
+	entries.clear();
+}
+
+// Returns the number of entries kept.
+int ParseCache::size() {
+	QMutexLocker lock(&mutex);
+	return entries.size();
+}
+
+// Keeps the entry for text, dropping the entries of older revisions first.
+// If there are still too many, they are all dropped, as only the last few
+// texts typed are ever run.
+void ParseCache::put(const QString& text, const Entry& entry) {
+	evict(entry.revision);
+
+	QMutexLocker lock(&mutex);
+	if (entries.size() >= PARSE_CACHE_LIMIT) {
+		entries.clear();
+	}
+	entries.insert(text, entry);
+}
+
+// Returns whether entry was parsed at revision this minute.
+bool ParseCache::isCurrent(const Entry& entry, quint64 revision) {
+	return entry.revision == revision && entry.minute == currentMinute();
+}
+
+// Returns the number of minutes since the epoch, as of now.
+qint64 ParseCache::currentMinute() {
+	return TimeSnapshot::current().getMSecs()
+		/ (SECONDS_IN_MINUTE * MSECS_IN_SECOND);
+}
@@ -0,0 +1,54 @@
+//@author A0096863M
+#ifndef PARSECACHE_H
+#define PARSECACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include "Commands.h"
+#include "Exceptions.h"
+#include "TimeSnapshot.h"
+
+// Keeps what the dry run made of the commands being typed, so that pressing
+// Enter runs the command it built instead of interpreting the text again.
+//
+// An entry is only good for the storage revision it was parsed at, and for
+// the minute, as named days like "tmr" and ranges like "overdue" or "today"
+// depend on the time. The cache only keeps what
+// the dry run does the same way as the real run: commands it built and
+// commands it could not understand. Commands with nothing to build, like
+// "show" or "undo", are still interpreted on Enter. Safe to use from any
+// thread.
+class ParseCache {
+public:
+	ParseCache();
+
+	void putCommand(const QString& text, quint64 revision, ICommand* command);
+	void putError(const QString& text, quint64 revision,
+		const ExceptionBadCommand& exception);
+	bool take(const QString& text, quint64 revision,
+		QSharedPointer<ICommand>& command);
+	void evict(quint64 revision);
+	void clear();
+	int size();
+
+private:
+	typedef struct {
+		quint64 revision;
+		qint64 minute;
+		QSharedPointer<ICommand> command;
+		bool failed;
+		QString errorString;
+		QString errorWhere;
+	} Entry;
+
+	QMutex mutex;
+	QHash<QString, Entry> entries;
+
+	void put(const QString& text, const Entry& entry);
+	static bool isCurrent(const Entry& entry, quint64 revision);
+	static qint64 currentMinute();
+};
+
+#endif
@@ -0,0 +1,130 @@
+//@author A0096863M
+#include <glog/logging.h>
+#include "PersistenceWorker.h"
+
+// Starts the worker thread. write is called on that thread whenever dirty
+// data has to be written, and must be safe to call alongside the GUI thread.
+PersistenceWorker::PersistenceWorker(std::function<void()> _write) 
+	: write(_write), policy(DurabilityPolicy::IMMEDIATE),
+	interval(DURABILITY_INTERVAL_DEFAULT), dirty(false), writing(false),
+	flushing(false), stopping(false), dirtyCount(0), writes(0) {
+	sinceWrite.start();
+	thread = std::thread([this]() {
+		run();
+	});
+}
+
+// Writes whatever is still dirty before the thread exits.
+PersistenceWorker::~PersistenceWorker() {
+	stop();
+}
+
+// Changes when dirty data is written. IMMEDIATE writes as soon as possible,
+// INTERVAL writes at most once every interval milliseconds and IDLE waits
+// until nothing has been marked dirty for interval milliseconds.
+void PersistenceWorker::setPolicy(DurabilityPolicy _policy, int _interval) {
+	QMutexLocker lock(&mutex);
+	policy = _policy;
+	interval = _interval;
+	wake.wakeAll();
+}
+
+// Schedules a write. Returns immediately.
+void PersistenceWorker::markDirty() {
+	QMutexLocker lock(&mutex);
+	dirty = true;
+	dirtyCount++;
+	wake.wakeAll();
+}
+
+// Blocks until everything marked dirty before this call has been written,
+// skipping whatever the durability policy would otherwise wait for.
+void PersistenceWorker::flush() {
+	QMutexLocker lock(&mutex);
+	if (!thread.joinable()) {
+		return;
+	}
+
+	LOG(INFO) << MSG_PERSISTENCE_FLUSH;
+
+	flushing = true;
+	wake.wakeAll();
+	while (dirty || writing) {
+		written.wait(&mutex);
+	}
+	flushing = false;
+}
+
+// Flushes and stops the worker thread. Nothing is written after this.
+void PersistenceWorker::stop() {
+	{
+		QMutexLocker lock(&mutex);
+		if (!thread.joinable()) {
+			return;
+		}
+		stopping = true;
+		wake.wakeAll();
+	}
+
+	thread.join();
+}
+
+// Returns the number of writes so far. Each write may cover many changes.
+int PersistenceWorker::writeCount() {
+	QMutexLocker lock(&mutex);
+	return writes;
+}
+
+// The loop run by the worker thread.
+void PersistenceWorker::run() {
+	QMutexLocker lock(&mutex);
+
+	while (true) {
+		while (!dirty && !stopping) {
+			wake.wait(&mutex);
+		}
+
+		if (!dirty) {
+			break;
+		}
+
+		waitToCoalesce();
+
+		dirty = false;
+		writing = true;
+		lock.unlock();
+
+		write();
+
+		lock.relock();
+		writing = false;
+		writes++;
+		sinceWrite.restart();
+		written.wakeAll();
+	}
+
+	written.wakeAll();
+}
+
+// Holds off a write according to the durability policy so that more changes
+// can be written together. Must be called with the mutex held. Returns early
+// when flushing or stopping.
+void PersistenceWorker::waitToCoalesce() {
+	while (!flushing && !stopping) {
+		if (policy == DurabilityPolicy::INTERVAL) {
+			qint64 remaining = interval - sinceWrite.elapsed();
+			if (remaining <= 0) {
+				return;
+			}
+			wake.wait(&mutex, (unsigned long) remaining);
+		} else if (policy == DurabilityPolicy::IDLE) {
+			int seen = dirtyCount;
+			// only write once a whole interval passes without changes
+			if (!wake.wait(&mutex, interval) && seen == dirtyCount) {
+				return;
+			}
+		} else {
+			return;
+		}
+	}
+}
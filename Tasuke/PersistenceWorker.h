@@ -0,0 +1,47 @@
+//@author A0096863M
+#ifndef PERSISTENCEWORKER_H
+#define PERSISTENCEWORKER_H
+
+#include <functional>
+#include <thread>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include "Constants.h"
+
+// Writes to disk on a background thread so that commands never wait for
+// disk I/O. Callers mark the data as dirty after every change, and bursts of
+// changes are coalesced into a single write according to the durability
+// policy. flush() blocks until everything marked dirty has been written.
+class PersistenceWorker {
+private:
+	std::function<void()> write;
+	std::thread thread;
+	QMutex mutex;
+	QWaitCondition wake;
+	QWaitCondition written;
+	DurabilityPolicy policy;
+	int interval;
+	bool dirty;
+	bool writing;
+	bool flushing;
+	bool stopping;
+	int dirtyCount;
+	int writes;
+	QElapsedTimer sinceWrite;
+
+	void run();
+	void waitToCoalesce();
+
+public:
+	PersistenceWorker(std::function<void()> _write);
+	~PersistenceWorker();
+
+	void setPolicy(DurabilityPolicy _policy, int _interval);
+	void markDirty();
+	void flush();
+	void stop();
+	int writeCount();
+};
+
+#endif
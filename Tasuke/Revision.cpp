@@ -0,0 +1,84 @@
+//@author A0096863M
+#include "Revision.h"
+
+// Creates the empty revision that storage starts with.
+Revision::Revision() : number(0) {
+
+}
+
+// Creates revision number _number with the tasks in _tasks, and the archived
+// tasks read back in _archived.
+Revision::Revision(const QVector< QSharedPointer<Task> >& _tasks,
+				   const QVector< QSharedPointer<Task> >& _archived,
+				   quint64 _number)
+	: tasks(_tasks), archived(_archived), number(_number) {
+
+}
+
+// Returns the tasks in this revision, in display order.
+const QVector< QSharedPointer<Task> >& Revision::getTasks() const {
+	return tasks;
+}
+
+// Returns the archived tasks read back, in the order they were archived.
+const QVector< QSharedPointer<Task> >& Revision::getArchived() const {
+	return archived;
+}
+
+// Returns the tasks followed by the archived tasks, so that the position of
+// each is its ID. Without archived tasks this is just the tasks. Safe to call
+// from any thread.
+const QVector< QSharedPointer<Task> >& Revision::getListed() const {
+	if (archived.isEmpty()) {
+		return tasks;
+	}
+
+	std::call_once(listedBuilt, [this]() {
+		listed.reserve(tasks.size() + archived.size());
+		listed << tasks << archived;
+	});
+	return listed;
+}
+
+// Returns the number of this revision. Later revisions have larger numbers.
+quint64 Revision::getNumber() const {
+	return number;
+}
+
+// Returns the number of tasks in this revision.
+int Revision::size() const {
+	return tasks.size();
+}
+
+// Returns the tasks in this revision laid out as columns, building them the
+// first time. Safe to call from any thread.
+const TaskTable& Revision::getTable() const {
+	std::call_once(tableBuilt, [this]() {
+		table.reset(new TaskTable(tasks));
+	});
+	return *table;
+}
+
+// Returns the archived tasks laid out as columns, building them the first
+// time. Safe to call from any thread.
+const TaskTable& Revision::getArchiveTable() const {
+	std::call_once(archiveTableBuilt, [this]() {
+		archiveTable.reset(new TaskTable(archived));
+	});
+	return *archiveTable;
+}
+
+
+// Returns the position of the task with the given UID in this revision,
+// archived tasks included, or -1 if it is not in it. The positions are looked
+// up the first time. Safe to call from any thread.
+int Revision::positionOf(quint64 uid) const {
+	std::call_once(positionsBuilt, [this]() {
+		const QVector< QSharedPointer<Task> >& all = getListed();
+		positions.reserve(all.size());
+		for (int i=0; i<all.size(); i++) {
+			positions.insert(all[i]->getUid(), i);
+		}
+	});
+	return positions.value(uid, -1);
+}
@@ -0,0 +1,61 @@
+//@author A0096863M
+#ifndef REVISION_H
+#define REVISION_H
+
+#include <memory>
+#include <mutex>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
+#include "Task.h"
+#include "TaskTable.h"
+
+// An immutable version of the tasks in storage, in display order.
+//
+// Storage publishes a new revision after every change, and readers on any
+// thread take the latest one without waiting for the writers. A revision
+// never changes once published, so everything read from the same revision
+// is consistent. Revisions share the tasks that did not change, so
+// publishing one only costs a list of pointers. Nothing about a task depends
+// on the revision it is in, so the tasks themselves are never written to
+// once shared. The ID of a task is its position in a revision, which
+// positionOf() looks up.
+//
+// A revision also carries the archived tasks that have been read back for
+// the user to see. They are listed after the tasks in memory, so their IDs
+// follow on from those, but they are not part of getTasks() or size().
+//
+// The columnar TaskTables of a revision, its list of every task and the
+// positions of its tasks are only worked out the first time they are needed,
+// so changes that are never filtered or looked up do not pay for them.
+class Revision {
+public:
+	Revision();
+	Revision(const QVector< QSharedPointer<Task> >& _tasks,
+		const QVector< QSharedPointer<Task> >& _archived, quint64 _number);
+
+	const QVector< QSharedPointer<Task> >& getTasks() const;
+	const QVector< QSharedPointer<Task> >& getArchived() const;
+	const QVector< QSharedPointer<Task> >& getListed() const;
+	quint64 getNumber() const;
+	int size() const;
+	const TaskTable& getTable() const;
+	const TaskTable& getArchiveTable() const;
+	int positionOf(quint64 uid) const;
+
+private:
+	const QVector< QSharedPointer<Task> > tasks;
+	const QVector< QSharedPointer<Task> > archived;
+	const quint64 number;
+	mutable std::once_flag tableBuilt;
+	mutable std::unique_ptr<TaskTable> table;
+	mutable std::once_flag archiveTableBuilt;
+	mutable std::unique_ptr<TaskTable> archiveTable;
+	mutable std::once_flag listedBuilt;
+	mutable QVector< QSharedPointer<Task> > listed;
+	mutable std::once_flag positionsBuilt;
+	mutable QHash<quint64, int> positions;
+};
+
+#endif
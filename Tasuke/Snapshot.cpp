@@ -0,0 +1,363 @@
+//@author A0096863M
+#include <cassert>
+#include <glog/logging.h>
+#include <QHash>
+#include <QtEndian>
+#include "Constants.h"
+#include "Snapshot.h"
+
+// Offsets of the fields in the header.
+static const int HEADER_MAGIC = 0;
+static const int HEADER_VERSION = 4;
+static const int HEADER_GENERATION = 8;
+static const int HEADER_TASK_COUNT = 12;
+static const int HEADER_TAG_REF_COUNT = 16;
+static const int HEADER_STRING_COUNT = 20;
+static const int HEADER_STRING_DATA_SIZE = 24;
+
+// Offsets of the fields in a task record.
+static const int RECORD_BEGIN = 0;
+static const int RECORD_END = 8;
+static const int RECORD_DESCRIPTION = 16;
+static const int RECORD_FIRST_TAG = 20;
+static const int RECORD_TAG_COUNT = 24;
+static const int RECORD_FLAGS = 26;
+static const int RECORD_UID = 32;
+
+static const quint16 FLAG_DONE = 0x1;
+
+Snapshot::Snapshot() : data(nullptr), length(0), taskCount(0),
+	tagRefCount(0), stringCount(0), snapshotGeneration(0), snapshotVersion(0),
+	recordSize(SNAPSHOT_RECORD_SIZE), records(nullptr),
+	tagRefs(nullptr), stringOffsets(nullptr), stringData(nullptr) {
+
+}
+
+Snapshot::~Snapshot() {
+	close();
+}
+
+// Memory maps the snapshot at path and checks its header. Returns false if
+// there is no such file or if it is not a snapshot this version can read.
+// Snapshots from before tasks had unique IDs can still be read.
+bool Snapshot::open(QString path) {
+	close();
+
+	file.setFileName(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	length = file.size();
+	if (length < SNAPSHOT_HEADER_SIZE) {
+		LOG(ERROR) << MSG_SNAPSHOT_BAD_HEADER << path.toStdString();
+		close();
+		return false;
+	}
+
+	data = file.map(0, length);
+	if (data == nullptr) {
+		LOG(ERROR) << MSG_SNAPSHOT_MAP_FAILED << path.toStdString();
+		close();
+		return false;
+	}
+
+	quint32 magic = qFromLittleEndian<quint32>(data + HEADER_MAGIC);
+	quint16 version = qFromLittleEndian<quint16>(data + HEADER_VERSION);
+	if (magic != SNAPSHOT_MAGIC || (version != SNAPSHOT_VERSION
+		&& version != SNAPSHOT_VERSION_WITHOUT_UIDS)) {
+		LOG(ERROR) << MSG_SNAPSHOT_BAD_HEADER << path.toStdString();
+		close();
+		return false;
+	}
+
+	snapshotVersion = version;
+	recordSize = SNAPSHOT_RECORD_SIZE;
+	if (version == SNAPSHOT_VERSION_WITHOUT_UIDS) {
+		recordSize = SNAPSHOT_RECORD_SIZE_WITHOUT_UIDS;
+	}
+
+	snapshotGeneration = qFromLittleEndian<qint32>(data + HEADER_GENERATION);
+	quint32 tasksInFile = qFromLittleEndian<quint32>(data + HEADER_TASK_COUNT);
+	quint32 tagRefsInFile =
+		qFromLittleEndian<quint32>(data + HEADER_TAG_REF_COUNT);
+	quint32 stringsInFile =
+		qFromLittleEndian<quint32>(data + HEADER_STRING_COUNT);
+	quint32 stringDataSize =
+		qFromLittleEndian<quint32>(data + HEADER_STRING_DATA_SIZE);
+
+	qint64 expectedLength = SNAPSHOT_HEADER_SIZE
+		+ (qint64) tasksInFile * recordSize
+		+ (qint64) tagRefsInFile * sizeof(quint32)
+		+ ((qint64) stringsInFile + 1) * sizeof(quint32)
+		+ stringDataSize;
+	if (expectedLength != length) {
+		LOG(ERROR) << MSG_SNAPSHOT_TRUNCATED << path.toStdString();
+		close();
+		return false;
+	}
+
+	taskCount = tasksInFile;
+	tagRefCount = tagRefsInFile;
+	stringCount = stringsInFile;
+	records = data + SNAPSHOT_HEADER_SIZE;
+	tagRefs = records + (qint64) taskCount * recordSize;
+	stringOffsets = tagRefs + (qint64) tagRefCount * sizeof(quint32);
+	stringData = stringOffsets + ((qint64) stringCount + 1) * sizeof(quint32);
+
+	strings.resize(stringCount);
+	decoded.fill(false, stringCount);
+
+	return true;
+}
+
+// Unmaps and closes the snapshot.
+void Snapshot::close() {
+	if (data != nullptr) {
+		file.unmap(const_cast<uchar*>(data));
+	}
+	if (file.isOpen()) {
+		file.close();
+	}
+
+	data = nullptr;
+	length = 0;
+	taskCount = 0;
+	tagRefCount = 0;
+	stringCount = 0;
+	snapshotGeneration = 0;
+	snapshotVersion = 0;
+	recordSize = SNAPSHOT_RECORD_SIZE;
+	records = nullptr;
+	tagRefs = nullptr;
+	stringOffsets = nullptr;
+	stringData = nullptr;
+	strings.clear();
+	decoded.clear();
+}
+
+// Returns true if a snapshot is mapped.
+bool Snapshot::isOpen() const {
+	return data != nullptr;
+}
+
+// Returns the number of tasks in the snapshot.
+int Snapshot::size() const {
+	return taskCount;
+}
+
+// Returns the first journal generation that is not part of the snapshot.
+int Snapshot::generation() const {
+	return snapshotGeneration;
+}
+
+// Returns the version of the file format the snapshot was written in.
+int Snapshot::version() const {
+	return snapshotVersion;
+}
+
+// Returns the description of the task at index.
+QString Snapshot::description(int index) const {
+	const uchar* entry = record(index);
+	return string(qFromLittleEndian<quint32>(entry + RECORD_DESCRIPTION));
+}
+
+// Returns the begin time of the task at index, or a null QDateTime if the
+// task has none.
+QDateTime Snapshot::begin(int index) const {
+	return toDateTime(qFromLittleEndian<qint64>(record(index) + RECORD_BEGIN));
+}
+
+// Returns the end time of the task at index, or a null QDateTime if the
+// task has none.
+QDateTime Snapshot::end(int index) const {
+	return toDateTime(qFromLittleEndian<qint64>(record(index) + RECORD_END));
+}
+
+// Returns true if the task at index is done.
+bool Snapshot::isDone(int index) const {
+	quint16 flags = qFromLittleEndian<quint16>(record(index) + RECORD_FLAGS);
+	return (flags & FLAG_DONE) != 0;
+}
+
+// Returns the tags of the task at index. Tags are shared between tasks
+// through the string table, so each distinct tag is only decoded once.
+QStringList Snapshot::tags(int index) const {
+	const uchar* entry = record(index);
+	quint32 firstTag = qFromLittleEndian<quint32>(entry + RECORD_FIRST_TAG);
+	quint16 tagCount = qFromLittleEndian<quint16>(entry + RECORD_TAG_COUNT);
+
+	QStringList result;
+	if ((qint64) firstTag + tagCount > tagRefCount) {
+		return result;
+	}
+
+	for (int i=0; i<tagCount; i++) {
+		const uchar* tagRef = tagRefs + (firstTag + i) * sizeof(quint32);
+		result.push_back(string(qFromLittleEndian<quint32>(tagRef)));
+	}
+
+	return result;
+}
+
+// Returns the unique ID of the task at index, or 0 if the snapshot was
+// written before tasks had unique IDs.
+quint64 Snapshot::uid(int index) const {
+	if (recordSize < RECORD_UID + (int) sizeof(quint64)) {
+		return 0;
+	}
+	return qFromLittleEndian<quint64>(record(index) + RECORD_UID);
+}
+
+// Builds the task at index.
+Task Snapshot::task(int index) const {
+	Task task;
+
+	task.setDescription(description(index));
+	task.setBegin(begin(index));
+	task.setEnd(end(index));
+	task.setDone(isDone(index));
+	task.setUid(uid(index));
+
+	QStringList taskTags = tags(index);
+	for (int i=0; i<taskTags.size(); i++) {
+		task.addTag(taskTags[i]);
+	}
+
+	return task;
+}
+
+// Writes tasks to a new snapshot at path. Returns false if the file cannot
+// be written.
+bool Snapshot::write(QString path, const QList<Task>& tasks, int generation) {
+	QHash<QString, quint32> stringIds;
+	QList<QByteArray> stringTable;
+	QVector<quint32> tagIds;
+	QByteArray recordBytes(tasks.size() * SNAPSHOT_RECORD_SIZE, 0);
+	quint32 stringDataSize = 0;
+
+	// assigns the next id to a string which has not been seen before
+	auto intern = [&](const QString& text) -> quint32 {
+		QHash<QString, quint32>::const_iterator it = stringIds.constFind(text);
+		if (it != stringIds.constEnd()) {
+			return it.value();
+		}
+		quint32 stringId = stringTable.size();
+		QByteArray utf8 = text.toUtf8();
+		stringDataSize += utf8.size();
+		stringTable.push_back(utf8);
+		stringIds.insert(text, stringId);
+		return stringId;
+	};
+
+	for (int i=0; i<tasks.size(); i++) {
+		const Task& task = tasks[i];
+		uchar* entry = reinterpret_cast<uchar*>(recordBytes.data())
+			+ i * SNAPSHOT_RECORD_SIZE;
+		QList<QString> taskTags = task.getTags();
+
+		qToLittleEndian<qint64>(toEpoch(task.getBegin()), entry + RECORD_BEGIN);
+		qToLittleEndian<qint64>(toEpoch(task.getEnd()), entry + RECORD_END);
+		qToLittleEndian<quint32>(intern(task.getDescription()),
+			entry + RECORD_DESCRIPTION);
+		qToLittleEndian<quint32>(tagIds.size(), entry + RECORD_FIRST_TAG);
+		qToLittleEndian<quint16>(taskTags.size(), entry + RECORD_TAG_COUNT);
+		qToLittleEndian<quint16>(task.isDone() ? FLAG_DONE : 0,
+			entry + RECORD_FLAGS);
+		qToLittleEndian<quint64>(task.getUid(), entry + RECORD_UID);
+
+		for (int j=0; j<taskTags.size(); j++) {
+			tagIds.push_back(intern(taskTags[j]));
+		}
+	}
+
+	QByteArray header(SNAPSHOT_HEADER_SIZE, 0);
+	uchar* headerData = reinterpret_cast<uchar*>(header.data());
+	qToLittleEndian<quint32>(SNAPSHOT_MAGIC, headerData + HEADER_MAGIC);
+	qToLittleEndian<quint16>(SNAPSHOT_VERSION, headerData + HEADER_VERSION);
+	qToLittleEndian<qint32>(generation, headerData + HEADER_GENERATION);
+	qToLittleEndian<quint32>(tasks.size(), headerData + HEADER_TASK_COUNT);
+	qToLittleEndian<quint32>(tagIds.size(), headerData + HEADER_TAG_REF_COUNT);
+	qToLittleEndian<quint32>(stringTable.size(),
+		headerData + HEADER_STRING_COUNT);
+	qToLittleEndian<quint32>(stringDataSize,
+		headerData + HEADER_STRING_DATA_SIZE);
+
+	QByteArray tagBytes(tagIds.size() * sizeof(quint32), 0);
+	for (int i=0; i<tagIds.size(); i++) {
+		qToLittleEndian<quint32>(tagIds[i],
+			reinterpret_cast<uchar*>(tagBytes.data()) + i * sizeof(quint32));
+	}
+
+	QByteArray offsetBytes((stringTable.size() + 1) * sizeof(quint32), 0);
+	QByteArray stringBytes;
+	stringBytes.reserve(stringDataSize);
+	for (int i=0; i<=stringTable.size(); i++) {
+		qToLittleEndian<quint32>(stringBytes.size(),
+			reinterpret_cast<uchar*>(offsetBytes.data()) + i * sizeof(quint32));
+		if (i < stringTable.size()) {
+			stringBytes.append(stringTable[i]);
+		}
+	}
+
+	QFile out(path);
+	if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	qint64 expected = header.size() + recordBytes.size() + tagBytes.size()
+		+ offsetBytes.size() + stringBytes.size();
+	qint64 written = out.write(header) + out.write(recordBytes)
+		+ out.write(tagBytes) + out.write(offsetBytes) + out.write(stringBytes);
+	out.close();
+
+	return written == expected && out.error() == QFile::NoError;
+}
+
+// Returns a pointer to the record of the task at index.
+const uchar* Snapshot::record(int index) const {
+	assert(index >= 0 && index < taskCount);
+	return records + (qint64) index * recordSize;
+}
+
+// Returns the string with the given id, decoding it on first use. An
+// out of range id, which can only come from a corrupt file, gives an empty
+// string.
+QString Snapshot::string(quint32 stringId) const {
+	if (stringId >= (quint32) stringCount) {
+		return QString();
+	}
+
+	if (!decoded[stringId]) {
+		const uchar* offset = stringOffsets + stringId * sizeof(quint32);
+		quint32 first = qFromLittleEndian<quint32>(offset);
+		quint32 last = qFromLittleEndian<quint32>(offset + sizeof(quint32));
+		qint64 dataSize = length - (stringData - data);
+
+		if (first <= last && last <= dataSize) {
+			strings[stringId] = QString::fromUtf8(
+				reinterpret_cast<const char*>(stringData + first), last - first);
+		}
+		decoded[stringId] = true;
+	}
+
+	return strings[stringId];
+}
+
+// Converts milliseconds since the epoch, as stored in a record, back into a
+// QDateTime.
+QDateTime Snapshot::toDateTime(qint64 epoch) {
+	if (epoch == SNAPSHOT_NO_TIME) {
+		return QDateTime();
+	}
+	return QDateTime::fromMSecsSinceEpoch(epoch);
+}
+
+// Converts a QDateTime into milliseconds since the epoch. Null and invalid
+// times are stored as SNAPSHOT_NO_TIME.
+qint64 Snapshot::toEpoch(const QDateTime& dateTime) {
+	if (dateTime.isNull() || !dateTime.isValid()) {
+		return SNAPSHOT_NO_TIME;
+	}
+	return dateTime.toMSecsSinceEpoch();
+}
@@ -0,0 +1,73 @@
+//@author A0096863M
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "Task.h"
+
+// A read-only view over a binary snapshot of the list of tasks.
+//
+// The file starts with a fixed size header, followed by one fixed width
+// record per task holding its times, flags and unique ID, the tag ids of
+// every task, and a string table holding every distinct description and tag
+// once. All integers are little endian.
+// The file is memory mapped when opened, so nothing is parsed up front;
+// fields are decoded straight from the mapping when they are asked for and a
+// Task is only built when task() is called. Strings are decoded at most once.
+// Storage still calls task() for every record of the tasks it loads, as the
+// order and the search indexes are built over all of them right away. The
+// archive is only read through uid() at load, and its tasks are built when
+// the user first asks for done tasks.
+class Snapshot {
+public:
+	Snapshot();
+	~Snapshot();
+
+	bool open(QString path);
+	void close();
+	bool isOpen() const;
+
+	int size() const;
+	int generation() const;
+	int version() const;
+
+	QString description(int index) const;
+	QDateTime begin(int index) const;
+	QDateTime end(int index) const;
+	bool isDone(int index) const;
+	QStringList tags(int index) const;
+	quint64 uid(int index) const;
+	Task task(int index) const;
+
+	static bool write(QString path, const QList<Task>& tasks,
+		int generation);
+
+private:
+	QFile file;
+	const uchar* data;
+	qint64 length;
+	int taskCount;
+	int tagRefCount;
+	int stringCount;
+	int snapshotGeneration;
+	int snapshotVersion;
+	int recordSize;
+	const uchar* records;
+	const uchar* tagRefs;
+	const uchar* stringOffsets;
+	const uchar* stringData;
+	mutable QVector<QString> strings;
+	mutable QVector<bool> decoded;
+
+	const uchar* record(int index) const;
+	QString string(quint32 stringId) const;
+	static QDateTime toDateTime(qint64 epoch);
+	static qint64 toEpoch(const QDateTime& dateTime);
+};
+
+#endif
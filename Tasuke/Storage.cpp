@@ -1,380 +1,1957 @@
 //@author A0096863M
 #define NOMINMAX
 
+#include <cassert>
 #include <glog/logging.h>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QDir>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QSet>
 #include "Constants.h"
 #include "Exceptions.h"
 #include "Storage.h"
-#include "Tasuke.h"
 
 IStorage::IStorage() {
-
+	revisionNumber = 0;
+	batchDepth = 0;
+	batchDirty = false;
+	lastUid = 0;
+	reservedUid = 0;
+	archivedDirty = false;
+	published = std::make_shared<const Revision>();
 }
 
 IStorage::~IStorage() {
 
 }
 
-// Adds a task to the list of tasks in memory.
-Task IStorage::addTask(Task& task) {
-	QMutexLocker lock(&mutex);
+// Blocks until every change passed to saveFile() has been written. Does
+// nothing by default, for storages that save synchronously.
+void IStorage::flush() {
+
+}
+
+// Reads any tasks kept outside of memory, without bringing them back, so that
+// queries can list them. Does nothing by default, for storages that keep
+// every task in memory.
+void IStorage::loadArchive() {
+
+}
+
+// Called after task has been added to the list of tasks in memory.
+void IStorage::onTaskAdded(const Task& task) {
+	Q_UNUSED(task);
+}
+
+// Called after task has been removed from the list of tasks in memory.
+void IStorage::onTaskRemoved(const Task& task) {
+	Q_UNUSED(task);
+}
+
+// Called after oldTask has been replaced by newTask in memory.
+void IStorage::onTaskReplaced(const Task& oldTask, const Task& newTask) {
+	Q_UNUSED(oldTask);
+	Q_UNUSED(newTask);
+}
+
+// Called after all tasks, or all done tasks if doneOnly is true, have been
+// removed from memory.
+void IStorage::onTasksCleared(bool doneOnly) {
+	Q_UNUSED(doneOnly);
+}
+
+void IStorage::onTasksLoaded(int count) {
+	Q_UNUSED(count);
+}
+
+// Called after an archived task has been brought back into memory to be
+// changed, right after onTaskAdded().
+void IStorage::onTaskUnarchived(const Task& task) {
+	Q_UNUSED(task);
+}
+
+// Adds a task to the list of tasks in memory. The task keeps its unique ID
+// if it has one that is not in use, such as when a removal is undone, and
+// is given a new one otherwise.
+Task IStorage::addTask(Task& task) {
+	QMutexLocker lock(&mutex);
+
+	QSharedPointer<Task> taskPtr = QSharedPointer<Task>::create(task);
+
+	LOG(INFO) << MSG_STORAGE_ADDING_TASK << task.getDescription().toStdString();
+
+	if (taskPtr->getUid() == 0 || byUid.contains(taskPtr->getUid())) {
+		lastUid++;
+		taskPtr->setUid(lastUid);
+	} else {
+		lastUid = qMax(lastUid, taskPtr->getUid());
+	}
+
+	order.insert(taskPtr, TimeSnapshot::current());
+	indexTask(taskPtr);
+	onTaskAdded(*taskPtr);
+
+	// the caller needs the ID of the new task, unless this is in a batch
+	changed();
+
+	return *taskPtr;
+}
+
+// Edits a task in memory.
+// In general, this is done by replacing the task with ID id with
+// a new task object. An archived task is brought back into memory first.
+Task IStorage::editTask(int id, Task& task) {
+	QMutexLocker lock(&mutex);
+	return replaceTask(liveTaskAt(id), task);
+}
+
+// Same as editTask(), but finds the task to replace by its unique ID. An
+// archived task is brought back into memory first.
+Task IStorage::editTaskByUid(quint64 uid, Task& task) {
+	QMutexLocker lock(&mutex);
+	QSharedPointer<Task> oldPtr = liveTask(uid);
+	assert(!oldPtr.isNull());
+	return replaceTask(oldPtr, task);
+}
+
+// Retrieves a task with ID id from the list of tasks in memory. IDs past the
+// tasks in memory are those of the archived tasks listed after them.
+Task IStorage::getTask(int id) const {
+	return *current()->getListed()[id];
+}
+
+// Retrieves the task with unique ID uid from the list of tasks in memory, or
+// from the archived tasks read back.
+Task IStorage::getTaskByUid(quint64 uid) {
+	QMutexLocker lock(&mutex);
+	QSharedPointer<Task> taskPtr = findTask(uid);
+	assert(!taskPtr.isNull());
+	return *taskPtr;
+}
+
+// Returns the ID that the task with unique ID uid has in the latest list of
+// tasks, or -1 if there is no such task.
+int IStorage::idOf(quint64 uid) {
+	QMutexLocker lock(&mutex);
+	catchUp();
+	return current()->positionOf(uid);
+}
+
+// Removes a task with ID id from the list of tasks in memory. An archived
+// task is brought back into memory first, so that its removal is saved.
+void IStorage::removeTask(int id) {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_REMOVING_TASK << id;
+	eraseTask(liveTaskAt(id));
+}
+
+// Removes the task with unique ID uid from the list of tasks in memory. An
+// archived task is brought back into memory first, so that its removal is
+// saved.
+void IStorage::removeTaskByUid(quint64 uid) {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_REMOVING_TASK_BY_UID << uid;
+	QSharedPointer<Task> taskPtr = liveTask(uid);
+	assert(!taskPtr.isNull());
+	eraseTask(taskPtr);
+}
+
+// Removes a task from the back of the list of tasks in memory.
+void IStorage::popTask() {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_POP_TASK;
+	catchUp();
+	assert(!tasks.isEmpty());
+	eraseTask(tasks.last());
+}
+
+// Replaces the task at oldPtr with a copy of task, which keeps the unique
+// ID of the old task. mutex must be held.
+Task IStorage::replaceTask(QSharedPointer<Task> oldPtr, Task& task) {
+	LOG(INFO) << MSG_STORAGE_REPLACING_TASK 
+		<< task.getDescription().toStdString();
+
+	QSharedPointer<Task> taskPtr = 
+		swapTask(oldPtr, task, TimeSnapshot::current());
+
+	// the caller needs the new ID of the task, unless this is in a batch
+	changed();
+
+	return *taskPtr;
+}
+
+// Removes the task at taskPtr. mutex must be held.
+void IStorage::eraseTask(QSharedPointer<Task> taskPtr) {
+	unlinkTask(taskPtr, TimeSnapshot::current());
+	changed();
+}
+
+// Puts a copy of task, with the unique ID of the old task, in place of the
+// task at oldPtr in the order and the indexes, and returns the copy. The list
+// of tasks is left to the caller. mutex must be held.
+QSharedPointer<Task> IStorage::swapTask(const QSharedPointer<Task>& oldPtr,
+										const Task& task,
+										const TimeSnapshot& now) {
+	QSharedPointer<Task> taskPtr = QSharedPointer<Task>::create(task);
+	taskPtr->setUid(oldPtr->getUid());
+
+	order.replace(*oldPtr, taskPtr, now);
+	unindexTask(oldPtr);
+	indexTask(taskPtr);
+	onTaskReplaced(*oldPtr, *taskPtr);
+
+	return taskPtr;
+}
+
+// Takes the task at taskPtr out of the order and the indexes. The list of
+// tasks is left to the caller. mutex must be held.
+void IStorage::unlinkTask(const QSharedPointer<Task>& taskPtr,
+						  const TimeSnapshot& now) {
+	order.remove(*taskPtr, now);
+	unindexTask(taskPtr);
+	onTaskRemoved(*taskPtr);
+}
+
+// Adds every task that next gives, until it returns false, as one bulk load:
+// the tasks are appended and indexed as they come, then sorted and published
+// once at the end, instead of once per task. next is called with a blank task
+// to fill in each time. Each task is given a new unique ID. Subclasses are
+// told about the whole load at once, through onTasksLoaded(). If added is
+// given, the new unique IDs are appended to it. Returns how many tasks were
+// added.
+int IStorage::bulkLoad(std::function<bool(Task&)> next,
+					   QVector<quint64>* added) {
+	QMutexLocker lock(&mutex);
+	catchUp();
+
+	int count = 0;
+	Task task;
+	while (next(task)) {
+		QSharedPointer<Task> taskPtr = QSharedPointer<Task>::create(task);
+		lastUid++;
+		taskPtr->setUid(lastUid);
+		indexTask(taskPtr);
+		tasks.push_back(taskPtr);
+		if (added != nullptr) {
+			added->push_back(lastUid);
+		}
+		count++;
+		task = Task();
+	}
+
+	LOG(INFO) << MSG_STORAGE_BULK_LOADED << count;
+	if (count == 0) {
+		return 0;
+	}
+
+	order.rebuild(tasks, TimeSnapshot::current());
+	onTasksLoaded(count);
+	changed();
+	return count;
+}
+
+// Removes the tasks with the unique IDs in uids in a single pass, and returns
+// copies of them in the same order. Archived tasks are brought back into
+// memory to be removed, and unique IDs that are in neither are skipped. The
+// list of tasks is rebuilt once at the end.
+QList<Task> IStorage::removeTasksByUid(const QVector<quint64>& uids) {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_REMOVING_TASKS << uids.size();
+
+	QList<Task> removed;
+	removed.reserve(uids.size());
+	TimeSnapshot now = TimeSnapshot::current();
+
+	foreach (quint64 uid, uids) {
+		QSharedPointer<Task> taskPtr = liveTask(uid);
+		if (taskPtr.isNull()) {
+			continue;
+		}
+		removed.push_back(*taskPtr);
+		unlinkTask(taskPtr, now);
+	}
+
+	if (!removed.isEmpty()) {
+		changed();
+	}
+	return removed;
+}
+
+// Applies change to a copy of each task with a unique ID in uids, and puts
+// the copies in place of the tasks in a single pass. Returns the tasks as
+// they were before, leaving out those that change did not alter, which are
+// not replaced at all. An archived task is only brought back into memory if
+// change alters it. The list of tasks is rebuilt once at the end.
+QList<Task> IStorage::editTasksByUid(const QVector<quint64>& uids,
+									 std::function<void(Task&)> change) {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_REPLACING_TASKS << uids.size();
+
+	QList<Task> old;
+	TimeSnapshot now = TimeSnapshot::current();
+
+	foreach (quint64 uid, uids) {
+		QSharedPointer<Task> oldPtr = findTask(uid);
+		if (oldPtr.isNull()) {
+			continue;
+		}
+
+		Task task = *oldPtr;
+		change(task);
+		if (task == *oldPtr) {
+			continue;
+		}
+
+		oldPtr = liveTask(uid);
+		old.push_back(*oldPtr);
+		swapTask(oldPtr, task, now);
+	}
+
+	if (!old.isEmpty()) {
+		changed();
+	}
+	return old;
+}
+
+// Puts each task in replacements in place of the task in memory with the same
+// unique ID, in a single pass, such as to undo editTasksByUid(). Tasks whose
+// unique ID is no longer in memory are skipped.
+void IStorage::replaceTasks(const QList<Task>& replacements) {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_REPLACING_TASKS << replacements.size();
+
+	TimeSnapshot now = TimeSnapshot::current();
+	foreach (const Task& task, replacements) {
+		QSharedPointer<Task> oldPtr = byUid.value(task.getUid());
+		if (!oldPtr.isNull()) {
+			swapTask(oldPtr, task, now);
+		}
+	}
+
+	changed();
+}
+
+// Adds the tasks in added with their unique IDs in a single pass, such as to
+// undo removeTasksByUid(). A task whose unique ID is already in memory is
+// skipped.
+void IStorage::addTasks(const QList<Task>& added) {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_ADDING_TASKS << added.size();
+	restoreTasks(added, true);
+}
+
+// Returns the task that is at the front of the list of tasks in
+// memorry. This task is guaranteed not to be 'overdue'.
+// This method throws ExceptionNoMoreTasks if there are no more tasks 
+// in memory that are not overdue.
+Task IStorage::getNextUpcomingTask() const {
+	LOG(INFO) << MSG_STORAGE_RETRIEVE_NEXT_TASK;
+
+	std::shared_ptr<const Revision> revision = current();
+	QDateTime now = TimeSnapshot::current().getDateTime();
+	foreach (const QSharedPointer<Task>& task, revision->getTasks()) {
+		if (task->getBegin() > now) {
+			return *task;
+		}
+	}
+	throw ExceptionNoMoreTasks();
+}
+
+// Read-only. Returns a view of the tasks in memory, leaving out the tasks
+// that are done if hideDone is true. Archived tasks that have been loaded
+// come after the rest if withArchived is true and hideDone is false. No task
+// is copied.
+TaskView IStorage::view(bool hideDone, bool withArchived) const {
+	if (hideDone) {
+		return query([](const Task& task) -> bool {
+			return !task.isDone();
+		});
+	}
+
+	if (withArchived) {
+		return TaskView(current()->getListed());
+	}
+	return TaskView(current()->getTasks());
+}
+
+// Read-only. Retrieves the entire list of tasks in memory.
+QList<Task> IStorage::getTasks(bool hideDone) const {
+	return view(hideDone).toList();
+}
+
+// Returns the total number of tasks in memory, and of the archived tasks
+// listed after them if withArchived is true.
+int IStorage::totalTasks(bool withArchived) const {
+	std::shared_ptr<const Revision> revision = current();
+	if (withArchived) {
+		return revision->size() + revision->getArchived().size();
+	}
+	return revision->size();
+}
+
+// Searches for tasks. Takes in a function as an argument and searches for
+// tasks with a criteria that is determined by the function. It is the caller's
+// responsibility for the function to be valid and correct, as this method 
+// makes no assumptions about the criteria.
+// Returns a view of the matching tasks, so neither the predicate nor the
+// results copy any task. The time is frozen for the whole search, so
+// predicates that ask whether a task is overdue or due today all use the
+// same time and the status each task has cached.
+TaskView IStorage::query(std::function<bool(const Task&)> predicate) const {
+	LOG(INFO) << MSG_STORAGE_SEARCH;
+	QVector<int> indexes;
+	FrozenTime frozen;
+
+	std::shared_ptr<const Revision> revision = current();
+	const QVector< QSharedPointer<Task> >& revisionTasks = revision->getTasks();
+
+	for (int i=0; i<revisionTasks.size(); i++) {
+		if (predicate(*revisionTasks[i])) {
+			indexes.push_back(i);
+		}
+	}
+
+	return TaskView(revisionTasks, indexes);
+}
+
+// Same as query(), but copies the matching tasks into a list.
+QList<Task> IStorage::search(std::function<bool(const Task&)> predicate) const {
+	return query(predicate).toList();
+}
+
+// Returns a view of all tasks that pass filter, in display order. The filter
+// runs over the columns of the latest revision instead of over each task.
+// If withArchived is true, the archived tasks that pass are read back and
+// listed after them.
+TaskView IStorage::query(TaskTable::Filter filter, bool withArchived) {
+	LOG(INFO) << MSG_STORAGE_SEARCH;
+	if (withArchived) {
+		loadArchive();
+	}
+	FrozenTime frozen;
+	TimeSnapshot now = TimeSnapshot::current();
+
+	std::shared_ptr<const Revision> revision = current();
+	QVector<int> indexes = revision->getTable().select(filter, now);
+	if (!withArchived) {
+		return TaskView(revision->getTasks(), indexes);
+	}
+	return listedView(*revision, indexes,
+		revision->getArchiveTable().select(filter, now));
+}
+
+// Same as query(), but copies the matching tasks into a list.
+QList<Task> IStorage::search(TaskTable::Filter filter) {
+	return query(filter).toList();
+}
+
+// Searches all descriptions of all tasks in memory for specified keyword(s).
+// Returns a view of all tasks that contain the keyword in its description,
+// in display order. Only the tasks that the description index picks out as
+// candidates are checked.
+// Searches by any part of the description. Case insensitive is the default.
+// If withArchived is true, the archived tasks that match are read back and
+// listed after them.
+TaskView IStorage::queryByDescription(QString keyword, 
+									  Qt::CaseSensitivity caseSensitivity,
+									  bool withArchived) {
+	if (withArchived) {
+		loadArchive();
+	}
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_SEARCH_BY_DESCRIPTION << keyword.toStdString();
+	catchUp();
+
+	QList<const Task*> matches = descriptionIndex.find(keyword,
+		caseSensitivity);
+	if (!withArchived) {
+		return viewOf(matches);
+	}
+
+	std::shared_ptr<const Revision> revision = current();
+	return listedView(*revision, positionsOf(*revision, matches),
+		revision->getArchiveTable().selectDescription(keyword,
+		caseSensitivity));
+}
+
+// Same as queryByDescription(), but copies the matching tasks into a list.
+QList<Task> IStorage::searchByDescription(QString keyword, 
+										  Qt::CaseSensitivity caseSensitivity) {
+	return queryByDescription(keyword, caseSensitivity).toList();
+}
+
+// Searches all tags in all tasks in memory for specified tag.
+// Returns a view of all tasks that contain that tag, each task only once and
+// in display order.
+// Will also return partial results (if tag contains the searched keyword)
+// Case insensitive is the default. If withArchived is true, the archived
+// tasks that match are read back and listed after them.
+TaskView IStorage::queryByTag(QString keyword, 
+							  Qt::CaseSensitivity caseSensitivity,
+							  bool withArchived) {
+	if (withArchived) {
+		loadArchive();
+	}
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_SEARCH_BY_TAG << keyword.toStdString();
+	catchUp();
+
+	QList<const Task*> matches = tagIndex.find(keyword, caseSensitivity);
+	if (!withArchived) {
+		return viewOf(matches);
+	}
+
+	// the archive is not indexed, so its tags are checked task by task
+	std::shared_ptr<const Revision> revision = current();
+	const QVector< QSharedPointer<Task> >& archivedTasks =
+		revision->getArchived();
+	QVector<int> archivedRows;
+	for (int i=0; i<archivedTasks.size(); i++) {
+		foreach (const QString& tag, archivedTasks[i]->getTags()) {
+			if (tag.contains(keyword, caseSensitivity)) {
+				archivedRows.push_back(i);
+				break;
+			}
+		}
+	}
+
+	return listedView(*revision, positionsOf(*revision, matches),
+		archivedRows);
+}
+
+// Returns a view of all tasks that have a tag named tag, ignoring case, in
+// display order. Unlike queryByTag(), the whole name must match. This runs
+// over the columns of the latest revision. If withArchived is true, the
+// archived tasks with the tag are read back and listed after them.
+TaskView IStorage::queryWithTag(QString tag, bool withArchived) {
+	LOG(INFO) << MSG_STORAGE_SEARCH_BY_TAG << tag.toStdString();
+	if (withArchived) {
+		loadArchive();
+	}
+
+	std::shared_ptr<const Revision> revision = current();
+	QVector<int> indexes = revision->getTable().selectTag(tag);
+	if (!withArchived) {
+		return TaskView(revision->getTasks(), indexes);
+	}
+	return listedView(*revision, indexes,
+		revision->getArchiveTable().selectTag(tag));
+}
+
+// Same as queryByTag(), but copies the matching tasks into a list.
+QList<Task> IStorage::searchByTag(QString keyword, 
+								  Qt::CaseSensitivity caseSensitivity) {
+	return queryByTag(keyword, caseSensitivity).toList();
+}
+
+// Returns a view of matches in display order, made from the latest revision.
+// mutex must be held to make sure that no newer revision is published in
+// between, and the tasks must have been caught up with any open batch.
+TaskView IStorage::viewOf(const QList<const Task*>& matches) const {
+	std::shared_ptr<const Revision> revision = current();
+	return TaskView(revision->getTasks(), positionsOf(*revision, matches));
+}
+
+// Returns the positions of matches in revision, in display order.
+QVector<int> IStorage::positionsOf(const Revision& revision,
+								   const QList<const Task*>& matches) {
+	QVector<int> indexes;
+	indexes.reserve(matches.size());
+
+	foreach (const Task* task, matches) {
+		indexes.push_back(revision.positionOf(task->getUid()));
+	}
+	qSort(indexes.begin(), indexes.end());
+
+	return indexes;
+}
+
+// Returns a view of the tasks of revision at indexes, followed by the
+// archived tasks at archivedRows of its archive, with the IDs they are
+// listed at.
+TaskView IStorage::listedView(const Revision& revision, QVector<int> indexes,
+							  const QVector<int>& archivedRows) {
+	indexes.reserve(indexes.size() + archivedRows.size());
+	foreach (int row, archivedRows) {
+		indexes.push_back(revision.size() + row);
+	}
+
+	return TaskView(revision.getListed(), indexes);
+}
+
+// Retrieves the next available free time.
+// Starts by assuming that the current time is free. If events are going on
+// now, the next available free time is when the last of the events that
+// overlap or follow on from them ends.
+QString IStorage::nextFreeTime() {
+	LOG(INFO) << MSG_STORAGE_NEXT_FREE_TIME;
+	QMutexLocker lock(&mutex);
+	qint64 now = TimeSnapshot::current().getMSecs();
+	qint64 nextAvailable = intervals.nextFreeSlot(now, 0);
+
+	qint64 delta = nextAvailable - now;
+
+	if (delta <= MSECS_IN_SECOND * SECONDS_IN_MINUTE) {
+		return MSG_STORAGE_FREE_NOW;
+	}
+
+	QString result = 
+		Task::getTimeDifference(QDateTime::fromMSecsSinceEpoch(nextAvailable));
+	result.prepend(MSG_STORAGE_FREE_IN);
+	return result;
+}
+
+// Returns the earliest time from now at which there is a gap between events
+// at least length milliseconds long.
+QDateTime IStorage::nextFreeSlot(qint64 length) {
+	LOG(INFO) << MSG_STORAGE_NEXT_FREE_SLOT << length;
+	QMutexLocker lock(&mutex);
+	qint64 now = TimeSnapshot::current().getMSecs();
+	return QDateTime::fromMSecsSinceEpoch(intervals.nextFreeSlot(now, length));
+}
+
+// Returns every gap between events from begin to end that is at least
+// minimum milliseconds long, earliest first.
+QList<FreeSlot> IStorage::freeSlots(QDateTime begin, QDateTime end,
+									qint64 minimum) {
+	LOG(INFO) << MSG_STORAGE_FINDING_FREE_SLOTS << begin.toString().toStdString()
+		<< " - " << end.toString().toStdString();
+	QMutexLocker lock(&mutex);
+	QList<FreeSlot> results;
+
+	QList<IntervalIndex::Interval> gaps = intervals.freeSlots(
+		begin.toMSecsSinceEpoch(), end.toMSecsSinceEpoch(), minimum);
+	foreach (const IntervalIndex::Interval& gap, gaps) {
+		results.push_back(FreeSlot(QDateTime::fromMSecsSinceEpoch(gap.first),
+			QDateTime::fromMSecsSinceEpoch(gap.second)));
+	}
+
+	return results;
+}
+
+// Returns a view of the events that overlap the period from begin to end,
+// in display order.
+TaskView IStorage::queryOverlapping(QDateTime begin, QDateTime end) {
+	QMutexLocker lock(&mutex);
+	catchUp();
+	return viewOf(intervals.overlapping(begin.toMSecsSinceEpoch(),
+		end.toMSecsSinceEpoch()));
+}
+
+// Returns true if every task in memory is done.
+// Returns false if any task in memory is not done.
+bool IStorage::isAllDone() const {
+	bool _isAllDone = true;
+	std::shared_ptr<const Revision> revision = current();
+	foreach (const QSharedPointer<Task>& task, revision->getTasks()) {
+		if (!task->isDone()) {
+			_isAllDone = false;
+		}
+	}
+	return _isAllDone;
+}
+
+// Opens a batch of changes. Until the matching commit(), changes still
+// update the order and the indexes as they are made, but the list of tasks
+// is not rebuilt, renumbered or published, so the IDs of the tasks returned
+// by addTask() and editTask() are not meaningful. Tasks should be looked up
+// by unique ID instead. Batches can be nested, and only the outermost
+// commit() publishes.
+void IStorage::beginBatch() {
+	QMutexLocker lock(&mutex);
+	batchDepth++;
+}
+
+// Closes the batch opened by the last beginBatch(). If it was the outermost
+// one, the changes made in it are published together as one revision.
+void IStorage::commit() {
+	QMutexLocker lock(&mutex);
+	assert(batchDepth > 0);
+	batchDepth--;
+	if (batchDepth == 0) {
+		catchUp();
+	}
+}
+
+// Returns whether a batch is open.
+bool IStorage::inBatch() {
+	QMutexLocker lock(&mutex);
+	return batchDepth > 0;
+}
+
+// Returns the number of the latest revision, which goes up with every
+// published change.
+quint64 IStorage::getRevisionNumber() const {
+	return current()->getNumber();
+}
+
+// Rebuilds the order and search indexes of all tasks in memory from scratch
+// and renumbers them. Only needed after the list of tasks has been changed
+// directly, such as when loading, as every other change updates them
+// incrementally. Tasks loaded from files written before tasks had unique IDs
+// are given one here, in the order they are in the list.
+void IStorage::renumber() {
+	QMutexLocker lock(&mutex);
+	lastUid = reservedUid;
+	foreach (const QSharedPointer<Task>& task, tasks) {
+		lastUid = qMax(lastUid, task->getUid());
+	}
+
+	clearIndexes();
+	foreach (const QSharedPointer<Task>& task, tasks) {
+		if (task->getUid() == 0 || byUid.contains(task->getUid())) {
+			lastUid++;
+			task->setUid(lastUid);
+		}
+		indexTask(task);
+	}
+	order.rebuild(tasks, TimeSnapshot());
+	LOG(INFO) << MSG_STORAGE_DESCRIPTION_INDEX
+		<< descriptionIndex.trigramCount() << ", "
+		<< descriptionIndex.postingCount() << ", "
+		<< descriptionIndex.memoryUsage();
+	materialize();
+}
+
+// Brings the list of tasks in memory up to date with the order after a
+// change, and publishes it. mutex must be held.
+void IStorage::materialize() {
+	tasks = order.toList();
+	publish();
+}
+
+// Materializes the tasks after a change, or leaves it to commit() if a
+// batch is open. mutex must be held.
+void IStorage::changed() {
+	if (batchDepth > 0) {
+		batchDirty = true;
+		return;
+	}
+	materialize();
+}
+
+// Returns whether the tasks in memory are still as they were published in
+// revision, with no batch open that may have changed them since. mutex must
+// be held.
+bool IStorage::unchangedSince(quint64 revision) const {
+	return batchDepth == 0 && revisionNumber == revision;
+}
+
+// Materializes the tasks if a batch has changed them since, so that they can
+// be looked up by ID. mutex must be held.
+void IStorage::catchUp() {
+	if (batchDirty) {
+		batchDirty = false;
+		materialize();
+	}
+}
+
+// Publishes the list of tasks in memory as a new revision, which readers
+// pick up from then on, together with the archived tasks that are still
+// archived. Readers that still hold an older revision keep it until they are
+// done with it. mutex must be held.
+void IStorage::publish() {
+	if (archivedDirty) {
+		archivedDirty = false;
+		QVector< QSharedPointer<Task> > stillArchived;
+		stillArchived.reserve(archivedByUid.size());
+		foreach (const QSharedPointer<Task>& task, archived) {
+			if (archivedByUid.contains(task->getUid())) {
+				stillArchived.push_back(task);
+			}
+		}
+		archived = stillArchived;
+	}
+
+	revisionNumber++;
+	std::atomic_store(&published, std::make_shared<const Revision>(tasks,
+		archived, revisionNumber));
+}
+
+// Returns the latest revision of the tasks in memory. This never waits for
+// a change in progress, and is safe to call from any thread.
+std::shared_ptr<const Revision> IStorage::current() const {
+	return std::atomic_load(&published);
+}
+
+// Adds task to the unique ID, tag, description and interval indexes.
+void IStorage::indexTask(const QSharedPointer<Task>& task) {
+	byUid.insert(task->getUid(), task);
+	tagIndex.insert(task.data());
+	descriptionIndex.insert(task.data());
+	intervals.insert(task.data());
+}
+
+// Removes task from the unique ID, tag, description and interval indexes.
+void IStorage::unindexTask(const QSharedPointer<Task>& task) {
+	byUid.remove(task->getUid());
+	tagIndex.remove(task.data());
+	descriptionIndex.remove(task.data());
+	intervals.remove(task.data());
+}
+
+// Empties the unique ID, tag, description and interval indexes.
+void IStorage::clearIndexes() {
+	byUid.clear();
+	tagIndex.clear();
+	descriptionIndex.clear();
+	intervals.clear();
+}
+
+// Removes the tasks that pass predicate from memory and returns copies of
+// them. Subclasses are not told about the removal, as the tasks are meant to
+// be kept somewhere else. mutex must be held.
+QList<Task> IStorage::takeTasks(std::function<bool(const Task&)> predicate) {
+	QList<Task> taken;
+	TimeSnapshot now = TimeSnapshot::current();
+
+	foreach (const QSharedPointer<Task>& task, tasks) {
+		if (predicate(*task)) {
+			taken.push_back(*task);
+			order.remove(*task, now);
+			unindexTask(task);
+		}
+	}
+
+	if (!taken.isEmpty()) {
+		materialize();
+	}
+	return taken;
+}
+
+// Puts tasks that were kept outside of memory back, with their unique IDs.
+// A task whose unique ID is already in memory is skipped, as the copy in
+// memory is the newer one. Subclasses are told about each task added only
+// if notify is true. mutex must be held.
+void IStorage::restoreTasks(const QList<Task>& restored, bool notify) {
+	TimeSnapshot now = TimeSnapshot::current();
+
+	foreach (const Task& task, restored) {
+		if (byUid.contains(task.getUid())) {
+			continue;
+		}
+
+		QSharedPointer<Task> taskPtr = QSharedPointer<Task>::create(task);
+		if (taskPtr->getUid() == 0) {
+			lastUid++;
+			taskPtr->setUid(lastUid);
+		}
+		lastUid = qMax(lastUid, taskPtr->getUid());
+
+		order.insert(taskPtr, now);
+		indexTask(taskPtr);
+		if (notify) {
+			onTaskAdded(*taskPtr);
+		}
+	}
+
+	changed();
+}
+
+// Makes the tasks in memory the same as latest, which holds every task as
+// it is somewhere else, such as on disk, with their unique IDs. Tasks
+// without one, such as tasks added to the .ini file by hand, and tasks with
+// one already taken by an earlier task in latest, such as a copied task, are
+// given new ones. Only the tasks that were added, removed or changed are
+// touched, and subclasses are not told about any of it, as the change is
+// already wherever latest came from. Returns the number of tasks that
+// changed. mutex must be held.
+int IStorage::absorbTasks(const QVector< QSharedPointer<Task> >& latest) {
+	catchUp();
+	TimeSnapshot now = TimeSnapshot::current();
+	QSet<quint64> seen;
+	int changes = 0;
+
+	foreach (const QSharedPointer<Task>& task, latest) {
+		lastUid = qMax(lastUid, task->getUid());
+	}
+
+	foreach (const QSharedPointer<Task>& task, latest) {
+		if (task->getUid() == 0 || seen.contains(task->getUid())) {
+			lastUid++;
+			task->setUid(lastUid);
+		}
+
+		quint64 uid = task->getUid();
+		seen.insert(uid);
+
+		QSharedPointer<Task> current = byUid.value(uid);
+		if (current.isNull()) {
+			if (archivedByUid.remove(uid) > 0) {
+				archivedDirty = true;
+			}
+			lastUid = qMax(lastUid, uid);
+			order.insert(task, now);
+			indexTask(task);
+			changes++;
+		} else if (*current != *task) {
+			order.replace(*current, task, now);
+			unindexTask(current);
+			indexTask(task);
+			changes++;
+		}
+	}
+
+	foreach (const QSharedPointer<Task>& task, tasks) {
+		if (!seen.contains(task->getUid())) {
+			order.remove(*task, now);
+			unindexTask(task);
+			changes++;
+		}
+	}
+
+	if (changes > 0) {
+		changed();
+	}
+	return changes;
+}
+
+// Keeps the unique IDs up to uid from being given to new tasks, such as the
+// IDs of tasks kept outside of memory. mutex must be held.
+void IStorage::reserveUids(quint64 uid) {
+	reservedUid = qMax(reservedUid, uid);
+	lastUid = qMax(lastUid, uid);
+}
+
+// Lists archivedTasks, read back from outside of memory, after the tasks in
+// memory from the next revision on, in place of any listed before. They stay
+// read-only until one is changed. A task whose unique ID is in memory is
+// skipped, as the copy in memory is the newer one. mutex must be held.
+void IStorage::setArchived(const QList<Task>& archivedTasks) {
+	if (archived.isEmpty() && archivedTasks.isEmpty()) {
+		return;
+	}
+
+	archived.clear();
+	archivedByUid.clear();
+	archivedDirty = false;
+	archived.reserve(archivedTasks.size());
+	foreach (const Task& task, archivedTasks) {
+		quint64 uid = task.getUid();
+		if (byUid.contains(uid) || archivedByUid.contains(uid)) {
+			continue;
+		}
+
+		QSharedPointer<Task> taskPtr = QSharedPointer<Task>::create(task);
+		archived.push_back(taskPtr);
+		archivedByUid.insert(uid, taskPtr);
+	}
+
+	publish();
+}
+
+// Returns the task with unique ID uid in memory, or else the archived task
+// read back with it, or null if there is neither. mutex must be held.
+QSharedPointer<Task> IStorage::findTask(quint64 uid) const {
+	QSharedPointer<Task> taskPtr = byUid.value(uid);
+	if (taskPtr.isNull()) {
+		taskPtr = archivedByUid.value(uid);
+	}
+	return taskPtr;
+}
+
+// Returns the task with unique ID uid in memory, bringing it back into memory
+// first if it is an archived task read back, or null if there is neither.
+// mutex must be held.
+QSharedPointer<Task> IStorage::liveTask(quint64 uid) {
+	QSharedPointer<Task> taskPtr = byUid.value(uid);
+	if (taskPtr.isNull() && archivedByUid.contains(uid)) {
+		taskPtr = unarchiveTask(uid);
+	}
+	return taskPtr;
+}
+
+// Returns the task with ID id in the latest list of tasks. IDs past the tasks
+// in memory are those of the archived tasks listed after them, which are
+// brought back into memory first. mutex must be held.
+QSharedPointer<Task> IStorage::liveTaskAt(int id) {
+	catchUp();
+	if (id >= 0 && id < tasks.size()) {
+		return tasks[id];
+	}
+
+	std::shared_ptr<const Revision> revision = current();
+	const QVector< QSharedPointer<Task> >& listed = revision->getListed();
+	assert(id >= 0 && id < listed.size());
+	return liveTask(listed[id]->getUid());
+}
+
+// Moves the archived task with unique ID uid back into memory, so that it can
+// be changed, and returns it. Subclasses are told about it as an added task,
+// then through onTaskUnarchived(). It stays listed as archived until the next
+// publish(). mutex must be held.
+QSharedPointer<Task> IStorage::unarchiveTask(quint64 uid) {
+	QSharedPointer<Task> taskPtr = archivedByUid.take(uid);
+	archivedDirty = true;
+
+	LOG(INFO) << MSG_STORAGE_UNARCHIVING_TASK << uid;
+
+	order.insert(taskPtr, TimeSnapshot::current());
+	indexTask(taskPtr);
+	onTaskAdded(*taskPtr);
+	onTaskUnarchived(*taskPtr);
+	return taskPtr;
+}
+
+// Removes all tasks that are done from memory.
+void IStorage::clearAllDone() {
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_CLEAR_ALL_DONE_TASKS;
+	catchUp();
+	TimeSnapshot now = TimeSnapshot::current();
+	foreach (const QSharedPointer<Task>& task, tasks) {
+		if (task->isDone()) {
+			order.remove(*task, now);
+			unindexTask(task);
+		}
+	}
+	onTasksCleared(true);
+	changed();
+}
+
+// Removes all tasks from memory regardless of status. The tasks themselves
+// are only freed once mutex is released, so that readers and writers do not
+// wait while each of them is freed.
+void IStorage::clearAllTasks() {
+	// Declared before lock, so that it is destroyed after lock is.
+	QHash<quint64, QSharedPointer<Task> > cleared;
+
+	QMutexLocker lock(&mutex);
+	LOG(INFO) << MSG_STORAGE_CLEAR_ALL_TASKS;
+	cleared = byUid;
+	tasks.clear();
+	order.clear();
+	clearIndexes();
+	onTasksCleared(false);
+	batchDirty = false;
+	publish();
+}
+
+// The default constructor for Storage automatically sets the path of the
+// save files to be %APPDATA%/Tasuke. Whether the journal is used is read
+// from the user's settings and defaults to true.
+Storage::Storage() {
+	LOG(INFO) << MSG_STORAGE_INSTANCE_CREATED;
+
+	QDir dir = QDir(QStandardPaths::writableLocation(
+		QStandardPaths::DataLocation));
+
+	path = dir.absoluteFilePath("tasks.ini");
+
+	init();
+
+	QSettings settings(QSettings::IniFormat, QSettings::UserScope, "Tasuke", "Tasuke");
+	journaled = settings.value("JournaledStorage", true).toBool();
+	DurabilityPolicy policy = (DurabilityPolicy) settings.value("DurabilityPolicy",
+		(char) DurabilityPolicy::IMMEDIATE).toInt();
+	int interval = settings.value("DurabilityInterval",
+		DURABILITY_INTERVAL_DEFAULT).toInt();
+	worker->setPolicy(policy, interval);
+	archiveAge = settings.value("ArchiveAge", ARCHIVE_AGE_DEFAULT).toInt();
+}
+
+// This constructor for Storage takes in a filepath as an argument.
+// Storage will import from the .ini file at that path and keep its binary
+// snapshot and journals next to it.
+Storage::Storage(QString _path) {
+	LOG(INFO) << MSG_STORAGE_INSTANCE_CREATED_NONDEFAULT;
+
+	path = _path;
+
+	init();
+}
+
+// Writes any pending changes and waits for any reload, compaction or
+// archiving that is still running so that nothing is lost on exit.
+Storage::~Storage() {
+	delete watcher;
+	watcher = nullptr;
+	reloadTimer.stop();
+
+	if (reloadThread.joinable()) {
+		reloadThread.join();
+	}
+
+	if (archiveThread.joinable()) {
+		archiveThread.join();
+	}
+
+	delete worker;
+	worker = nullptr;
+
+	if (journaled) {
+		QMutexLocker lock(&mutex);
+		journal.flush();
+	}
+
+	waitForCompaction();
+}
+
+// Common initialization for both constructors.
+void Storage::init() {
+	journaled = true;
+	generation = 0;
+	oldestGeneration = 0;
+	compacting = false;
+	compactionDue = false;
+	upgrading = false;
+	archiveAge = 0;
+	archiveLoaded = false;
+	watcher = nullptr;
+	reloading = false;
+	worker = new PersistenceWorker([this]() {
+		writeToDisk();
+	});
+
+	reloadTimer.setSingleShot(true);
+	reloadTimer.setInterval(RELOAD_DELAY);
+	QObject::connect(&reloadTimer, &QTimer::timeout, [this]() {
+		startReload();
+	});
+
+	// runs on the thread this instance belongs to, whichever thread reloaded
+	QObject::connect(this, &Storage::reloaded, this, [this](int changes) {
+		// a sync tool may have replaced the files rather than written to them
+		watch();
+		if (changes > 0) {
+			NotificationManager::instance().init(this);
+		}
+	});
+
+	qRegisterMetaType<Task>("Task");
+	qRegisterMetaTypeStreamOperators<Task>("Task");
+}
+
+// Turns the journal on or off. When it is off, every saveFile() rewrites the
+// entire snapshot. This should be called before loadFile().
+void Storage::setJournaled(bool _journaled) {
+	journaled = _journaled;
+
+	if (!journaled) {
+		QMutexLocker lock(&mutex);
+		journal.close();
+	}
+}
+
+// Returns the path of the binary snapshot, which sits next to the .ini file.
+QString Storage::snapshotPath() const {
+	QFileInfo info(path);
+	QDir dir = info.absoluteDir();
+
+	return dir.absoluteFilePath(info.completeBaseName() + SNAPSHOT_EXTENSION);
+}
+
+// Returns the path of the archive of old done tasks, which sits next to the
+// .ini file.
+QString Storage::archivePath() const {
+	QFileInfo info(path);
+	QDir dir = info.absoluteDir();
+
+	return dir.absoluteFilePath(info.completeBaseName() + ARCHIVE_EXTENSION);
+}
+
+// Returns the path of the journal file for a generation. A new generation is
+// started every time the journal is compacted into the snapshot.
+QString Storage::journalPath(int _generation) const {
+	QFileInfo info(path);
+	QDir dir = info.absoluteDir();
+
+	return dir.absoluteFilePath(info.completeBaseName() + "-"
+		+ QString::number(_generation) + JOURNAL_EXTENSION);
+}
+
+// This function loads the snapshot into memory and then replays the
+// journal on top of it, so that memory reflects every change that was saved.
+// The tasks are filled in with mutex held. If there is no such file, this
+// function does nothing.
+// Files written before tasks had unique IDs are upgraded right away: the
+// unique IDs given to their tasks are written to a new snapshot before any
+// journal record can refer to them. Afterwards the files are watched for
+// changes made outside Tasuke.
+void Storage::loadFile() {
+	LOG(INFO) << MSG_STORAGE_LOAD_FILE_START;
+
+	upgrading = false;
+	{
+		QMutexLocker lock(&mutex);
+		archiveLoaded = false;
+		setArchived(QList<Task>());
+		loadSnapshot(tasks);
+
+		if (journaled) {
+			replayJournals(tasks);
+		}
+	}
+
+	reserveArchivedUids();
+	renumber();
+	NotificationManager::instance().init(this);
+
+	if (upgrading) {
+		LOG(INFO) << MSG_STORAGE_UPGRADING;
+	}
+
+	if (journaled && (upgrading
+		|| journal.recordCount() >= JOURNAL_COMPACTION_THRESHOLD)) {
+		compact();
+	} else if (upgrading) {
+		worker->markDirty();
+	}
 
-	QSharedPointer<Task> taskPtr = QSharedPointer<Task>(new Task(task));
+	if (upgrading) {
+		waitForCompaction();
+	}
 
-	LOG(INFO) << MSG_STORAGE_ADDING_TASK << task.getDescription().toStdString();
+	archive();
 
-	tasks.push_back(taskPtr);
-	renumber();
+	{
+		QMutexLocker lock(&mutex);
+		rememberDiskState();
+	}
+	watch();
 
-	return *taskPtr;
+	LOG(INFO) << MSG_STORAGE_LOAD_FILE_END;
 }
 
-// Edits a task in memory.
-// In general, this is done by replacing the task with ID id with
-// a new task object.
-Task IStorage::editTask(int id, Task& task) {
-	QMutexLocker lock(&mutex);
+// Schedules the changes made since the last save to be written to disk by
+// the persistence worker, and returns without waiting for the write.
+void Storage::saveFile() {
+	LOG(INFO) << MSG_STORAGE_SAVE_FILE_START;
 
-	QSharedPointer<Task> taskPtr = QSharedPointer<Task>(new Task(task));
+	worker->markDirty();
+	NotificationManager::instance().init(this);
 
-	LOG(INFO) << MSG_STORAGE_REPLACING_TASK 
-		<< task.getDescription().toStdString();
+	LOG(INFO) << MSG_STORAGE_SAVE_FILE_END;
+}
 
-	tasks.replace(id, taskPtr);
-	renumber();
+// Blocks until every change passed to saveFile() is on disk.
+void Storage::flush() {
+	worker->flush();
+}
 
-	return *taskPtr;
+// Sets when the persistence worker writes changes to disk. See
+// PersistenceWorker::setPolicy().
+void Storage::setDurabilityPolicy(DurabilityPolicy policy, int interval) {
+	worker->setPolicy(policy, interval);
 }
 
-// Retrieves a task with ID id from the list of tasks in memory.
-Task IStorage::getTask(int id) {
-	QMutexLocker lock(&mutex);
-	return *tasks[id];
+// Sets how many days after it ended a done task is archived. 0 turns
+// archiving off. This should be called before loadFile().
+void Storage::setArchiveAge(int days) {
+	archiveAge = days;
 }
 
-// Removes a task with ID id from the list of tasks in memory.
-void IStorage::removeTask(int id) {
+// Reads the archived tasks so that the done tasks shown and the search
+// results can list them. Nothing is written: the tasks stay in the archive
+// and out of memory until one of them is changed. Only the first call after
+// loading reads the archive. The tasks still waiting to be archived are
+// listed too, as the archive thread may not have written them yet. The file
+// is only ever replaced whole, so it is read as it was either before or
+// after such a write.
+void Storage::loadArchive() {
 	QMutexLocker lock(&mutex);
-	LOG(INFO) << MSG_STORAGE_REMOVING_TASK << id;
+	if (archiveLoaded) {
+		return;
+	}
+	archiveLoaded = true;
+
+	QList<Task> archivedTasks = pendingArchive;
+	{
+		Snapshot snapshot;
+		if (snapshot.open(archivePath())) {
+			for (int i=0; i<snapshot.size(); i++) {
+				if (!unarchived.contains(snapshot.uid(i))) {
+					archivedTasks.push_back(snapshot.task(i));
+				}
+			}
+		}
+	}
 
-	tasks.removeAt(id);
-	renumber();
+	LOG(INFO) << MSG_STORAGE_LOADING_ARCHIVE << archivedTasks.size();
+	setArchived(archivedTasks);
 }
 
-// Removes a task from the back of the list of tasks in memory.
-void IStorage::popTask() {
-	QMutexLocker lock(&mutex);
-	LOG(INFO) << MSG_STORAGE_POP_TASK;
+// Brings memory up to date with changes made to the saved tasks by something
+// other than this instance, such as a sync tool, another copy of Tasuke or an
+// edit to the .ini file. Nothing is waited for or read if the files are as
+// this instance left them. Otherwise pending changes are written first, and
+// any compaction or archiving still running is waited for, so that the files
+// only differ from memory by what was changed outside. Only the tasks that
+// differ are applied to memory, and reloaded() is emitted. Returns the number
+// of tasks that changed. This waits for the disk, so the file watcher runs it
+// on another thread through startReload().
+// The files are read without mutex, so that changes to the tasks do not wait
+// for the disk. If the tasks or the files changed while they were read, they
+// are read again.
+int Storage::reload() {
+	{
+		QMutexLocker lock(&mutex);
+		if (readDiskState() == diskState) {
+			return 0;
+		}
+	}
 
-	tasks.pop_back();
-	renumber();
-}
+	int changes = 0;
+	bool replaced = false;
+	while (true) {
+		flush();
+
+		QStringList readState;
+		quint64 revision = 0;
+		{
+			QMutexLocker lock(&mutex);
+			while (compacting || !pendingArchive.isEmpty()) {
+				idle.wait(&mutex);
+			}
+			if (readDiskState() == diskState) {
+				return 0;
+			}
 
-// Returns the task that is at the front of the list of tasks in
-// memorry. This task is guaranteed not to be 'overdue'.
-// This method throws ExceptionNoMoreTasks if there are no more tasks 
-// in memory that are not overdue.
-Task IStorage::getNextUpcomingTask() {
-	LOG(INFO) << MSG_STORAGE_RETRIEVE_NEXT_TASK;
+			LOG(INFO) << MSG_STORAGE_RELOADING;
 
-	foreach (QSharedPointer<Task> task, tasks) {
-		if (task->getBegin() > QDateTime::currentDateTime()) {
-			return *task;
+			// changes made since the flush must be on disk before it is read
+			if (journaled) {
+				journal.flush();
+			}
+			readState = readDiskState();
+			revision = getRevisionNumber();
+		}
+
+		QVector< QSharedPointer<Task> > loaded;
+		int loadedOldest = 0;
+		int records = 0;
+		bool upgrade = false;
+		int loadedGeneration = readSnapshot(loaded, loadedOldest, upgrade);
+		if (journaled) {
+			loadedGeneration = readJournals(loadedGeneration, loaded, records,
+				upgrade);
+		}
+
+		QMutexLocker lock(&mutex);
+		if (compacting || !pendingArchive.isEmpty()
+			|| readDiskState() != readState || !unchangedSince(revision)) {
+			LOG(INFO) << MSG_STORAGE_RELOAD_RETRY;
+			continue;
+		}
+
+		generation = loadedGeneration;
+		oldestGeneration = loadedOldest;
+		upgrading = upgrade;
+		if (journaled) {
+			journal.open(journalPath(generation), records);
 		}
+
+		changes = absorbTasks(loaded);
+
+		// the tasks came from the .ini file or an older snapshot, which a new
+		// snapshot replaces on the next save
+		replaced = upgrading;
+		if (replaced) {
+			compactionDue = true;
+		}
+		rememberDiskState();
+		break;
 	}
-	throw ExceptionNoMoreTasks();
+
+	if (replaced) {
+		worker->markDirty();
+	}
+
+	LOG(INFO) << MSG_STORAGE_RELOADED << changes;
+	emit reloaded(changes);
+	return changes;
 }
 
-// Read-only. Retrieves the entire list of tasks in memory.
-QList<Task> IStorage::getTasks(bool hideDone) const {
-	QList<Task> results;
+// Runs on the persistence worker's thread. When journaled, this function
+// writes the changes made since the last write to the journal, which costs
+// time proportional to the size of the changes. The journal is compacted in
+// the background once it grows long enough. Otherwise the whole list of
+// tasks is written to the snapshot.
+void Storage::writeToDisk() {
+	LOG(INFO) << MSG_STORAGE_WRITE_START;
+
+	// tasks brought back from the archive are only dropped from it once the
+	// journal or snapshot written here has them
+	QSet<quint64> dropped;
+
+	if (journaled) {
+		int records = 0;
+		bool due = false;
+		{
+			QMutexLocker lock(&mutex);
+			journal.flush();
+			records = journal.recordCount();
+			due = compactionDue;
+			dropped = unarchived;
+		}
+		journal.sync();
+		dropUnarchived(dropped);
 
-	if (hideDone) {
-		results = search([](Task task) -> bool {
-			return !task.isDone();
-		});
+		// loaded tasks are not in the journal, so they must not wait for a
+		// later compaction
+		if (due || records >= JOURNAL_COMPACTION_THRESHOLD) {
+			compact(due);
+		}
+
+		QMutexLocker lock(&mutex);
+		rememberDiskState();
 	} else {
-		foreach (QSharedPointer<Task> task, tasks) {
-			results.push_back(*task);
+		QList<Task> snapshot;
+		int snapshotGeneration = 0;
+		{
+			QMutexLocker lock(&mutex);
+			snapshot = snapshotTasks();
+			compactionDue = false;
+			dropped = unarchived;
+
+			// journals older than the snapshot are ignored when loading
+			generation++;
+			snapshotGeneration = generation;
+		}
+
+		bool written = writeSnapshot(snapshotPath(), snapshot,
+			snapshotGeneration);
+		if (written) {
+			dropUnarchived(dropped);
+		}
+
+		QMutexLocker lock(&mutex);
+		if (written) {
+			for (int i=oldestGeneration; i<snapshotGeneration; i++) {
+				QFile::remove(journalPath(i));
+			}
+			oldestGeneration = snapshotGeneration;
 		}
+		rememberDiskState();
 	}
 
-	return results;
+	LOG(INFO) << MSG_STORAGE_WRITE_END;
 }
 
-// Returns the total number of tasks in memory.
-int IStorage::totalTasks() {
-	QMutexLocker lock(&mutex);
-	return tasks.size();
+// Writes every task to the .ini file at exportPath, which older versions of
+// Tasuke and other programs can read. Returns false if it cannot be written.
+bool Storage::exportIni(QString exportPath) {
+	LOG(INFO) << MSG_STORAGE_EXPORTING << exportPath.toStdString();
+
+	return writeIni(exportPath, getTasks(false), generation);
 }
 
-// Searches for tasks. Takes in a function as an argument and searches for
-// tasks with a criteria that is determined by the function. It is the caller's
-// responsibility for the function to be valid and correct, as this method 
-// makes no assumptions about the criteria.
-QList<Task> IStorage::search(std::function<bool(Task)> predicate) const {
-	LOG(INFO) << MSG_STORAGE_SEARCH;
-	QList<Task> results;
+// Appends an ADD record to the journal.
+void Storage::onTaskAdded(const Task& task) {
+	if (journaled) {
+		journal.appendAdd(task);
+	}
+}
 
-	foreach(QSharedPointer<Task> task, tasks) {
-		if (predicate(*task)) {
-			results.push_back(*task);
-		}
+// Appends a REMOVE record to the journal.
+void Storage::onTaskRemoved(const Task& task) {
+	if (journaled) {
+		journal.appendRemove(task);
 	}
+}
 
-	return results;
+// Appends an EDIT or DONE record to the journal.
+void Storage::onTaskReplaced(const Task& oldTask, const Task& newTask) {
+	if (journaled) {
+		journal.appendEdit(oldTask, newTask);
+	}
 }
 
-// Searches all descriptions of all tasks in memory for specified keyword(s).
-// Returns a list of all tasks that contain the keyword in its description.
-// Searches by any part of the description. Case insensitive is the default.
-QList<Task> IStorage::searchByDescription(QString keyword, 
-										  Qt::CaseSensitivity caseSensitivity) {
-	QMutexLocker lock(&mutex);
-	LOG(INFO) << MSG_STORAGE_SEARCH_BY_DESCRIPTION << keyword.toStdString();
-	QList<Task> results;
+// Notes that the archived task is still in the archive file, so that the next
+// write drops it from there. A task still waiting to be archived is simply
+// not archived.
+void Storage::onTaskUnarchived(const Task& task) {
+	quint64 uid = task.getUid();
+	unarchived.insert(uid);
 
-	for (int i=0; i<tasks.size(); i++) {
-		if (tasks[i]->getDescription().contains(keyword, caseSensitivity)) {
-			results.push_back(*tasks[i]);
+	for (int i=0; i<pendingArchive.size(); i++) {
+		if (pendingArchive[i].getUid() == uid) {
+			pendingArchive.removeAt(i);
+			break;
 		}
 	}
+}
 
-	return results;
+// A bulk load is written as a new snapshot on the next save, rather than as
+// one journal record per task.
+void Storage::onTasksLoaded(int count) {
+	Q_UNUSED(count);
+	compactionDue = true;
 }
 
-// Searches all tags in all tasks in memory for specified tag.
-// Returns a list of all tasks that contain that tag.
-// Will also return partial results (if tag contains the searched keyword)
-// Case insensitive is the default.
-QList<Task> IStorage::searchByTag(QString keyword, 
-								  Qt::CaseSensitivity caseSensitivity) {
-	QMutexLocker lock(&mutex);
-	LOG(INFO) << MSG_STORAGE_SEARCH_BY_TAG << keyword.toStdString();
-	QList<Task> results;
+// Appends a CLEAR or CLEAR_DONE record to the journal.
+void Storage::onTasksCleared(bool doneOnly) {
+	if (journaled) {
+		journal.appendClear(doneOnly);
+	}
+}
 
-	for (int i=0; i<tasks.size(); i++) {
-		QList<QString> tags = tasks[i]->getTags();
-		int tagCount = tags.size();
+// Loads the binary snapshot into loaded, and restores the first journal
+// generation that is not part of it. See readSnapshot(). A snapshot left
+// behind by an interrupted compaction is put in place first.
+void Storage::loadSnapshot(QVector< QSharedPointer<Task> >& loaded) {
+	QString binaryPath = snapshotPath();
 
-		for (int j=0; j<tagCount; j++) {
-			if (tags[j].contains(keyword, caseSensitivity)) {
-				results.push_back(*tasks[i]);
-			}
-		}
+	// a compaction was interrupted after the old snapshot was removed
+	QString tempPath = binaryPath + SNAPSHOT_TEMP_SUFFIX;
+	if (!QFile::exists(binaryPath) && QFile::exists(tempPath)) {
+		QFile::rename(tempPath, binaryPath);
 	}
 
-	return results;
+	generation = readSnapshot(loaded, oldestGeneration, upgrading);
 }
 
-// Retrieves the next available free time.
-// Starts by assuming that the current time is free.
-// Then search through all tasks for ongoing events and take the ongoing 
-// event with the latest end time as the next available free time.
-// Then since tasks are sorted in order of earliest end time to latest end 
-// time, overlapping tasks will be merged into one unit.
-QString IStorage::nextFreeTime() {
-	LOG(INFO) << MSG_STORAGE_NEXT_FREE_TIME;
-	QDateTime nextAvailable = QDateTime::currentDateTime();
+// Reads the binary snapshot into loaded. If there is none, the .ini file
+// written by older versions of Tasuke is imported instead. Sets oldest to
+// the journal generation the snapshot was written at, and returns the first
+// journal generation to replay on top of it.
+// A .ini file edited after the snapshot and the journals replaces them: it
+// is imported, the journals are skipped, and upgrade is set so that a new
+// snapshot is written. upgrade is also set for files in an older format.
+// Every record is built into a Task here rather than when first used, as
+// renumber() indexes all of them and the first redraw lists them anyway.
+// Nothing in memory or on disk is changed, so this needs no lock.
+int Storage::readSnapshot(QVector< QSharedPointer<Task> >& loaded,
+						  int& oldest, bool& upgrade) const {
+	int first = 0;
+	Snapshot snapshot;
+	bool opened = snapshot.open(snapshotPath());
+	if (opened) {
+		first = snapshot.generation();
+	} else {
+		first = readIni(path, loaded);
+	}
+	oldest = first;
 
-	foreach (const QSharedPointer<Task>& task, tasks) {
-		if (task->isOverdue()) {
-			continue;
+	if (isIniNewer(first)) {
+		LOG(INFO) << MSG_STORAGE_INI_NEWER << path.toStdString();
+		if (opened) {
+			snapshot.close();
+			readIni(path, loaded);
 		}
-		if (!task->isEvent()) {
-			continue;
+		while (QFile::exists(journalPath(first))) {
+			first++;
 		}
-		if (task->getBegin() <= nextAvailable) {
-			nextAvailable = task->getEnd();
-		} else {
-			break;
+		upgrade = true;
+	} else if (opened) {
+		upgrade = snapshot.version() != SNAPSHOT_VERSION;
+		loaded.reserve(snapshot.size());
+		for (int i=0; i<snapshot.size(); i++) {
+			loaded.push_back(QSharedPointer<Task>::create(snapshot.task(i)));
 		}
+	} else {
+		upgrade = !loaded.isEmpty();
 	}
 
-	long delta = nextAvailable.toMSecsSinceEpoch()
-		- QDateTime::currentDateTime().toMSecsSinceEpoch();
+	return first;
+}
+
+// Replays every journal generation from the one recorded in the snapshot
+// onwards. New records are appended to the latest generation. See
+// readJournals().
+void Storage::replayJournals(QVector< QSharedPointer<Task> >& loaded) {
+	int records = 0;
+	generation = readJournals(generation, loaded, records, upgrading);
+	journal.open(journalPath(generation), records);
+}
 
-	if (abs(delta) <= MSECS_IN_SECOND * SECONDS_IN_MINUTE) {
-		return MSG_STORAGE_FREE_NOW;
+// Replays every journal generation from first onwards on top of the tasks in
+// loaded. A later generation can exist if Tasuke exited while a compaction
+// was still running. Returns the latest generation, and sets records to the
+// number of records in it. upgrade is set if a journal needs to be upgraded.
+// Nothing in memory or on disk is changed, so this needs no lock.
+int Storage::readJournals(int first, QVector< QSharedPointer<Task> >& loaded,
+						  int& records, bool& upgrade) const {
+	int last = first;
+	records = replayJournal(last, loaded, upgrade);
+	while (QFile::exists(journalPath(last + 1))) {
+		last++;
+		records = replayJournal(last, loaded, upgrade);
+	}
+	return last;
+}
+
+// Replays the journal of _generation on top of the tasks in loaded, and
+// sets upgrade if it needs to be upgraded. Returns the number of records
+// applied.
+int Storage::replayJournal(int _generation,
+						   QVector< QSharedPointer<Task> >& loaded,
+						   bool& upgrade) const {
+	QString journalFile = journalPath(_generation);
+	int journalVersion = Journal::version(journalFile);
+	if (journalVersion != 0 && journalVersion != JOURNAL_VERSION) {
+		upgrade = true;
 	}
 
-	QString result = Task::getTimeDifference(nextAvailable);
-	result.prepend(MSG_STORAGE_FREE_IN);
-	return result;
+	return Journal::replay(journalFile, loaded);
 }
 
-// Returns true if every task in memory is done.
-// Returns false if any task in memory is not done.
-bool IStorage::isAllDone() {
-	bool _isAllDone = true;
-	foreach (const QSharedPointer<Task>& task, tasks) {
-		if (!task->isDone()) {
-			_isAllDone = false;
+// Compacts the journal into a new snapshot. The tasks are copied and a
+// new journal generation is started right away so that saving can continue,
+// while the snapshot is written on a background thread. The old journals
+// are only removed once the new snapshot is safely on disk.
+// If a compaction is still running, nothing is done unless waitForRunning
+// is set, as the journal still holds every change. Tasks loaded in bulk are
+// not in the journal, so for them the running compaction is waited for and
+// another one started. If the snapshot cannot be written, the next save
+// tries again. Safe to call from loadFile() and the persistence worker at
+// once, as compactionMutex keeps them from starting one at the same time.
+void Storage::compact(bool waitForRunning) {
+	QMutexLocker compactionLock(&compactionMutex);
+	if (compacting && !waitForRunning) {
+		return;
+	}
+
+	if (compactionThread.joinable()) {
+		compactionThread.join();
+	}
+
+	LOG(INFO) << MSG_STORAGE_COMPACTING_JOURNAL;
+
+	QList<Task> snapshot;
+	QStringList obsolete;
+	int snapshotGeneration = 0;
+	bool coversLoad = false;
+	{
+		QMutexLocker lock(&mutex);
+		snapshot = snapshotTasks();
+		coversLoad = compactionDue;
+		compactionDue = false;
+
+		generation++;
+		journal.open(journalPath(generation));
+
+		for (int i=oldestGeneration; i<generation; i++) {
+			obsolete.push_back(journalPath(i));
 		}
+		oldestGeneration = generation;
+		snapshotGeneration = generation;
+		compacting = true;
 	}
-	return _isAllDone;
-}
 
-// Sorts the list of tasks in memory by its end date-time.
-// Tasks that end earlier are sorted to the front of the list.
-void IStorage::sortByEndDate() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_END_DATE;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		return t1->getEnd() < t2->getEnd();
-	});
-}
+	QString binaryPath = snapshotPath();
 
-// Sorts the list of tasks in memory by its description alphabetically.
-void IStorage::sortByDescription() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_DESCRIPTION;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		return t1->getDescription().toLower() < t2->getDescription().toLower();
-	});
-}
+	compactionThread = std::thread([this, binaryPath, snapshot, 
+		snapshotGeneration, obsolete, coversLoad]() {
+		bool written = writeSnapshot(binaryPath, snapshot, snapshotGeneration);
+		if (written) {
+			foreach (const QString& journalFile, obsolete) {
+				QFile::remove(journalFile);
+			}
+		}
 
-// Sorts the list of tasks in memory by whether or not it is ongoing.
-// Ongoing tasks are sorted to the front of the list.
-void IStorage::sortByOngoing() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_ONGOING_STATUS;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		return t1->isOngoing() > t2->isOngoing();
+		QMutexLocker lock(&mutex);
+		if (!written && coversLoad) {
+			compactionDue = true;
+		}
+		rememberDiskState();
+		compacting = false;
+		idle.wakeAll();
 	});
 }
 
-// Sorts the list of tasks in memory by whether or not it is due on
-// the current day. Tasks that are due on the current day are sorted the front.
-void IStorage::sortByIsDueToday() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_DUE_TODAY;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		return t1->isDueToday() > t2->isDueToday();
-	});
+// Blocks until the compaction running in the background, if any, is done.
+// mutex must not be held, as the compaction takes it to finish.
+void Storage::waitForCompaction() {
+	QMutexLocker compactionLock(&compactionMutex);
+	if (compactionThread.joinable()) {
+		compactionThread.join();
+	}
 }
 
-// Sorts the list of tasks in memory by whether or not it is overdue.
-// Tasks that are overdue are sorted to the front of the list.
-void IStorage::sortByOverdue() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_OVERDUE;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		return t1->isOverdue() > t2->isOverdue();
-	});
+// Watches the folder of the saved tasks and the files they are loaded from,
+// and reloads them shortly after they change. Files that are replaced rather
+// than written to stop being watched, so this is called again after every
+// reload. Nothing is watched without an event loop to hear about changes.
+void Storage::watch() {
+	if (QCoreApplication::instance() == nullptr) {
+		return;
+	}
+
+	if (watcher == nullptr) {
+		watcher = new QFileSystemWatcher();
+		QObject::connect(watcher, &QFileSystemWatcher::fileChanged, [this]() {
+			reloadTimer.start();
+		});
+		QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, [this]() {
+			reloadTimer.start();
+		});
+	}
+
+	QStringList paths;
+	paths << QFileInfo(path).absolutePath() << path << snapshotPath()
+		<< journalPath(generation);
+	foreach (const QString& watched, paths) {
+		if (QFileInfo(watched).exists() && !watcher->files().contains(watched)
+			&& !watcher->directories().contains(watched)) {
+			watcher->addPath(watched);
+		}
+	}
 }
 
-// Sorts the list of tasks in memory by whether or not it is done.
-// Tasks that are done are sorted to the back of the list.
-void IStorage::sortByDone() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_DONE_STATUS;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		return t1->isDone() < t2->isDone();
+// Runs on the GUI thread shortly after the watched files change. If they are
+// as this instance left them, the change was its own and nothing else is
+// done, without waiting for any write. Otherwise they are reloaded on another
+// thread, which emits reloaded() when it is done. If a reload is still
+// running, this is tried again later.
+void Storage::startReload() {
+	{
+		QMutexLocker lock(&mutex);
+		if (readDiskState() == diskState) {
+			return;
+		}
+	}
+
+	if (reloading) {
+		reloadTimer.start();
+		return;
+	}
+
+	if (reloadThread.joinable()) {
+		reloadThread.join();
+	}
+
+	reloading = true;
+	reloadThread = std::thread([this]() {
+		reload();
+		reloading = false;
 	});
 }
 
-// Sorts the list of tasks in memory by whether or not is has a valid
-// end date-time. Tasks with no valid end date-time are sorted to the back
-// of the list.
-void IStorage::sortByHasEndDate() {
-	LOG(INFO) << MSG_STORAGE_SORT_BY_HAS_END_DATE;
-	qStableSort(tasks.begin(), tasks.end(), [](const QSharedPointer<Task>& t1, 
-		const QSharedPointer<Task>& t2) {
-		if (t1->getEnd().isValid() == t2->getEnd().isValid()) {
+// Returns whether the .ini file was changed after the snapshot and every
+// journal from _generation on were last written, such as when it is edited
+// by hand, in which case it holds the latest tasks.
+bool Storage::isIniNewer(int _generation) const {
+	QFileInfo ini(path);
+	if (!ini.exists()) {
+		return false;
+	}
+
+	QDateTime edited = ini.lastModified();
+	QFileInfo snapshot(snapshotPath());
+	if (snapshot.exists() && snapshot.lastModified() >= edited) {
+		return false;
+	}
+	for (int i=_generation; QFile::exists(journalPath(i)); i++) {
+		if (QFileInfo(journalPath(i)).lastModified() >= edited) {
 			return false;
 		}
+	}
+	return true;
+}
+
+// Returns the size and time of last change of each file the tasks are
+// loaded from, or that a compaction would move on to, as they are now.
+// mutex must be held.
+QStringList Storage::readDiskState() const {
+	QStringList files;
+	files << path << snapshotPath() << journalPath(generation)
+		<< journalPath(generation + 1);
+
+	QStringList state;
+	foreach (const QString& file, files) {
+		QFileInfo info(file);
+		state.push_back(QString("%1 %2 %3").arg(info.exists()).arg(info.size())
+			.arg(info.lastModified().toMSecsSinceEpoch()));
+	}
+	return state;
+}
+
+// Notes the files the tasks are loaded from as they are now, after this
+// instance has written to them, so that its own writes do not cause a
+// reload. mutex must be held.
+void Storage::rememberDiskState() {
+	diskState = readDiskState();
+}
 
-		if (t1->getEnd().isValid()) {
-			return true;
+// Moves the done tasks that ended more than archiveAge days ago out of
+// memory, and adds them to the archive on a background thread. Tasks without
+// an end use their begin, and done tasks with neither stay in memory.
+void Storage::archive() {
+	if (archiveAge <= 0) {
+		return;
+	}
+
+	if (archiveThread.joinable()) {
+		archiveThread.join();
+	}
+
+	qint64 cutoff = QDateTime::currentDateTime().addDays(-archiveAge)
+		.toMSecsSinceEpoch();
+	{
+		QMutexLocker lock(&mutex);
+		pendingArchive = takeTasks([cutoff](const Task& task) -> bool {
+			QDateTime ended = task.getEnd().isValid() ? task.getEnd()
+				: task.getBegin();
+			return task.isDone() && ended.isValid()
+				&& ended.toMSecsSinceEpoch() < cutoff;
+		});
+
+		if (pendingArchive.isEmpty()) {
+			return;
 		}
+		LOG(INFO) << MSG_STORAGE_ARCHIVING << pendingArchive.size();
+	}
 
-		return false;
+	archiveThread = std::thread([this]() {
+		writeArchive();
 	});
 }
 
-// Renumbers the ID of all tasks in memory naively.
-void IStorage::renumber() {
-	// Internally within groups sort by date then alphabetically
-	sortByDescription();
-	sortByEndDate();
+// Runs on the archive thread. Writes the archive again with the pending
+// tasks added, and only then records their removal in the journal, so a
+// crash in between leaves them in both places rather than in neither. The
+// copy in memory wins when the archive is read. If the archive cannot be
+// written, the tasks are put back into memory. Pending tasks that were
+// brought back in the meantime are no longer in pendingArchive, so their
+// removal is not recorded, and those brought back later are dropped again
+// by the persistence worker.
+void Storage::writeArchive() {
+	bool written = false;
+	{
+		QMutexLocker archiveLock(&archiveMutex);
+		QList<Task> pending;
+		{
+			QMutexLocker lock(&mutex);
+			pending = pendingArchive;
+		}
 
-	// Today is always below overdue
-	sortByIsDueToday();
+		QSet<quint64> pendingUids;
+		foreach (const Task& task, pending) {
+			pendingUids.insert(task.getUid());
+		}
 
-	// Overdue is always at the top
-	sortByOverdue();
+		QList<Task> archivedTasks;
+		{
+			Snapshot existing;
+			if (existing.open(archivePath())) {
+				for (int i=0; i<existing.size(); i++) {
+					if (!pendingUids.contains(existing.uid(i))) {
+						archivedTasks.push_back(existing.task(i));
+					}
+				}
+			}
+		}
+		archivedTasks.append(pending);
 
-	// No end date is always above done
-	sortByHasEndDate();
+		written = writeSnapshot(archivePath(), archivedTasks, 0);
+	}
 
-	// Done is alwayas at the bottom
-	sortByDone();
+	{
+		QMutexLocker lock(&mutex);
+		if (written) {
+			foreach (const Task& task, pendingArchive) {
+				onTaskRemoved(task);
+			}
+		} else {
+			LOG(ERROR) << MSG_STORAGE_ARCHIVE_FAILED
+				<< archivePath().toStdString();
+			restoreTasks(pendingArchive, false);
+		}
+		pendingArchive.clear();
+		idle.wakeAll();
+	}
 
+	worker->markDirty();
+}
 
-	for (int i=0; i<tasks.size(); i++) {
-		tasks[i]->setId(i);
+// Runs on the persistence worker's thread, once the tasks with the unique IDs
+// in dropped are safely in the journal or the snapshot. Writes the
+// archive again without them. If it cannot be written, they are dropped by a
+// later write instead.
+void Storage::dropUnarchived(const QSet<quint64>& dropped) {
+	if (dropped.isEmpty()) {
+		return;
 	}
-}
 
-// Removes all tasks that are done from memory.
-void IStorage::clearAllDone() {
-	LOG(INFO) << MSG_STORAGE_CLEAR_ALL_DONE_TASKS;
-	foreach (const QSharedPointer<Task>& task, tasks) {
-		if (task->isDone()) {
-			tasks.removeOne(task);
+	LOG(INFO) << MSG_STORAGE_DROPPING_UNARCHIVED << dropped.size();
+
+	bool written = false;
+	{
+		QMutexLocker archiveLock(&archiveMutex);
+		QList<Task> archivedTasks;
+		Snapshot existing;
+		if (existing.open(archivePath())) {
+			for (int i=0; i<existing.size(); i++) {
+				if (!dropped.contains(existing.uid(i))) {
+					archivedTasks.push_back(existing.task(i));
+				}
+			}
+			existing.close();
+			written = writeSnapshot(archivePath(), archivedTasks, 0);
+		} else {
+			written = !QFile::exists(archivePath());
 		}
 	}
-	renumber();
-}
 
-// Removes all tasks from memory regardless of status.
-void IStorage::clearAllTasks() {
-	LOG(INFO) << MSG_STORAGE_CLEAR_ALL_TASKS;
-	tasks.clear();
-	renumber();
+	if (written) {
+		QMutexLocker lock(&mutex);
+		unarchived.subtract(dropped);
+	}
 }
 
-// The default constructor for Storage automatically sets the path of the
-// .ini save file to be %APPDATA%/Tasuke.
-Storage::Storage() {
-	LOG(INFO) << MSG_STORAGE_INSTANCE_CREATED;
-
-	QDir dir = QDir(QStandardPaths::writableLocation(
-		QStandardPaths::DataLocation));
+// Keeps the unique IDs of archived tasks from being given to new tasks. Only
+// the IDs are read, so the archive itself stays on disk.
+void Storage::reserveArchivedUids() {
+	Snapshot archived;
+	if (!archived.open(archivePath())) {
+		return;
+	}
 
-	path = dir.absoluteFilePath("tasks.ini");
+	quint64 maxUid = 0;
+	for (int i=0; i<archived.size(); i++) {
+		maxUid = qMax(maxUid, archived.uid(i));
+	}
 
-	qRegisterMetaType<Task>("Task");
-	qRegisterMetaTypeStreamOperators<Task>("Task");
+	QMutexLocker lock(&mutex);
+	reserveUids(maxUid);
 }
 
-// This constructor for Storage takes in a filepath as an argument.
-// Storage will read from and write to the .ini file at that path.
-Storage::Storage(QString _path) {
-	LOG(INFO) << MSG_STORAGE_INSTANCE_CREATED_NONDEFAULT;
-
-	path = _path;
+// Returns copies of the tasks in memory in order, followed by the tasks that
+// are waiting to be archived, which must not be lost from the snapshot until
+// they are. mutex must be held.
+QList<Task> Storage::snapshotTasks() const {
+	QList<Task> snapshot;
+	foreach (const QSharedPointer<Task>& task, order.toList()) {
+		snapshot.push_back(*task);
+	}
+	snapshot.append(pendingArchive);
 
-	qRegisterMetaType<Task>("Task");
-	qRegisterMetaTypeStreamOperators<Task>("Task");
+	return snapshot;
 }
 
-// This function loads the contents of the text file and serializes it into
-// the memory. It does so via QSettings.
-// If there is no such file, this function does nothing.
-void Storage::loadFile() {
-	LOG(INFO) << MSG_STORAGE_LOAD_FILE_START;
+// Writes the tasks in snapshot to a binary snapshot at path. The file is
+// written next to path first and then renamed over it, so a crash never
+// leaves a half written snapshot. Returns false if the file cannot be
+// written. This function is threadsafe.
+bool Storage::writeSnapshot(QString path, QList<Task> snapshot,
+							int generation) {
+	QString tempPath = path + SNAPSHOT_TEMP_SUFFIX;
+
+	if (!Snapshot::write(tempPath, snapshot, generation)) {
+		LOG(ERROR) << MSG_STORAGE_SNAPSHOT_FAILED << path.toStdString();
+		QFile::remove(tempPath);
+		return false;
+	}
+
+	QFile::remove(path);
+	return QFile::rename(tempPath, path);
+}
 
+// Reads the tasks in the .ini file at path and serializes them into tasks
+// via QSettings. Returns the journal generation stored in the file, which
+// is 0 for files written by older versions of Tasuke. Tasks are read with
+// the unique IDs stored in the file; tasks without one, from older files or
+// added by hand, are read with 0 and given a new one when loaded.
+int Storage::readIni(QString path, QVector< QSharedPointer<Task> >& tasks) {
 	QSettings settings(path, QSettings::IniFormat);
 
 	int size = settings.beginReadArray("Tasks");
 	for (int i=0; i<size; i++) {
 		settings.setArrayIndex(i);
-		Task* task = new Task();
+		QSharedPointer<Task> task = QSharedPointer<Task>::create();
 
 		task->setDescription(settings.value("Description").toString());
 		uint beginTime = settings.value("BeginTimeUnix", 0).toUInt();
@@ -389,6 +1966,7 @@ void Storage::loadFile() {
 		}
 
 		task->setDone(settings.value("Done").toBool());
+		task->setUid(settings.value("Uid", 0).toULongLong());
 
 		int tagCount = settings.beginReadArray("Tags");
 		for (int j=0; j<tagCount; j++) {
@@ -398,59 +1976,61 @@ void Storage::loadFile() {
 		}
 		settings.endArray();
 
-		tasks.push_back(QSharedPointer<Task>(task));
+		tasks.push_back(task);
 	}
 	settings.endArray();
 
-	renumber();
-	NotificationManager::instance().init(this);
-
-	LOG(INFO) << MSG_STORAGE_LOAD_FILE_END;
+	return settings.value("JournalGeneration", 0).toInt();
 }
 
-// This function deserializes the data from memory and writes it to the text
-// file. It does so via QSettings. If the file cannot be written, an 
-// ExceptionNotOpen is thrown.
-void Storage::saveFile() {
-	LOG(INFO) << MSG_STORAGE_SAVE_FILE_START;
+// This function deserializes the tasks in snapshot and writes them to the
+// .ini file at path via QSettings. Returns false if the file cannot be
+// written. This function is threadsafe.
+bool Storage::writeIni(QString path, QList<Task> snapshot, int generation) {
+	QFile::remove(path);
 
 	QSettings settings(path, QSettings::IniFormat);
 
-	settings.clear();
+	settings.setValue("JournalGeneration", generation);
 	settings.beginWriteArray("Tasks");
-	for (int i=0; i<tasks.size(); i++) {
+	for (int i=0; i<snapshot.size(); i++) {
+		const Task& task = snapshot[i];
+
 		settings.setArrayIndex(i);
-		settings.setValue("Description", tasks[i]->getDescription());
-		settings.setValue("BeginTime", tasks[i]->getBegin().toString());
-		settings.setValue("EndTime", tasks[i]->getEnd().toString());
+		settings.setValue("Description", task.getDescription());
+		settings.setValue("BeginTime", task.getBegin().toString());
+		settings.setValue("EndTime", task.getEnd().toString());
 
-		if (tasks[i]->getBegin().isNull() || !tasks[i]->getBegin().isValid()) {
+		if (task.getBegin().isNull() || !task.getBegin().isValid()) {
 			settings.setValue("BeginTimeUnix", "");
 		} else {
-			settings.setValue("BeginTimeUnix", tasks[i]->getBegin().toTime_t());
+			settings.setValue("BeginTimeUnix", task.getBegin().toTime_t());
 		}
 
-		if (tasks[i]->getEnd().isNull() || !tasks[i]->getEnd().isValid()) {
+		if (task.getEnd().isNull() || !task.getEnd().isValid()) {
 			settings.setValue("EndTimeUnix", "");
 		} else {
-			settings.setValue("EndTimeUnix", tasks[i]->getEnd().toTime_t());
+			settings.setValue("EndTimeUnix", task.getEnd().toTime_t());
 		}
 
-		settings.setValue("Done", tasks[i]->isDone());
+		settings.setValue("Done", task.isDone());
+		settings.setValue("Uid", task.getUid());
 
 		settings.beginWriteArray("Tags");
-		QList<QString> tags = tasks[i]->getTags();
+		QList<QString> tags = task.getTags();
 		for (int j=0; j<tags.size(); j++) {
 			settings.setArrayIndex(j);
 			settings.setValue("Tag", tags[j]);
 		}
 		settings.endArray();
-		settings.sync();
 	}
 	settings.endArray();
 	settings.sync();
 
-	NotificationManager::instance().init(this);
+	if (settings.status() != QSettings::NoError) {
+		LOG(ERROR) << MSG_STORAGE_EXPORT_FAILED << path.toStdString();
+		return false;
+	}
 
-	LOG(INFO) << MSG_STORAGE_SAVE_FILE_END;
-}
\ No newline at end of file
+	return true;
+}
@@ -2,49 +2,173 @@
 #ifndef STORAGE_H
 #define STORAGE_H
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <thread>
 #include <QString>
 #include <QTimer>
+#include <QFileSystemWatcher>
+#include <QWaitCondition>
+#include <QStringList>
 #include <QList>
+#include <QSet>
+#include <QVector>
 #include "Task.h"
+#include "TaskOrderIndex.h"
+#include "TagIndex.h"
+#include "TrigramIndex.h"
+#include "TaskView.h"
+#include "TaskTable.h"
+#include "Revision.h"
+#include "IntervalIndex.h"
+#include "Journal.h"
+#include "Snapshot.h"
+#include "PersistenceWorker.h"
 #include "NotificationManager.h"
 
+// A gap between events, from its first element to its second.
+typedef QPair<QDateTime, QDateTime> FreeSlot;
+
 // Interface class for Storage.
+//
+// Changes are serialized by mutex, and each one ends by publishing a new
+// Revision of the tasks. Reads that only need the list of tasks work on the
+// latest revision and never wait for a change in progress, and so do the
+// filters by status, which run over the columns of its TaskTable. Searches
+// that use an index still take mutex, as the indexes are only kept for the
+// latest revision.
+//
+// Commands that make many changes at once open a batch with beginBatch() and
+// close it with commit(), so that the list of tasks is rebuilt and published
+// once for the whole batch rather than once per change.
+//
+// Storages that keep some tasks outside of memory can read them back with
+// loadArchive() for the queries that ask for them. Those tasks are only
+// listed, after the tasks in memory, and a task is brought back into memory
+// only when it is changed.
 class IStorage {
 protected:
-	QList< QSharedPointer<Task> > tasks;
+	// The tasks in display order, as of the last change. Only used by
+	// writers, which must hold mutex. Tasks are made with
+	// QSharedPointer::create(), which allocates each task together with its
+	// reference count, and lists of them are QVectors so that the handles
+	// sit in one block instead of a node each.
+	QVector< QSharedPointer<Task> > tasks;
+	TaskOrderIndex order;
+	TagIndex tagIndex;
+	TrigramIndex descriptionIndex;
+	IntervalIndex intervals;
 	QMutex mutex;
 
+	void materialize();
+	void changed();
+	void catchUp();
+	bool unchangedSince(quint64 revision) const;
+	void publish();
+	std::shared_ptr<const Revision> current() const;
+	void indexTask(const QSharedPointer<Task>& task);
+	void unindexTask(const QSharedPointer<Task>& task);
+	void clearIndexes();
+	TaskView viewOf(const QList<const Task*>& matches) const;
+	QList<Task> takeTasks(std::function<bool(const Task&)> predicate);
+	void restoreTasks(const QList<Task>& restored, bool notify);
+	int absorbTasks(const QVector< QSharedPointer<Task> >& latest);
+	void reserveUids(quint64 uid);
+	void setArchived(const QList<Task>& archivedTasks);
+
+	// Called whenever the list of tasks changes so that subclasses can
+	// persist just the change. They do nothing by default.
+	virtual void onTaskAdded(const Task& task);
+	virtual void onTaskRemoved(const Task& task);
+	virtual void onTaskReplaced(const Task& oldTask, const Task& newTask);
+	virtual void onTasksCleared(bool doneOnly);
+	virtual void onTasksLoaded(int count);
+	virtual void onTaskUnarchived(const Task& task);
+
+private:
+	std::shared_ptr<const Revision> published;
+	quint64 revisionNumber;
+	int batchDepth;
+	bool batchDirty;
+	QHash<quint64, QSharedPointer<Task> > byUid;
+	quint64 lastUid;
+	quint64 reservedUid;
+	// The archived tasks read back by loadArchive(), which are listed after
+	// the tasks in memory. A task is taken out of archivedByUid when it is
+	// brought back into memory, and out of archived at the next publish().
+	QVector< QSharedPointer<Task> > archived;
+	QHash<quint64, QSharedPointer<Task> > archivedByUid;
+	bool archivedDirty;
+
+	Task replaceTask(QSharedPointer<Task> oldPtr, Task& task);
+	void eraseTask(QSharedPointer<Task> taskPtr);
+	QSharedPointer<Task> swapTask(const QSharedPointer<Task>& oldPtr,
+		const Task& task, const TimeSnapshot& now);
+	void unlinkTask(const QSharedPointer<Task>& taskPtr,
+		const TimeSnapshot& now);
+	QSharedPointer<Task> findTask(quint64 uid) const;
+	QSharedPointer<Task> liveTask(quint64 uid);
+	QSharedPointer<Task> liveTaskAt(int id);
+	QSharedPointer<Task> unarchiveTask(quint64 uid);
+	static QVector<int> positionsOf(const Revision& revision,
+		const QList<const Task*>& matches);
+	static TaskView listedView(const Revision& revision, QVector<int> indexes,
+		const QVector<int>& archivedRows);
+
 public:
 	IStorage();
 	virtual ~IStorage();
 
 	Task addTask(Task& task);
 	Task editTask(int id, Task& task);
-	Task getTask(int id);
+	Task editTaskByUid(quint64 uid, Task& task);
+	Task getTask(int id) const;
+	Task getTaskByUid(quint64 uid);
+	int idOf(quint64 uid);
 	void removeTask(int id);
+	void removeTaskByUid(quint64 uid);
 	void popTask();
-	Task getNextUpcomingTask();
+	void addTasks(const QList<Task>& added);
+	int bulkLoad(std::function<bool(Task&)> next,
+		QVector<quint64>* added = nullptr);
+	QList<Task> removeTasksByUid(const QVector<quint64>& uids);
+	QList<Task> editTasksByUid(const QVector<quint64>& uids,
+		std::function<void(Task&)> change);
+	void replaceTasks(const QList<Task>& replacements);
+	Task getNextUpcomingTask() const;
+	TaskView view(bool hideDone = true, bool withArchived = false) const;
 	QList<Task> getTasks(bool hideDone = true) const;
-	int totalTasks();
+	int totalTasks(bool withArchived = false) const;
+
+	TaskView query(std::function<bool(const Task&)> predicate) const;
+	TaskView query(TaskTable::Filter filter, bool withArchived = false);
+	TaskView queryByDescription(QString keyword, 
+		Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive,
+		bool withArchived = false);
+	TaskView queryByTag(QString keyword, 
+		Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive,
+		bool withArchived = false);
+	TaskView queryWithTag(QString tag, bool withArchived = false);
 
-	QList<Task> search(std::function<bool(Task)> predicate) const;
+	QList<Task> search(std::function<bool(const Task&)> predicate) const;
+	QList<Task> search(TaskTable::Filter filter);
 	QList<Task> searchByDescription(QString keyword, 
 		Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive);
 	QList<Task> searchByTag(QString keyword, 
 		Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive);
 
 	QString nextFreeTime();
+	QDateTime nextFreeSlot(qint64 length);
+	QList<FreeSlot> freeSlots(QDateTime begin, QDateTime end, qint64 minimum);
+	TaskView queryOverlapping(QDateTime begin, QDateTime end);
 
-	bool isAllDone();
+	bool isAllDone() const;
 
-	void sortByEndDate();
-	void sortByDescription();
-	void sortByOngoing();
-	void sortByIsDueToday();
-	void sortByDone();
-	void sortByOverdue();
-	void sortByHasEndDate();
+	void beginBatch();
+	void commit();
+	bool inBatch();
+	quint64 getRevisionNumber() const;
 
 	void renumber();
 
@@ -53,19 +177,124 @@ public:
 
 	virtual void loadFile() = 0;
 	virtual void saveFile() = 0;
+	virtual void flush();
+	virtual void loadArchive();
 };
 
 // This class abstracts away the data management in memory and on disk.
 // Usually only 1 instance of this class is required and it is managed by the
-// Tasuke singleton.
-class Storage : public IStorage {
+// Tasuke singleton, which listens to reloaded() to redraw the tasks.
+// saveFile() only schedules a write, which a PersistenceWorker carries out
+// on another thread; flush() waits for it.
+// In journaled mode (the default), each write only appends the changes made
+// since the last save to a journal. The journal is periodically compacted
+// into a binary snapshot on a background thread. The .ini file is only read
+// if there is no snapshot yet, and can be written with exportIni().
+// Done tasks that ended more than the archive age ago are moved out of memory
+// into an archive file next to the snapshot after loading, on a background
+// thread. The archive is only read, by loadArchive(), when the user asks for
+// done tasks or searches, and is never written on the caller's thread. A task
+// that is changed is journaled back into memory, and the persistence worker
+// drops it from the archive once the journal is on disk.
+// The saved files are watched for changes made outside Tasuke. Changes this
+// instance wrote itself are told apart by the files being as it left them,
+// and anything else is reloaded on another thread. A .ini file edited after
+// the snapshot and the journals were last written replaces them.
+class Storage : public QObject, public IStorage {
+	Q_OBJECT
 private:
 	QString path;
+	bool journaled;
+	Journal journal;
+	int generation;
+	int oldestGeneration;
+	std::thread compactionThread;
+	// Held while compactionThread is joined or started, as compactions are
+	// started from both loadFile() and the persistence worker.
+	QMutex compactionMutex;
+	// Only changed with mutex held, so that reload() can wait on idle for a
+	// compaction to finish.
+	std::atomic<bool> compacting;
+	QWaitCondition idle;
+	// Set by a bulk load, so that the next save writes a snapshot. Only
+	// cleared once a snapshot with the loaded tasks is being written.
+	bool compactionDue;
+	bool upgrading;
+	PersistenceWorker* worker;
+	int archiveAge;
+	bool archiveLoaded;
+	std::thread archiveThread;
+	// Tasks taken out of memory that are not in the archive file yet. They
+	// are still written to snapshots until they are.
+	QList<Task> pendingArchive;
+	// Archived tasks brought back into memory that are still in the archive
+	// file.
+	QSet<quint64> unarchived;
+	// Held while the archive file is read and written again, so that the
+	// archive thread and the persistence worker never overwrite each other.
+	QMutex archiveMutex;
+	QFileSystemWatcher* watcher;
+	QTimer reloadTimer;
+	std::thread reloadThread;
+	std::atomic<bool> reloading;
+	// The files the tasks are loaded from as this instance last left them.
+	QStringList diskState;
+
+	void init();
+	void waitForCompaction();
+	QString snapshotPath() const;
+	QString archivePath() const;
+	QString journalPath(int _generation) const;
+	void loadSnapshot(QVector< QSharedPointer<Task> >& loaded);
+	int readSnapshot(QVector< QSharedPointer<Task> >& loaded, int& oldest,
+		bool& upgrade) const;
+	void replayJournals(QVector< QSharedPointer<Task> >& loaded);
+	int readJournals(int first, QVector< QSharedPointer<Task> >& loaded,
+		int& records, bool& upgrade) const;
+	int replayJournal(int _generation, QVector< QSharedPointer<Task> >& loaded,
+		bool& upgrade) const;
+	void watch();
+	void startReload();
+	bool isIniNewer(int _generation) const;
+	QStringList readDiskState() const;
+	void rememberDiskState();
+	void compact(bool waitForRunning = false);
+	void archive();
+	void writeArchive();
+	void dropUnarchived(const QSet<quint64>& dropped);
+	void reserveArchivedUids();
+	QList<Task> snapshotTasks() const;
+	void writeToDisk();
+	static bool writeSnapshot(QString path, QList<Task> snapshot,
+		int generation);
+
+protected:
+	void onTaskAdded(const Task& task) override;
+	void onTaskRemoved(const Task& task) override;
+	void onTaskReplaced(const Task& oldTask, const Task& newTask) override;
+	void onTasksCleared(bool doneOnly) override;
+	void onTasksLoaded(int count) override;
+	void onTaskUnarchived(const Task& task) override;
+
 public:
 	Storage();
 	Storage(QString path);
+	~Storage();
+	void setJournaled(bool _journaled);
 	void loadFile() override;
 	void saveFile() override;
+	void flush() override;
+	void setDurabilityPolicy(DurabilityPolicy policy, int interval);
+	void setArchiveAge(int days);
+	void loadArchive() override;
+	int reload();
+	bool exportIni(QString exportPath);
+
+	static int readIni(QString path, QVector< QSharedPointer<Task> >& tasks);
+	static bool writeIni(QString path, QList<Task> snapshot, int generation);
+
+signals:
+	void reloaded(int changes);
 };
 
 #endif
@@ -0,0 +1,122 @@
+//@author A0096863M
+#include "Substituter.h"
+
+Substituter::Node::Node() {
+	for (int i=0; i<POSITION_COUNT; i++) {
+		ids[i] = -1;
+	}
+}
+
+Substituter::Substituter() {
+
+}
+
+// Adds a phrase to be replaced at the given position by the replacement for
+// id. Adding the same phrase and position again replaces its ID.
+void Substituter::add(const QString& phrase, Position position, int id) {
+	Node* node = &root;
+	for (int i=0; i<phrase.size(); i++) {
+		QSharedPointer<Node>& child = node->children[phrase[i]];
+		if (child.isNull()) {
+			child = QSharedPointer<Node>(new Node());
+		}
+		node = child.data();
+	}
+	node->ids[position] = id;
+}
+
+// Leaves out c wherever it comes right before a word, like removing ",\b".
+// The text is matched as if it was not there, so "mon,day" reads "monday".
+void Substituter::dropBeforeWords(QChar c) {
+	dropped += c;
+}
+
+// Returns text with every phrase replaced by replacement(id) for its ID.
+// Phrases are matched in the text as it was given, so a replacement is never
+// matched again.
+QString Substituter::apply(const QString& text,
+						   std::function<QString(int)> replacement) const {
+	QString result;
+	result.reserve(text.size());
+
+	int size = text.size();
+	int i = next(text, -1);
+	bool atStart = true;
+	bool afterWord = false;
+	while (i < size) {
+		QChar c = text[i];
+		int last = i;
+		int id = -1;
+
+		if (atStart) {
+			id = match(text, i, START, last);
+		}
+		if (id < 0 && c.isSpace()) {
+			id = match(text, next(text, i), AFTER_SPACE, last);
+		}
+		if (id < 0 && !afterWord && isWord(c)) {
+			id = match(text, i, WORDS, last);
+		}
+		if (id < 0) {
+			id = match(text, i, ANYWHERE, last);
+		}
+
+		if (id >= 0) {
+			result += replacement(id);
+		} else {
+			result += c;
+		}
+		afterWord = isWord(text[last]);
+		atStart = false;
+		i = next(text, last);
+	}
+
+	return result;
+}
+
+// Returns true if c is part of a word, like \w in QRegExp.
+bool Substituter::isWord(QChar c) {
+	return c.isLetterOrNumber() || c.isMark() || c == '_';
+}
+
+// Returns true if the i-th character of text is left out.
+bool Substituter::isDropped(const QString& text, int i) const {
+	return i + 1 < text.size() && dropped.contains(text[i])
+		&& isWord(text[i + 1]);
+}
+
+// Returns the position of the character after the i-th one that is not left
+// out, or the size of text if there is none.
+int Substituter::next(const QString& text, int i) const {
+	i++;
+	while (i < text.size() && isDropped(text, i)) {
+		i++;
+	}
+	return i;
+}
+
+// Returns the ID of the longest phrase that starts at begin and may be
+// replaced at position, and sets last to its last character. Returns -1 if
+// there is none.
+int Substituter::match(const QString& text, int begin, Position position,
+					   int& last) const {
+	int id = -1;
+	const Node* node = &root;
+	int size = text.size();
+	for (int i=begin; i<size; i=next(text, i)) {
+		QHash<QChar, QSharedPointer<Node> >::const_iterator child =
+			node->children.find(text[i]);
+		if (child == node->children.constEnd()) {
+			break;
+		}
+		node = child.value().data();
+
+		int after = next(text, i);
+		if (node->ids[position] >= 0 && (position == ANYWHERE
+			|| after == size || !isWord(text[after]))) {
+			id = node->ids[position];
+			last = i;
+		}
+	}
+	return id;
+}
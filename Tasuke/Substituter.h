@@ -0,0 +1,62 @@
+//@author A0096863M
+#ifndef SUBSTITUTER_H
+#define SUBSTITUTER_H
+
+#include <functional>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+
+// Replaces many words and phrases in a text in a single pass, instead of
+// running one regular expression after another over it.
+//
+// Every phrase is stored in a trie, one character per level, with an ID for
+// each position it may be replaced at. The text is then read once from left
+// to right into a single output. At each character the trie is walked as far
+// as the text allows, and the longest phrase found there that sits where it
+// may is replaced by what the caller gives for its ID. Anything else is
+// copied as it is. A word is what QRegExp matches \w against.
+class Substituter {
+public:
+	// Where a phrase has to be to be replaced, like a regular expression.
+	enum Position {
+		// a whole word or words, like \bphrase\b
+		WORDS,
+		// whole words at the start of the text, like ^phrase\b
+		START,
+		// whole words after a space, which is replaced too, like \sphrase\b
+		AFTER_SPACE,
+		// anywhere, even inside a word
+		ANYWHERE,
+		POSITION_COUNT
+	};
+
+	Substituter();
+
+	void add(const QString& phrase, Position position, int id);
+	void dropBeforeWords(QChar c);
+	QString apply(const QString& text,
+		std::function<QString(int)> replacement) const;
+
+private:
+	struct Node {
+		Node();
+
+		QHash<QChar, QSharedPointer<Node> > children;
+		// The ID of the phrase that ends here at each position, or -1.
+		int ids[POSITION_COUNT];
+	};
+
+	Node root;
+	// Characters that are left out, as if they were not there, when the
+	// next character is part of a word.
+	QString dropped;
+
+	static bool isWord(QChar c);
+	bool isDropped(const QString& text, int i) const;
+	int next(const QString& text, int i) const;
+	int match(const QString& text, int begin, Position position,
+		int& last) const;
+};
+
+#endif
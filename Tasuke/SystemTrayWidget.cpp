@@ -70,6 +70,9 @@ void SystemTrayWidget::handleIconActivated(
 // Activated when the app is about to quit
 void SystemTrayWidget::handleAboutToQuit() {
 	trayIcon->hide();
+
+	// make sure every saved change is on disk before the event loop ends
+	Tasuke::instance().getStorage().flush();
 }
 
 // Creates and install a tray icon + menu
@@ -0,0 +1,59 @@
+//@author A0096863M
+#include <cassert>
+#include "TagDictionary.h"
+
+TagDictionary::TagDictionary() {
+
+}
+
+// Returns the ID of tag, giving it the next free ID if it has none yet.
+int TagDictionary::intern(const QString& tag) {
+	TagDictionary& dictionary = instance();
+
+	{
+		QReadLocker reading(&dictionary.lock);
+		QHash<QString, int>::const_iterator it = dictionary.ids.constFind(tag);
+		if (it != dictionary.ids.constEnd()) {
+			return it.value();
+		}
+	}
+
+	QWriteLocker writing(&dictionary.lock);
+	QHash<QString, int>::const_iterator it = dictionary.ids.constFind(tag);
+	if (it != dictionary.ids.constEnd()) {
+		return it.value();
+	}
+
+	int tagId = dictionary.names.size();
+	dictionary.names.push_back(tag);
+	dictionary.ids.insert(tag, tagId);
+	return tagId;
+}
+
+// Returns the ID of tag, or -1 if no task has ever had it.
+int TagDictionary::find(const QString& tag) {
+	TagDictionary& dictionary = instance();
+	QReadLocker reading(&dictionary.lock);
+	return dictionary.ids.value(tag, -1);
+}
+
+// Returns the tag with the ID tagId.
+QString TagDictionary::name(int tagId) {
+	TagDictionary& dictionary = instance();
+	QReadLocker reading(&dictionary.lock);
+	assert(tagId >= 0 && tagId < dictionary.names.size());
+	return dictionary.names[tagId];
+}
+
+// Returns the number of distinct tags seen so far.
+int TagDictionary::size() {
+	TagDictionary& dictionary = instance();
+	QReadLocker reading(&dictionary.lock);
+	return dictionary.names.size();
+}
+
+// Returns the dictionary, creating it the first time.
+TagDictionary& TagDictionary::instance() {
+	static TagDictionary dictionary;
+	return dictionary;
+}
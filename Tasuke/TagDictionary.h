@@ -0,0 +1,34 @@
+//@author A0096863M
+#ifndef TAGDICTIONARY_H
+#define TAGDICTIONARY_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+// Gives every distinct tag a small integer ID, so that tasks can keep their
+// tags as a short array of IDs instead of a set of strings.
+//
+// There is a single dictionary for the whole program. Tags are few and
+// shared by many tasks, so IDs are never given back: a tag keeps its ID even
+// after the last task with it is gone. Tags are case sensitive, like before,
+// so "Work" and "work" get different IDs. Safe to use from any thread.
+class TagDictionary {
+public:
+	static int intern(const QString& tag);
+	static int find(const QString& tag);
+	static QString name(int tagId);
+	static int size();
+
+private:
+	TagDictionary();
+
+	QReadWriteLock lock;
+	QHash<QString, int> ids;
+	QVector<QString> names;
+
+	static TagDictionary& instance();
+};
+
+#endif
@@ -0,0 +1,135 @@
+//@author A0096863M
+#include "TagDictionary.h"
+#include "TagIndex.h"
+
+TagIndex::TagIndex() {
+
+}
+
+// Removes every task from the index.
+void TagIndex::clear() {
+	root.children.clear();
+	root.tags.clear();
+	postings.clear();
+}
+
+// Indexes task under each of its tags.
+void TagIndex::insert(const Task* task) {
+	foreach (int tagId, task->getTagIds()) {
+		QSet<const Task*>& tasks = postings[tagId];
+		if (tasks.isEmpty()) {
+			addToTrie(tagId);
+		}
+		tasks.insert(task);
+	}
+}
+
+// Removes task from the index. Tags that no task has any more are dropped
+// from the trie.
+void TagIndex::remove(const Task* task) {
+	foreach (int tagId, task->getTagIds()) {
+		QHash<int, QSet<const Task*> >::iterator it = postings.find(tagId);
+		if (it == postings.end()) {
+			continue;
+		}
+
+		it.value().remove(task);
+		if (it.value().isEmpty()) {
+			postings.erase(it);
+			removeFromTrie(tagId);
+		}
+	}
+}
+
+// Returns every task with a tag that contains keyword, once each and in no
+// particular order.
+QList<const Task*> TagIndex::find(const QString& keyword,
+								  Qt::CaseSensitivity caseSensitivity) const {
+	QSet<const Task*> results;
+
+	const Node* node = findNode(keyword.toCaseFolded());
+	if (node == nullptr) {
+		return QList<const Task*>();
+	}
+
+	QHash<int, int>::const_iterator it;
+	for (it = node->tags.constBegin(); it != node->tags.constEnd(); it++) {
+		int tagId = it.key();
+		if (caseSensitivity == Qt::CaseSensitive
+			&& !TagDictionary::name(tagId).contains(keyword)) {
+			continue;
+		}
+		results.unite(postings.value(tagId));
+	}
+
+	return results.toList();
+}
+
+// Returns the number of distinct tags in the index.
+int TagIndex::tagCount() const {
+	return postings.size();
+}
+
+// Adds every suffix of the tag with the ID tagId, case folded, to the trie.
+void TagIndex::addToTrie(int tagId) {
+	QString folded = TagDictionary::name(tagId).toCaseFolded();
+	root.tags[tagId]++;
+
+	for (int i=0; i<folded.size(); i++) {
+		Node* node = &root;
+		for (int j=i; j<folded.size(); j++) {
+			QSharedPointer<Node>& child = node->children[folded[j]];
+			if (child.isNull()) {
+				child = QSharedPointer<Node>(new Node());
+			}
+			node = child.data();
+			node->tags[tagId]++;
+		}
+	}
+}
+
+// Removes every suffix of the tag with the ID tagId from the trie. A node
+// that no tag passes through has no tags below it either, so it is cut off
+// along with all of its children.
+void TagIndex::removeFromTrie(int tagId) {
+	QString folded = TagDictionary::name(tagId).toCaseFolded();
+	if (--root.tags[tagId] == 0) {
+		root.tags.remove(tagId);
+	}
+
+	for (int i=0; i<folded.size(); i++) {
+		Node* node = &root;
+		for (int j=i; j<folded.size(); j++) {
+			QSharedPointer<Node> child = node->children.value(folded[j]);
+			if (child.isNull()) {
+				break;
+			}
+
+			if (--child->tags[tagId] == 0) {
+				child->tags.remove(tagId);
+			}
+			if (child->tags.isEmpty()) {
+				node->children.remove(folded[j]);
+				break;
+			}
+			node = child.data();
+		}
+	}
+}
+
+// Returns the node reached by walking down the trie along keyword, or
+// nullptr if no tag contains it.
+const TagIndex::Node* TagIndex::findNode(const QString& keyword) const {
+	const Node* node = &root;
+
+	for (int i=0; i<keyword.size(); i++) {
+		QHash<QChar, QSharedPointer<Node> >::const_iterator it =
+			node->children.constFind(keyword[i]);
+		if (it == node->children.constEnd()) {
+			return nullptr;
+		}
+		node = it.value().data();
+	}
+
+	return node;
+}
@@ -0,0 +1,48 @@
+//@author A0096863M
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include "Task.h"
+
+// Finds the tasks that have a tag containing some keyword without looking at
+// every task.
+//
+// Each tag, by its TagDictionary ID, maps to the tasks that have it. To find
+// the tags containing a keyword, every suffix of every distinct tag, case
+// folded, is stored in a trie and each node records the tags whose suffixes
+// pass through it. The tags containing the keyword are then exactly those
+// recorded at the node reached by walking down the keyword, so a search costs
+// the length of the keyword plus the number of matches, however many tasks
+// there are.
+class TagIndex {
+public:
+	TagIndex();
+
+	void clear();
+	void insert(const Task* task);
+	void remove(const Task* task);
+	QList<const Task*> find(const QString& keyword,
+		Qt::CaseSensitivity caseSensitivity) const;
+	int tagCount() const;
+
+private:
+	struct Node {
+		QHash<QChar, QSharedPointer<Node> > children;
+		// How many suffixes of each tag, by ID, pass through this node.
+		QHash<int, int> tags;
+	};
+
+	Node root;
+	QHash<int, QSet<const Task*> > postings;
+
+	void addToTrie(int tagId);
+	void removeFromTrie(int tagId);
+	const Node* findNode(const QString& keyword) const;
+};
+
+#endif
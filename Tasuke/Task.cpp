@@ -1,20 +1,24 @@
 //@author A0096863M
+#include <algorithm>
 #include <QDataStream>
 #include <cassert>
 #include "Constants.h"
 #include "Exceptions.h"
+#include "TagDictionary.h"
 #include "Task.h"
 
 Task::Task() {
-	id = -1;
+	uid = 0;
 	done = false;
+	updateMSecs();
 }
 
 // Constructor of a task that takes in a description.
 Task::Task(QString _description) {
-	id = -1;
+	uid = 0;
 	done = false;
 	this->description = _description;
+	updateMSecs();
 }
 
 Task::~Task() {
@@ -43,26 +47,55 @@ void Task::addTag(QString _tag) {
 		throw ExceptionBadCommand("This task has too many tags", "tag");
 	}
 	
-	if (!tags.contains(_tag)) {
-		tags.insert(_tag);
+	int tagId = TagDictionary::intern(_tag);
+	QVector<int>::iterator it = std::lower_bound(tags.begin(), tags.end(), tagId);
+	if (it == tags.end() || *it != tagId) {
+		tags.insert(it, tagId);
 	}
 }
 
 // Searches through the set of tags for a task and removes the tag _tag.
 bool Task::removeTag(QString _tag) {
-	return tags.remove(_tag);
+	int tagId = TagDictionary::find(_tag);
+	QVector<int>::iterator it = std::lower_bound(tags.begin(), tags.end(), tagId);
+	if (tagId < 0 || it == tags.end() || *it != tagId) {
+		return false;
+	}
+
+	tags.erase(it);
+	return true;
 }
 
-// Gets all tags of a task in the form of a QList.
+// Gets all tags of a task in the form of a QList, in the order they were
+// first seen by the TagDictionary.
 QList<QString> Task::getTags() const {
-	return tags.toList();
+	QList<QString> results;
+	results.reserve(tags.size());
+	foreach (int tagId, tags) {
+		results.push_back(TagDictionary::name(tagId));
+	}
+	return results;
 }
 
 // Gets all tags of a task in the form of a QSet.
 QSet<QString> Task::getTagsSet() const {
+	QSet<QString> results;
+	foreach (int tagId, tags) {
+		results.insert(TagDictionary::name(tagId));
+	}
+	return results;
+}
+
+// Gets the TagDictionary IDs of the tags of a task, in increasing order.
+const QVector<int>& Task::getTagIds() const {
 	return tags;
 }
 
+// Returns true if this task has the tag with the ID tagId.
+bool Task::hasTag(int tagId) const {
+	return std::binary_search(tags.constBegin(), tags.constEnd(), tagId);
+}
+
 // Sets the begin date and time for this task.
 // It is the responsibility of the caller of this method to pass in a QDateTime 
 // object that is complete, as this method makes no assumptions about the date 
@@ -70,6 +103,7 @@ QSet<QString> Task::getTagsSet() const {
 void Task::setBegin(QDateTime _begin) {
 	//assert(_begin.isValid());
 	begin = _begin;
+	updateMSecs();
 }
 
 // Changes only the date portion of the begin QDateTime field.
@@ -83,6 +117,8 @@ void Task::setBeginDate(QDate _beginDate) {
 	if (!begin.isValid() || !begin.time().isValid()) {
 		begin.setTime(BEGINNING_OF_DAY);
 	}
+
+	updateMSecs();
 }
 
 // Changes only the time portion of the begin QDateTime field.
@@ -96,6 +132,8 @@ void Task::setBeginTime(QTime _beginTime) {
 	if (!begin.isValid() || !begin.date().isValid()) {
 		begin.setDate(QDate::currentDate());
 	}
+
+	updateMSecs();
 }
 
 // Retrives the begin date-time of a task.
@@ -110,6 +148,7 @@ QDateTime Task::getBegin() const {
 void Task::setEnd(QDateTime _end) {
 	//assert(_end.isValid());
 	end = _end;
+	updateMSecs();
 }
 
 // Changes only the date portion of the end QDateTime field.
@@ -122,6 +161,8 @@ void Task::setEndDate(QDate _endDate) {
 	if (!end.isValid() || !end.time().isValid()) {
 		end.setTime(END_OF_DAY);
 	}
+
+	updateMSecs();
 }
 
 // Changes only the time portion of the end QDateTime field.
@@ -134,6 +175,8 @@ void Task::setEndTime(QTime _endTime) {
 	if (!end.isValid() || !end.date().isValid()) {
 		end.setDate(QDate::currentDate());
 	}
+
+	updateMSecs();
 }
 
 // Retrives the end date-time of a task.
@@ -282,14 +325,15 @@ bool Task::isDone() const {
 	return done;
 }
 
-// Sets the ID of a task.
-void Task::setId(int _id) {
-	id = _id;
+// Sets the unique ID of a task. Storage gives every task a unique ID when it
+// is first added, and the task keeps it for good, including on disk.
+void Task::setUid(quint64 _uid) {
+	uid = _uid;
 }
 
-// Retrieves the ID of a task.
-int Task::getId() const {
-	return id;
+// Retrieves the unique ID of a task, or 0 if it has never been stored.
+quint64 Task::getUid() const {
+	return uid;
 }
 
 // Returns TRUE if task has neither a valid begin date/time, nor a valid end 
@@ -302,19 +346,84 @@ bool Task::isFloating() const {
 	}
 }
 
+// Returns the status of this task as of now, as a combination of the
+// STATUS_* bits. Only numbers are compared and nothing is written to the
+// task, so this is safe on tasks that other threads are reading.
+quint8 Task::getStatus(const TimeSnapshot& now) const {
+	qint64 at = now.getMSecs();
+	quint8 status = 0;
+
+	if (end.isValid()) {
+		if (endMSecs < at) {
+			status |= STATUS_OVERDUE;
+			if (endMSecs >= now.getTodayStart()) {
+				status |= STATUS_DUE_TODAY;
+			}
+		} else {
+			if (endMSecs >= now.getTodayStart() && endMSecs <= now.getTodayEnd()) {
+				status |= STATUS_DUE_TODAY;
+			}
+			if (endMSecs >= now.getTomorrowStart()
+				&& endMSecs <= now.getTomorrowEnd()) {
+				status |= STATUS_DUE_TOMORROW;
+			}
+		}
+	}
+
+	if (begin.isValid() && beginMSecs < at && (status & STATUS_OVERDUE) == 0) {
+		status |= STATUS_ONGOING;
+	}
+
+	return status;
+}
+
+// Returns the first time after now, in milliseconds since the epoch, at which
+// the status of this task changes, or NO_STATUS_CHANGE if it never will.
+// Being overdue or ongoing can only change right after the begin or end time,
+// and being due today or tomorrow can only change at the start of the day
+// before the end date, the day of it or the day after it.
+qint64 Task::getNextStatusChange(const TimeSnapshot& now) const {
+	qint64 at = now.getMSecs();
+	qint64 next = NO_STATUS_CHANGE;
+
+	qint64 changes[5];
+	int changeCount = 0;
+
+	if (end.isValid()) {
+		QDate endDate = end.date();
+		changes[changeCount++] = endMSecs + 1;
+		changes[changeCount++] =
+			QDateTime(endDate.addDays(-1), BEGINNING_OF_DAY).toMSecsSinceEpoch();
+		changes[changeCount++] =
+			QDateTime(endDate, BEGINNING_OF_DAY).toMSecsSinceEpoch();
+		changes[changeCount++] =
+			QDateTime(endDate.addDays(1), BEGINNING_OF_DAY).toMSecsSinceEpoch();
+	}
+
+	if (begin.isValid()) {
+		changes[changeCount++] = beginMSecs + 1;
+	}
+
+	for (int i=0; i<changeCount; i++) {
+		if (changes[i] > at && changes[i] < next) {
+			next = changes[i];
+		}
+	}
+
+	return next;
+}
+
 // Returns FALSE if there is no end date/time for this task, or it is not valid
 // Returns FALSE if end date/time for this task is later than current date/time
 // Returns TRUE if end date/time for this task is earlier
 // than current date/time.
 bool Task::isOverdue() const {
-	if (end.isNull() || !end.isValid()) {
-		return false;
-	}
-	if (end < QDateTime::currentDateTime()) {
-		return true;
-	} else {
-		return false;
-	}
+	return isOverdue(TimeSnapshot::current());
+}
+
+// Same as isOverdue(), but as of the time now instead of the current time.
+bool Task::isOverdue(const TimeSnapshot& now) const {
+	return (getStatus(now) & STATUS_OVERDUE) != 0;
 }
 
 // Returns FALSE if there is no begin date/time for this task,
@@ -325,17 +434,12 @@ bool Task::isOverdue() const {
 // Returns TRUE if start date/time for this task is earlier
 // than current date.time.
 bool Task::isOngoing() const {
-	if (begin.isNull() || !begin.isValid()) {
-		return false;
-	}
-	if (isOverdue()) {
-		return false;
-	}
-	if (begin < QDateTime::currentDateTime()) {
-		return true;
-	} else {
-		return false;
-	}
+	return isOngoing(TimeSnapshot::current());
+}
+
+// Same as isOngoing(), but as of the time now instead of the current time.
+bool Task::isOngoing(const TimeSnapshot& now) const {
+	return (getStatus(now) & STATUS_ONGOING) != 0;
 }
 
 // Returns FALSE if task has no valid end date.
@@ -366,26 +470,12 @@ bool Task::isDueOn(QDate _date) const {
 // Returns TRUE if this task is already overdue but the due date is the current
 // day. Returns TRUE if this task has a due date that is within the current day.
 bool Task::isDueToday() const {
-	QDateTime todayStart(QDateTime::currentDateTime().date(), BEGINNING_OF_DAY);
-	QDateTime todayEnd(QDateTime::currentDateTime().date(), END_OF_DAY);
-
-	if (!getEnd().isValid()) {
-		return false;
-	}
-
-	if (isOverdue()) {
-		if (getEnd() >= todayStart) {
-			return true;
-		} else {
-			return false;
-		}
-	}
+	return isDueToday(TimeSnapshot::current());
+}
 
-	if (getEnd() >= todayStart && getEnd() <= todayEnd) {
-		return true;
-	} else {
-		return false;
-	}
+// Same as isDueToday(), but as of the time now instead of the current time.
+bool Task::isDueToday(const TimeSnapshot& now) const {
+	return (getStatus(now) & STATUS_DUE_TODAY) != 0;
 }
 
 // Returns FALSE if this task has no valid end date.
@@ -393,25 +483,12 @@ bool Task::isDueToday() const {
 // Returns FALSE if this task has a due date that is not within the next day
 // Returns TRUE if this task has a due date that is within the next day.
 bool Task::isDueTomorrow() const {
-	QDateTime tomorrowStart(QDateTime::currentDateTime().date().addDays(1), 
-		BEGINNING_OF_DAY);
-	QDateTime tomorrowEnd(QDateTime::currentDateTime().date().addDays(1), 
-		END_OF_DAY);
-	//tomorrowEnd.addDays(1);
-	
-	if (!getEnd().isValid()) {
-		return false;
-	}
-
-	if (isOverdue()) {
-		return false;
-	}
+	return isDueTomorrow(TimeSnapshot::current());
+}
 
-	if (getEnd() >= tomorrowStart && getEnd() <= tomorrowEnd) {
-		return true;
-	} else {
-		return false;
-	}
+// Same as isDueTomorrow(), but as of the time now instead of the current time.
+bool Task::isDueTomorrow(const TimeSnapshot& now) const {
+	return (getStatus(now) & STATUS_DUE_TOMORROW) != 0;
 }
 
 // An event is defined as a task that has a begin and end date/time.
@@ -425,10 +502,10 @@ bool Task::isEvent() const {
 }
 
 // Returns true if this task is equal to the other task; otherwise returns
-// false. The ID field is not considered because ID is unique for each object.
+// false. The ID fields are not considered because ID is unique for each object.
 bool Task::operator==(Task const& other) const {
 	bool sameDescription = (description==other.getDescription());
-	bool sameTags = (tags==other.getTagsSet());
+	bool sameTags = (tags==other.getTagIds());
 	bool sameBegin = (begin==other.getBegin());
 	bool sameEnd = (end==other.getEnd());
 	bool sameDone = (done==other.isDone());
@@ -437,10 +514,10 @@ bool Task::operator==(Task const& other) const {
 }
 
 // Returns true if this task is different to the other task; otherwise returns 
-// false. The ID field is not considered because ID is unique for each object.
+// false. The ID fields are not considered because ID is unique for each object.
 bool Task::operator!=(Task const& other) const {
 	bool sameDescription = (description==other.getDescription());
-	bool sameTags = (tags==other.getTagsSet());
+	bool sameTags = (tags==other.getTagIds());
 	bool sameBegin = (begin==other.getBegin());
 	bool sameEnd = (end==other.getEnd());
 	bool sameDone = (done==other.isDone());
@@ -448,11 +525,15 @@ bool Task::operator!=(Task const& other) const {
 	return !(sameDescription && sameTags && sameBegin && sameEnd && sameDone);
 }
 
+// Serializes a task. The number of tags is written before the tags so that
+// operator>> knows how many to read back. Tags are written by name and no
+// IDs are written, so the format stays the same as in .ini files written by
+// older versions.
 QDataStream& operator<<(QDataStream& out, const Task& task) {
 	out << task.description;
-	QSetIterator<QString> tags(task.tags);
-	while (tags.hasNext()) {
-		out << tags.next();
+	out << (qint32) task.tags.size();
+	foreach (int tagId, task.tags) {
+		out << TagDictionary::name(tagId);
 	}
 	out << task.begin;
 	out << task.end;
@@ -461,18 +542,32 @@ QDataStream& operator<<(QDataStream& out, const Task& task) {
 	return out;
 }
 
+// Deserializes a task written by operator<<.
 QDataStream& operator>>(QDataStream& in, Task& task) {
 	in >> task.description;
-	int numTags = 0;
+	qint32 numTags = 0;
 	in >> numTags;
+	task.tags.clear();
 	for (int i=0; i<numTags; i++) {
 		QString tag;
 		in >> tag;
-		task.tags.insert(tag);
+		int tagId = TagDictionary::intern(tag);
+		if (!task.hasTag(tagId)) {
+			task.tags.insert(std::lower_bound(task.tags.begin(),
+				task.tags.end(), tagId), tagId);
+		}
 	}
 	in >> task.begin;
 	in >> task.end;
 	in >> task.done;
+	task.updateMSecs();
 
 	return in;
+}
+
+// Converts the begin and end to milliseconds since the epoch. Called whenever
+// either changes, which only happens to tasks that are not shared yet.
+void Task::updateMSecs() {
+	beginMSecs = begin.isValid() ? begin.toMSecsSinceEpoch() : 0;
+	endMSecs = end.isValid() ? end.toMSecsSinceEpoch() : 0;
 }
\ No newline at end of file
@@ -5,20 +5,40 @@
 #include <QList>
 #include <QSet>
 #include <QString>
+#include <QVector>
 #include <QDateTime>
+#include "TimeSnapshot.h"
 
 class Task {
 private:
 	QString description;
-	QSet<QString> tags;
+	// IDs from the TagDictionary, in increasing order.
+	QVector<int> tags;
 
 	QDateTime begin;
 	QDateTime end;
 
 	bool done;
-	int id;
+	quint64 uid;
+
+	// The begin and end in milliseconds since the epoch, kept up to date by
+	// the setters so that the status can be worked out without converting
+	// them each time.
+	qint64 beginMSecs;
+	qint64 endMSecs;
+
+	void updateMSecs();
 
 public:
+	// Bits of the status returned by getStatus().
+	static const quint8 STATUS_OVERDUE = 0x1;
+	static const quint8 STATUS_ONGOING = 0x2;
+	static const quint8 STATUS_DUE_TODAY = 0x4;
+	static const quint8 STATUS_DUE_TOMORROW = 0x8;
+
+	// Returned by getNextStatusChange() when the status will never change.
+	static const qint64 NO_STATUS_CHANGE = Q_INT64_C(0x7fffffffffffffff);
+
 	Task();
 	Task(QString _description);
 	~Task();
@@ -30,6 +50,8 @@ public:
 	bool removeTag(QString _tag);
 	QList<QString> getTags() const;
 	QSet<QString> getTagsSet() const;
+	const QVector<int>& getTagIds() const;
+	bool hasTag(int tagId) const;
 
 	void setBegin(QDateTime _begin);
 	void setBeginDate(QDate _beginDate);
@@ -49,14 +71,20 @@ public:
 	void markUndone();
 	bool isDone() const;
 
-	void setId(int _id);
-	int getId() const;
+	void setUid(quint64 _uid);
+	quint64 getUid() const;
 
 	bool isFloating() const;
+	quint8 getStatus(const TimeSnapshot& now) const;
+	qint64 getNextStatusChange(const TimeSnapshot& now) const;
 	bool isOverdue() const;
+	bool isOverdue(const TimeSnapshot& now) const;
 	bool isOngoing() const;
+	bool isOngoing(const TimeSnapshot& now) const;
 	bool isDueToday() const;
+	bool isDueToday(const TimeSnapshot& now) const;
 	bool isDueTomorrow() const;
+	bool isDueTomorrow(const TimeSnapshot& now) const;
 	bool isDueOn(QDate _date) const;
 	bool isEvent() const;
 
@@ -5,7 +5,7 @@
 #include "Constants.h"
 #include "TaskEntry.h"
 
-TaskEntry::TaskEntry(const Task& t, QWidget* parent) : QWidget(parent), task(t)  {
+TaskEntry::TaskEntry(const Task& t, int _id, QWidget* parent) : QWidget(parent), task(t), id(_id)  {
 	initUI();
 	initLabelsArray();
 	initFonts();
@@ -65,7 +65,7 @@ QString TaskEntry::createTagString(const QList<QString>& tags) const {
 // Sets task ID
 void TaskEntry::setID(const int ID) {
 	assert(ID >= 0);
-	ui.ID->setText(QString::number(task.getId() + 1));
+	ui.ID->setText(QString::number(ID + 1));
 }
 
 // Set tooltip
@@ -171,7 +171,7 @@ void TaskEntry::initFonts() {
 
 // This function sets the respective fields in the TaskEntry widget
 void TaskEntry::makeWidget() {
-	setID(task.getId());
+	setID(id);
 	setDescription(task.getDescription());
 	setDateTimes(task.getBegin(), task.getEnd());
 	if (!task.getTags().isEmpty()) {
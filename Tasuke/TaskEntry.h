@@ -17,7 +17,7 @@ class TaskEntry : public QWidget {
 	Q_OBJECT
 
 public:
-	TaskEntry(const Task& t, QWidget *parent = 0);
+	TaskEntry(const Task& t, int _id, QWidget *parent = 0);
 	~TaskEntry();
 
 	Ui::TaskEntry ui;
@@ -39,6 +39,7 @@ private:
 	};
 
 	const Task& task;
+	const int id;
 	QLabel* labels[(char)TaskEntryLabel::TASKENTRYLABEL_LAST_ITEM];
 
 	// Functions
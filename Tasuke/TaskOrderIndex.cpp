@@ -0,0 +1,180 @@
+//@author A0096863M
+#include "Constants.h"
+#include "TaskOrderIndex.h"
+
+TaskOrderIndex::TaskOrderIndex() : frontSequence(0), backSequence(0) {
+}
+
+// Removes every task from the index.
+void TaskOrderIndex::clear() {
+	order.clear();
+	entries.clear();
+	transitions.clear();
+	frontSequence = 0;
+	backSequence = 0;
+}
+
+// Replaces the contents of the index with tasks. Tasks which are equal in
+// every key keep the order they have in tasks.
+void TaskOrderIndex::rebuild(const QVector< QSharedPointer<Task> >& tasks,
+							 const TimeSnapshot& now) {
+	clear();
+	keyTime = now;
+
+	foreach (const QSharedPointer<Task>& task, tasks) {
+		add(task, backSequence++);
+	}
+}
+
+// Adds task after every task that it is equal to in every key.
+void TaskOrderIndex::insert(const QSharedPointer<Task>& task,
+							const TimeSnapshot& now) {
+	add(task, backSequence++);
+	refresh(now);
+}
+
+// Removes task from the index.
+void TaskOrderIndex::remove(const Task& task, const TimeSnapshot& now) {
+	unlink(&task);
+	refresh(now);
+}
+
+// Replaces oldTask with newTask. If newTask is equal in every key to other
+// tasks, it is placed before or after all of them depending on whether
+// oldTask came before or after them, which is where a stable sort of the
+// list with oldTask replaced by newTask would put it.
+void TaskOrderIndex::replace(const Task& oldTask,
+							 const QSharedPointer<Task>& newTask,
+							 const TimeSnapshot& now) {
+	QHash<const Task*, Entry>::const_iterator old = entries.constFind(&oldTask);
+	if (old == entries.constEnd()) {
+		insert(newTask, now);
+		return;
+	}
+
+	Key oldKey = old.value().key;
+	Key newKey = makeKey(*newTask, keyTime, oldKey.sequence);
+
+	qint64 sequence = oldKey.sequence;
+	int comparison = oldKey.compare(newKey);
+	if (comparison < 0) {
+		sequence = --frontSequence;
+	} else if (comparison > 0) {
+		sequence = backSequence++;
+	}
+
+	unlink(&oldTask);
+	add(newTask, sequence);
+	refresh(now);
+}
+
+// Recomputes the keys of the tasks whose status has changed between the last
+// refresh and now.
+void TaskOrderIndex::refresh(const TimeSnapshot& now) {
+	keyTime = now;
+	qint64 nowMsecs = now.getMSecs();
+
+	while (!transitions.isEmpty() && transitions.begin().key() <= nowMsecs) {
+		const Task* task = transitions.begin().value();
+		Entry entry = entries.value(task);
+		QSharedPointer<Task> taskPtr = order.value(entry.key);
+
+		unlink(task);
+		add(taskPtr, entry.key.sequence);
+	}
+}
+
+// Returns the number of tasks in the index.
+int TaskOrderIndex::size() const {
+	return order.size();
+}
+
+// Returns every task in display order.
+QVector< QSharedPointer<Task> > TaskOrderIndex::toList() const {
+	QVector< QSharedPointer<Task> > tasks;
+	tasks.reserve(order.size());
+
+	QMap<Key, QSharedPointer<Task> >::const_iterator it;
+	for (it = order.constBegin(); it != order.constEnd(); it++) {
+		tasks.push_back(it.value());
+	}
+
+	return tasks;
+}
+
+// Indexes task as of the time of the last refresh.
+void TaskOrderIndex::add(const QSharedPointer<Task>& task, qint64 sequence) {
+	Entry entry;
+	entry.key = makeKey(*task, keyTime, sequence);
+	entry.transition = task->getNextStatusChange(keyTime);
+
+	order.insert(entry.key, task);
+	entries.insert(task.data(), entry);
+	if (entry.transition != Task::NO_STATUS_CHANGE) {
+		transitions.insert(entry.transition, task.data());
+	}
+}
+
+// Removes every reference to task from the index.
+void TaskOrderIndex::unlink(const Task* task) {
+	QHash<const Task*, Entry>::iterator it = entries.find(task);
+	if (it == entries.end()) {
+		return;
+	}
+
+	order.remove(it.value().key);
+	if (it.value().transition != Task::NO_STATUS_CHANGE) {
+		transitions.remove(it.value().transition, task);
+	}
+	entries.erase(it);
+}
+
+// Computes the key of task as of the time at. The description is only
+// lowercased once here instead of on every comparison.
+TaskOrderIndex::Key TaskOrderIndex::makeKey(const Task& task,
+											const TimeSnapshot& at,
+											qint64 sequence) {
+	Key key;
+	QDateTime end = task.getEnd();
+	quint8 status = task.getStatus(at);
+
+	key.done = task.isDone();
+	key.noEnd = !end.isValid();
+	key.notOverdue = (status & Task::STATUS_OVERDUE) == 0;
+	key.notDueToday = (status & Task::STATUS_DUE_TODAY) == 0;
+	key.end = end.isValid() ? end.toMSecsSinceEpoch() : 0;
+	key.description = task.getDescription().toLower();
+	key.sequence = sequence;
+
+	return key;
+}
+
+// Returns a negative number if this key comes before other, a positive
+// number if it comes after and 0 if they are equal, ignoring sequence.
+int TaskOrderIndex::Key::compare(const Key& other) const {
+	if (done != other.done) {
+		return done ? 1 : -1;
+	}
+	if (noEnd != other.noEnd) {
+		return noEnd ? 1 : -1;
+	}
+	if (notOverdue != other.notOverdue) {
+		return notOverdue ? 1 : -1;
+	}
+	if (notDueToday != other.notDueToday) {
+		return notDueToday ? 1 : -1;
+	}
+	if (end != other.end) {
+		return end < other.end ? -1 : 1;
+	}
+	return description.compare(other.description);
+}
+
+// Orders keys in display order, using sequence to break ties.
+bool TaskOrderIndex::Key::operator<(const Key& other) const {
+	int result = compare(other);
+	if (result != 0) {
+		return result < 0;
+	}
+	return sequence < other.sequence;
+}
@@ -0,0 +1,73 @@
+//@author A0096863M
+#ifndef TASKORDERINDEX_H
+#define TASKORDERINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include "Task.h"
+#include "TimeSnapshot.h"
+
+// Keeps tasks in display order: tasks that are not done before done ones,
+// then tasks with an end date before those without, overdue first, due today
+// next, then by end date and finally by description, ignoring case. Tasks
+// that are equal in all of these keep the order they were added in.
+//
+// Each task is stored under a single composite key in a balanced tree, so
+// adding, removing or replacing a task only repositions that task. Whether a
+// task is overdue or due today depends on the time, so the keys are computed
+// as of the last refresh() and each task is also filed under the next time its
+// status will change. refresh() only recomputes the keys of tasks whose status
+// has changed since.
+class TaskOrderIndex {
+public:
+	TaskOrderIndex();
+
+	void clear();
+	void rebuild(const QVector< QSharedPointer<Task> >& tasks,
+		const TimeSnapshot& now);
+	void insert(const QSharedPointer<Task>& task, const TimeSnapshot& now);
+	void remove(const Task& task, const TimeSnapshot& now);
+	void replace(const Task& oldTask, const QSharedPointer<Task>& newTask,
+		const TimeSnapshot& now);
+	void refresh(const TimeSnapshot& now);
+
+	int size() const;
+	QVector< QSharedPointer<Task> > toList() const;
+
+private:
+	struct Key {
+		bool done;
+		bool noEnd;
+		bool notOverdue;
+		bool notDueToday;
+		qint64 end;
+		QString description;
+		qint64 sequence;
+
+		int compare(const Key& other) const;
+		bool operator<(const Key& other) const;
+	};
+
+	struct Entry {
+		Key key;
+		qint64 transition;
+	};
+
+	QMap<Key, QSharedPointer<Task> > order;
+	QHash<const Task*, Entry> entries;
+	QMultiMap<qint64, const Task*> transitions;
+	TimeSnapshot keyTime;
+	qint64 frontSequence;
+	qint64 backSequence;
+
+	void add(const QSharedPointer<Task>& task, qint64 sequence);
+	void unlink(const Task* task);
+	static Key makeKey(const Task& task, const TimeSnapshot& at,
+		qint64 sequence);
+};
+
+#endif
@@ -0,0 +1,239 @@
+//@author A0096863M
+#include <algorithm>
+#include <limits>
+#include "TagDictionary.h"
+#include "TaskTable.h"
+
+static const int BITS_PER_WORD = 64;
+static const int OTHER_TAGS_BIT = 63;
+static const QChar DESCRIPTION_END = QChar(0);
+
+const qint64 TaskTable::NO_TIME = std::numeric_limits<qint64>::max();
+
+// Creates an empty table.
+TaskTable::TaskTable() : rows(0) {
+
+}
+
+// Lays out the tasks in _tasks as columns, in the same order.
+TaskTable::TaskTable(const QVector< QSharedPointer<Task> >& _tasks)
+	: tasks(_tasks), rows(_tasks.size()) {
+	begins.resize(rows);
+	ends.resize(rows);
+	done.fill(0, words());
+	tagMasks.fill(0, rows);
+	offsets.resize(rows + 1);
+
+	// The bit of each tag ID, so that each distinct tag is only folded once.
+	QHash<int, int> bitOfTag;
+
+	for (int i=0; i<rows; i++) {
+		const Task& task = *tasks[i];
+
+		begins[i] = toMSecs(task.getBegin());
+		ends[i] = toMSecs(task.getEnd());
+
+		if (task.isDone()) {
+			done[i / BITS_PER_WORD] |= quint64(1) << (i % BITS_PER_WORD);
+		}
+
+		foreach (int tagId, task.getTagIds()) {
+			QHash<int, int>::const_iterator known = bitOfTag.constFind(tagId);
+			int bit = 0;
+			if (known != bitOfTag.constEnd()) {
+				bit = known.value();
+			} else {
+				QString folded = TagDictionary::name(tagId).toCaseFolded();
+				bit = tagBits.value(folded, -1);
+				if (bit < 0 && tagBits.size() < OTHER_TAGS_BIT) {
+					bit = tagBits.size();
+					tagBits.insert(folded, bit);
+				}
+				if (bit < 0) {
+					bit = OTHER_TAGS_BIT;
+				}
+				bitOfTag.insert(tagId, bit);
+			}
+			tagMasks[i] |= quint64(1) << bit;
+		}
+
+		offsets[i] = descriptions.size();
+		descriptions.append(task.getDescription());
+		descriptions.append(DESCRIPTION_END);
+	}
+
+	offsets[rows] = descriptions.size();
+}
+
+// Returns the number of rows in the table.
+int TaskTable::size() const {
+	return rows;
+}
+
+// Returns the rows of the tasks that pass filter as of now, in order. The
+// answers are the same as those of Task::isDone(), isOngoing(), isOverdue(),
+// isDueToday() and isDueTomorrow().
+QVector<int> TaskTable::select(Filter filter, const TimeSnapshot& now) const {
+	qint64 at = now.getMSecs();
+	Bits bits;
+
+	switch (filter) {
+	case DONE:
+		bits = done;
+		break;
+	case UNDONE:
+		bits = done;
+		for (int word=0; word<bits.size(); word++) {
+			bits[word] = ~bits[word];
+		}
+		break;
+	case ONGOING: {
+		// Begun, but not overdue.
+		Bits overdue = inRange(ends, std::numeric_limits<qint64>::min(), at - 1);
+		bits = inRange(begins, std::numeric_limits<qint64>::min(), at - 1);
+		for (int word=0; word<bits.size(); word++) {
+			bits[word] &= ~overdue[word];
+		}
+		break;
+	}
+	case OVERDUE:
+		bits = inRange(ends, std::numeric_limits<qint64>::min(), at - 1);
+		break;
+	case DUE_TODAY:
+		// Overdue tasks only count if they were due earlier today, and those
+		// end within today anyway.
+		bits = inRange(ends, now.getTodayStart(), now.getTodayEnd());
+		break;
+	case DUE_TOMORROW:
+		bits = inRange(ends, now.getTomorrowStart(), now.getTomorrowEnd());
+		break;
+	}
+
+	return toRows(bits);
+}
+
+// Returns the rows of the tasks that have tag, ignoring case, in order. Tags
+// without a bit of their own are checked task by task, but only for the rows
+// that have some such tag.
+QVector<int> TaskTable::selectTag(const QString& tag) const {
+	QString folded = tag.toCaseFolded();
+	int bit = tagBits.value(folded, -1);
+	bool checkEach = bit < 0;
+	if (checkEach) {
+		if (tagBits.size() < OTHER_TAGS_BIT) {
+			return QVector<int>();
+		}
+		bit = OTHER_TAGS_BIT;
+	}
+
+	Bits bits(words(), 0);
+	const quint64* masks = tagMasks.constData();
+	for (int word=0; word<bits.size(); word++) {
+		int base = word * BITS_PER_WORD;
+		int count = qMin(BITS_PER_WORD, rows - base);
+		quint64 matches = 0;
+		for (int j=0; j<count; j++) {
+			matches |= ((masks[base + j] >> bit) & 1) << j;
+		}
+		bits[word] = matches;
+	}
+
+	QVector<int> results = toRows(bits);
+	if (!checkEach) {
+		return results;
+	}
+
+	QVector<int> checked;
+	foreach (int row, results) {
+		foreach (const QString& other, tasks[row]->getTagsSet()) {
+			if (other.toCaseFolded() == folded) {
+				checked.push_back(row);
+				break;
+			}
+		}
+	}
+	return checked;
+}
+
+// Returns the rows of the tasks whose description contains keyword, in order.
+// The whole arena is searched at once, and each hit skips straight to the
+// next description.
+QVector<int> TaskTable::selectDescription(const QString& keyword,
+										  Qt::CaseSensitivity caseSensitivity) const {
+	QVector<int> results;
+	if (keyword.isEmpty()) {
+		for (int i=0; i<rows; i++) {
+			results.push_back(i);
+		}
+		return results;
+	}
+
+	int from = 0;
+	while (true) {
+		int hit = descriptions.indexOf(keyword, from, caseSensitivity);
+		if (hit < 0) {
+			break;
+		}
+
+		int row = std::upper_bound(offsets.constBegin(), offsets.constEnd(), hit)
+			- offsets.constBegin() - 1;
+		results.push_back(row);
+		from = offsets[row + 1];
+	}
+
+	return results;
+}
+
+// Returns the number of 64 bit words in a bitset with a bit for every row.
+int TaskTable::words() const {
+	return (rows + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+// Returns a bitset of the rows whose value in column is from low to high,
+// inclusive.
+TaskTable::Bits TaskTable::inRange(const QVector<qint64>& column,
+								   qint64 low, qint64 high) const {
+	Bits bits(words(), 0);
+	const qint64* values = column.constData();
+
+	for (int word=0; word<bits.size(); word++) {
+		int base = word * BITS_PER_WORD;
+		int count = qMin(BITS_PER_WORD, rows - base);
+		quint64 matches = 0;
+		for (int j=0; j<count; j++) {
+			qint64 value = values[base + j];
+			matches |= quint64((value >= low) & (value <= high)) << j;
+		}
+		bits[word] = matches;
+	}
+
+	return bits;
+}
+
+// Returns the rows set in bits, in order. Bits past the last row are ignored.
+QVector<int> TaskTable::toRows(const Bits& bits) const {
+	QVector<int> results;
+
+	for (int word=0; word<bits.size(); word++) {
+		quint64 matches = bits[word];
+		int row = word * BITS_PER_WORD;
+		while (matches != 0 && row < rows) {
+			if ((matches & 1) != 0) {
+				results.push_back(row);
+			}
+			matches >>= 1;
+			row++;
+		}
+	}
+
+	return results;
+}
+
+// Returns dateTime in milliseconds since the epoch, or NO_TIME if it is not
+// valid.
+qint64 TaskTable::toMSecs(const QDateTime& dateTime) {
+	if (!dateTime.isValid()) {
+		return NO_TIME;
+	}
+	return dateTime.toMSecsSinceEpoch();
+}
@@ -0,0 +1,69 @@
+//@author A0096863M
+#ifndef TASKTABLE_H
+#define TASKTABLE_H
+
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "Task.h"
+#include "TimeSnapshot.h"
+
+// The tasks of one revision laid out column by column, so that filters run
+// as tight loops over contiguous arrays instead of chasing two pointers and
+// decoding a QDateTime for every task.
+//
+// Row i is the i-th task in display order. The begin and end of each task are
+// kept as milliseconds since the epoch, with NO_TIME standing in for a missing
+// one. Done is a bitset. Each of the first 63 distinct tags, case folded, gets
+// its own bit in the tag mask of every row that has it, and the last bit marks
+// rows with any other tag. Descriptions are stored one after the other in a
+// single string, each followed by a '\0', and each row keeps the offset of its
+// own.
+//
+// Every filter first works out a bitset of the matching rows, 64 rows per
+// word, in a branch free loop the compiler can vectorize, and only then turns
+// it into row numbers.
+class TaskTable {
+public:
+	enum Filter {
+		DONE,
+		UNDONE,
+		ONGOING,
+		OVERDUE,
+		DUE_TODAY,
+		DUE_TOMORROW
+	};
+
+	TaskTable();
+	TaskTable(const QVector< QSharedPointer<Task> >& _tasks);
+
+	int size() const;
+	QVector<int> select(Filter filter, const TimeSnapshot& now) const;
+	QVector<int> selectTag(const QString& tag) const;
+	QVector<int> selectDescription(const QString& keyword,
+		Qt::CaseSensitivity caseSensitivity) const;
+
+	static const qint64 NO_TIME;
+
+private:
+	typedef QVector<quint64> Bits;
+
+	QVector< QSharedPointer<Task> > tasks;
+	int rows;
+	QVector<qint64> begins;
+	QVector<qint64> ends;
+	Bits done;
+	QVector<quint64> tagMasks;
+	QHash<QString, int> tagBits;
+	QString descriptions;
+	QVector<int> offsets;
+
+	int words() const;
+	Bits inRange(const QVector<qint64>& column, qint64 low, qint64 high) const;
+	QVector<int> toRows(const Bits& bits) const;
+	static qint64 toMSecs(const QDateTime& dateTime);
+};
+
+#endif
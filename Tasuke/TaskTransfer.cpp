@@ -0,0 +1,304 @@
+//@author A0096863M
+#include <glog/logging.h>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "Constants.h"
+#include "TaskTransfer.h"
+
+// Returns the format of the file at path by its extension: JSON Lines for
+// .jsonl and CSV for anything else.
+TaskTransfer::Format TaskTransfer::formatOf(QString path) {
+	QString suffix = QFileInfo(path).suffix().toLower();
+	if (suffix == TRANSFER_JSONL_EXTENSION) {
+		return JSON_LINES;
+	}
+	return CSV;
+}
+
+// Adds every task in the file at path to storage in one bulk load, and saves
+// once at the end. Rows that cannot be read are skipped. Returns how many
+// tasks were added, or -1 if the file cannot be opened. If added is given,
+// the unique IDs of the new tasks are appended to it.
+int TaskTransfer::importFile(QString path, IStorage& storage,
+							 Progress progress, QVector<quint64>* added) {
+	LOG(INFO) << MSG_TRANSFER_IMPORTING << path.toStdString();
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		LOG(ERROR) << MSG_TRANSFER_OPEN_FAILED << path.toStdString();
+		return -1;
+	}
+
+	Format format = formatOf(path);
+	qint64 total = file.size();
+	int rows = 0;
+	int skipped = 0;
+	QByteArray record;
+
+	int imported = storage.bulkLoad([&](Task& task) {
+		while (readRecord(file, format, record)) {
+			rows++;
+			if (progress && rows % TRANSFER_PROGRESS_INTERVAL == 0) {
+				progress(file.pos(), total);
+			}
+
+			bool ok = false;
+			if (format == JSON_LINES) {
+				ok = fromJson(record, task);
+			} else {
+				QString text = QString::fromUtf8(record);
+				if (rows == 1 && text == TRANSFER_CSV_HEADER) {
+					continue;
+				}
+				ok = fromCsv(text, task);
+			}
+
+			if (ok) {
+				return true;
+			}
+			task = Task();
+			skipped++;
+		}
+		return false;
+	}, added);
+
+	if (progress) {
+		progress(total, total);
+	}
+	if (skipped > 0) {
+		LOG(ERROR) << MSG_TRANSFER_SKIPPED << skipped;
+	}
+
+	if (imported > 0) {
+		storage.saveFile();
+	}
+	return imported;
+}
+
+// Writes tasks to the file at path, in the format given by its extension.
+// The file is written next to path first and only replaces it once it is
+// complete. Returns false if it cannot be written.
+bool TaskTransfer::exportFile(QString path, const TaskView& tasks,
+							  Progress progress) {
+	LOG(INFO) << MSG_TRANSFER_EXPORTING << path.toStdString();
+
+	QString tempPath = path + SNAPSHOT_TEMP_SUFFIX;
+	QFile file(tempPath);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		LOG(ERROR) << MSG_TRANSFER_OPEN_FAILED << tempPath.toStdString();
+		return false;
+	}
+
+	Format format = formatOf(path);
+	QByteArray buffer;
+	buffer.reserve(TRANSFER_BUFFER_SIZE * 2);
+	bool ok = true;
+
+	if (format == CSV) {
+		buffer.append(TRANSFER_CSV_HEADER);
+		buffer.append('\n');
+	}
+
+	for (int i=0; i<tasks.size() && ok; i++) {
+		buffer.append(format == CSV ? toCsv(tasks[i]) : toJson(tasks[i]));
+		buffer.append('\n');
+
+		if (buffer.size() >= TRANSFER_BUFFER_SIZE) {
+			ok = file.write(buffer) == buffer.size();
+			buffer.clear();
+		}
+		if (progress && (i + 1) % TRANSFER_PROGRESS_INTERVAL == 0) {
+			progress(i + 1, tasks.size());
+		}
+	}
+
+	ok = ok && file.write(buffer) == buffer.size();
+	file.close();
+	if (!ok) {
+		LOG(ERROR) << MSG_STORAGE_EXPORT_FAILED << path.toStdString();
+		QFile::remove(tempPath);
+		return false;
+	}
+
+	if (progress) {
+		progress(tasks.size(), tasks.size());
+	}
+
+	QFile::remove(path);
+	return QFile::rename(tempPath, path);
+}
+
+// Returns task as a CSV row, without the line break.
+QByteArray TaskTransfer::toCsv(const Task& task) {
+	QByteArray row;
+	row.append(quoteCsv(task.getDescription()));
+	row.append(',');
+	row.append(toText(task.getBegin()).toLatin1());
+	row.append(',');
+	row.append(toText(task.getEnd()).toLatin1());
+	row.append(',');
+	row.append(task.isDone() ? '1' : '0');
+	row.append(',');
+	row.append(quoteCsv(QStringList(task.getTags()).join(' ')));
+	return row;
+}
+
+// Fills in task from a CSV record. Returns false if the record does not have
+// the right number of fields or has no description.
+bool TaskTransfer::fromCsv(const QString& record, Task& task) {
+	QStringList fields = splitCsv(record);
+	if (fields.size() != TRANSFER_CSV_FIELDS || fields[0].isEmpty()) {
+		return false;
+	}
+
+	task.setDescription(fields[0]);
+	task.setBegin(fromText(fields[1]));
+	task.setEnd(fromText(fields[2]));
+	task.setDone(fields[3] == "1" || fields[3].toLower() == "true");
+	addTags(task, fields[4].split(' ', QString::SkipEmptyParts));
+	return true;
+}
+
+// Returns task as a JSON object on a single line, without the line break.
+QByteArray TaskTransfer::toJson(const Task& task) {
+	QJsonObject object;
+	object.insert(TRANSFER_KEY_DESCRIPTION, task.getDescription());
+	if (task.getBegin().isValid()) {
+		object.insert(TRANSFER_KEY_BEGIN, toText(task.getBegin()));
+	}
+	if (task.getEnd().isValid()) {
+		object.insert(TRANSFER_KEY_END, toText(task.getEnd()));
+	}
+	object.insert(TRANSFER_KEY_DONE, task.isDone());
+	object.insert(TRANSFER_KEY_TAGS,
+		QJsonArray::fromStringList(QStringList(task.getTags())));
+	return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+// Fills in task from a line of JSON. Returns false if the line is not a JSON
+// object or has no description.
+bool TaskTransfer::fromJson(const QByteArray& line, Task& task) {
+	QJsonParseError error;
+	QJsonDocument document = QJsonDocument::fromJson(line, &error);
+	if (error.error != QJsonParseError::NoError || !document.isObject()) {
+		return false;
+	}
+
+	QJsonObject object = document.object();
+	QString description = object.value(TRANSFER_KEY_DESCRIPTION).toString();
+	if (description.isEmpty()) {
+		return false;
+	}
+
+	task.setDescription(description);
+	task.setBegin(fromText(object.value(TRANSFER_KEY_BEGIN).toString()));
+	task.setEnd(fromText(object.value(TRANSFER_KEY_END).toString()));
+	task.setDone(object.value(TRANSFER_KEY_DONE).toBool());
+
+	QStringList tags;
+	foreach (const QJsonValue& tag, object.value(TRANSFER_KEY_TAGS).toArray()) {
+		tags.push_back(tag.toString());
+	}
+	addTags(task, tags);
+	return true;
+}
+
+// Reads the next record of the file into record, without its line break.
+// A CSV record goes on to the next line while it is inside a quoted field.
+// Blank lines are skipped. Returns false at the end of the file.
+bool TaskTransfer::readRecord(QFile& file, Format format, QByteArray& record) {
+	record.clear();
+
+	while (!file.atEnd()) {
+		QByteArray line = file.readLine();
+		while (line.endsWith('\n') || line.endsWith('\r')) {
+			line.chop(1);
+		}
+
+		if (!record.isEmpty()) {
+			record.append('\n');
+		}
+		record.append(line);
+
+		if (format == CSV && record.count('"') % 2 != 0) {
+			continue;
+		}
+		if (!record.isEmpty()) {
+			return true;
+		}
+	}
+
+	return !record.isEmpty();
+}
+
+// Splits a CSV record into its fields, undoing the quoting of quoteCsv().
+QStringList TaskTransfer::splitCsv(const QString& record) {
+	QStringList fields;
+	QString field;
+	bool quoted = false;
+
+	for (int i=0; i<record.size(); i++) {
+		QChar c = record[i];
+		if (quoted) {
+			if (c != '"') {
+				field.append(c);
+			} else if (i + 1 < record.size() && record[i + 1] == '"') {
+				field.append(c);
+				i++;
+			} else {
+				quoted = false;
+			}
+		} else if (c == '"') {
+			quoted = true;
+		} else if (c == ',') {
+			fields.push_back(field);
+			field.clear();
+		} else {
+			field.append(c);
+		}
+	}
+
+	fields.push_back(field);
+	return fields;
+}
+
+// Returns field in UTF-8, in quotes if it has a comma, quote or line break,
+// with quotes inside doubled.
+QByteArray TaskTransfer::quoteCsv(const QString& field) {
+	QByteArray bytes = field.toUtf8();
+	if (bytes.indexOf(',') < 0 && bytes.indexOf('"') < 0
+		&& bytes.indexOf('\n') < 0 && bytes.indexOf('\r') < 0) {
+		return bytes;
+	}
+
+	bytes.replace("\"", "\"\"");
+	return "\"" + bytes + "\"";
+}
+
+// Returns dateTime in ISO 8601, or an empty string if it is not valid.
+QString TaskTransfer::toText(const QDateTime& dateTime) {
+	if (!dateTime.isValid()) {
+		return QString();
+	}
+	return dateTime.toString(Qt::ISODate);
+}
+
+// Returns the time written by toText(), which is not valid if text is empty.
+QDateTime TaskTransfer::fromText(const QString& text) {
+	if (text.isEmpty()) {
+		return QDateTime();
+	}
+	return QDateTime::fromString(text, Qt::ISODate);
+}
+
+// Adds tags to task, leaving out any past the most a task can have.
+void TaskTransfer::addTags(Task& task, const QStringList& tags) {
+	foreach (const QString& tag, tags) {
+		if (tag.isEmpty() || task.getTagIds().size() >= MAXIMUM_TAGS) {
+			continue;
+		}
+		task.addTag(tag);
+	}
+}
@@ -0,0 +1,57 @@
+//@author A0096863M
+#ifndef TASKTRANSFER_H
+#define TASKTRANSFER_H
+
+#include <functional>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include "Task.h"
+#include "TaskView.h"
+#include "Storage.h"
+
+// Moves tasks in and out of Tasuke as CSV or JSON Lines files, a task per
+// row, so that other programs can read and write them.
+//
+// Both directions stream: rows are read and parsed one at a time straight
+// into IStorage::bulkLoad(), and written out in fixed size chunks, so the
+// only memory that grows with the file is the tasks themselves. A CSV file
+// starts with the header "description,begin,end,done,tags"; times are in
+// ISO 8601 and left empty when missing, done is 0 or 1 and tags are
+// separated by spaces. A JSON Lines row is an object with the same keys, with
+// tags as an array. Unique IDs are not transferred.
+//
+// progress, if given, is called every few thousand rows with how far along
+// the transfer is out of a total: bytes of the file for imports and tasks
+// for exports.
+class TaskTransfer {
+public:
+	enum Format {
+		CSV,
+		JSON_LINES
+	};
+
+	typedef std::function<void(qint64 done, qint64 total)> Progress;
+
+	static Format formatOf(QString path);
+	static int importFile(QString path, IStorage& storage,
+		Progress progress = Progress(), QVector<quint64>* added = nullptr);
+	static bool exportFile(QString path, const TaskView& tasks,
+		Progress progress = Progress());
+
+	static QByteArray toCsv(const Task& task);
+	static bool fromCsv(const QString& record, Task& task);
+	static QByteArray toJson(const Task& task);
+	static bool fromJson(const QByteArray& line, Task& task);
+
+private:
+	static bool readRecord(QFile& file, Format format, QByteArray& record);
+	static QStringList splitCsv(const QString& record);
+	static QByteArray quoteCsv(const QString& field);
+	static QString toText(const QDateTime& dateTime);
+	static QDateTime fromText(const QString& text);
+	static void addTags(Task& task, const QStringList& tags);
+};
+
+#endif
@@ -0,0 +1,87 @@
+//@author A0096863M
+#include <cassert>
+#include "TaskView.h"
+
+// Creates an empty view.
+TaskView::TaskView() : filtered(false), first(0), length(0) {
+
+}
+
+// Creates a view of every task in _tasks.
+TaskView::TaskView(const QVector< QSharedPointer<Task> >& _tasks)
+	: tasks(_tasks), filtered(false), first(0), length(_tasks.size()) {
+
+}
+
+// Creates a view of the tasks in _tasks at the positions in _indexes.
+TaskView::TaskView(const QVector< QSharedPointer<Task> >& _tasks,
+				   const QVector<int>& _indexes)
+	: tasks(_tasks), indexes(_indexes), filtered(true), first(0),
+	length(_indexes.size()) {
+
+}
+
+// Returns the number of tasks in the view.
+int TaskView::size() const {
+	return length;
+}
+
+// Same as size().
+int TaskView::count() const {
+	return length;
+}
+
+// Returns true if there are no tasks in the view.
+bool TaskView::isEmpty() const {
+	return length == 0;
+}
+
+// Returns the i-th task in the view without copying it.
+const Task& TaskView::at(int i) const {
+	assert(i >= 0 && i < length);
+
+	if (filtered) {
+		return *tasks[indexes[first + i]];
+	}
+	return *tasks[first + i];
+}
+
+// Same as at().
+const Task& TaskView::operator[](int i) const {
+	return at(i);
+}
+
+// Returns the ID of the i-th task in the view, which is its position in the
+// list of tasks the view was made from.
+int TaskView::idAt(int i) const {
+	assert(i >= 0 && i < length);
+
+	if (filtered) {
+		return indexes[first + i];
+	}
+	return first + i;
+}
+
+// Returns a view of at most _length tasks starting from the offset-th task
+// of this view.
+TaskView TaskView::page(int offset, int _length) const {
+	TaskView result(*this);
+
+	offset = qBound(0, offset, length);
+	result.first = first + offset;
+	result.length = qBound(0, _length, length - offset);
+
+	return result;
+}
+
+// Copies the tasks in the view into a list.
+QList<Task> TaskView::toList() const {
+	QList<Task> results;
+	results.reserve(length);
+
+	for (int i=0; i<length; i++) {
+		results.push_back(at(i));
+	}
+
+	return results;
+}
@@ -0,0 +1,46 @@
+//@author A0096863M
+#ifndef TASKVIEW_H
+#define TASKVIEW_H
+
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+#include "Task.h"
+
+// A read-only view of some of the tasks in storage, in display order.
+//
+// A view shares the list of tasks that storage had when it was made instead
+// of copying the tasks, and a filtered view only keeps the positions of the
+// tasks that matched. Later changes to storage do not change which tasks are
+// in a view. Copying a view or taking a page of it does not copy anything
+// either, so views are cheap to pass around by value.
+//
+// The ID of a task is its position in the list the view was made from, which
+// idAt() gives. Once storage is modified, the IDs in an old view may no
+// longer be those of the same tasks.
+class TaskView {
+public:
+	TaskView();
+	TaskView(const QVector< QSharedPointer<Task> >& _tasks);
+	TaskView(const QVector< QSharedPointer<Task> >& _tasks,
+		const QVector<int>& _indexes);
+
+	int size() const;
+	int count() const;
+	bool isEmpty() const;
+	const Task& at(int i) const;
+	const Task& operator[](int i) const;
+	int idAt(int i) const;
+
+	TaskView page(int offset, int _length) const;
+	QList<Task> toList() const;
+
+private:
+	QVector< QSharedPointer<Task> > tasks;
+	QVector<int> indexes;
+	bool filtered;
+	int first;
+	int length;
+};
+
+#endif
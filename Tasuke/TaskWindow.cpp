@@ -40,7 +40,7 @@ void TaskWindow::highlightTask(int taskID) {
 }
 
 // This function is responsible for showing all the tasks entries and subheadings.
-void TaskWindow::showTasks(const QList<Task>& tasks, const QString& title) {
+void TaskWindow::showTasks(const TaskView& tasks, const QString& title) {
 	LOG(INFO) << "Displaying task list.";
 
 	previousSize = currentTasks.size(); // Size of previous list
@@ -212,7 +212,7 @@ void TaskWindow::handleAddTaskButton() {
 
 // Goes back to default view
 void TaskWindow::handleBackButton() {
-	showTasks(Tasuke::instance().getStorage().getTasks());	
+	showTasks(Tasuke::instance().getStorage().view());	
 	changeTitle("");
 }
 
@@ -248,16 +248,18 @@ void TaskWindow::handleReloadTheme() {
 
 }
 
-// Displays current tasks
+// Displays current tasks. The time is frozen while the list is built so that
+// every task is judged overdue or due today as of the same moment.
 void TaskWindow::displayTaskList() {
 	LOG(INFO) << "Displaying task list";
+	FrozenTime frozen;
 
 	ui.taskList->clear(); // Clear previous list
 	resetSubheadingIndexes(); // Reset subheadings
 	if (currentTasks.size() != 0) {
 		for (int i = 0; i < currentTasks.size(); i++) {
 			displayAndUpdateSubheadings(i);
-			displayTask(currentTasks[i]);
+			displayTask(currentTasks[i], currentTasks.idAt(i));
 			progressBar.setValue((int)((i+1) * 100 / currentTasks.size()));	
 		}
 	} else {
@@ -423,17 +425,18 @@ qreal TaskWindow::getOpacity() const {
 // PRIVATE HELPER TASK DISPLAY FUNCTIONS
 //=========================================
 
-// Creates and returns a new task entry.
-TaskEntry* TaskWindow::createEntry(const Task& t) {
-	TaskEntry* entry = new TaskEntry(t, this);
+// Creates and returns a new task entry for the task with ID id.
+TaskEntry* TaskWindow::createEntry(const Task& t, int id) {
+	TaskEntry* entry = new TaskEntry(t, id, this);
 
 	entry->setStyleSheet(taskEntryNormalStylesheet);
 
-	if (t.isOverdue()) {
+	quint8 status = t.getStatus(TimeSnapshot::current());
+	if (status & Task::STATUS_OVERDUE) {
 		entry->highlightOverdue();
 	}
 
-	if (t.isOngoing()) {
+	if (status & Task::STATUS_ONGOING) {
 		entry->highlightOngoing();
 	}
 	return entry;
@@ -464,8 +467,8 @@ void TaskWindow::addListItem(TaskEntry* entry) {
 }
 
 // Displays a task entry on the list.
-void TaskWindow::displayTask(const Task& t) {
-	TaskEntry * entry = createEntry(t);
+void TaskWindow::displayTask(const Task& t, int id) {
+	TaskEntry * entry = createEntry(t, id);
 	addListItem(entry);
 }
 
@@ -492,12 +495,13 @@ void TaskWindow::resetSubheadingIndexes() {
 
 // For every new list of tasks, subheadings are slotted above differnt sections of tasks.
 void TaskWindow::displayAndUpdateSubheadings(int index) {
-	if (currentTasks[index].isOverdue()) {
+	quint8 status = currentTasks[index].getStatus(TimeSnapshot::current());
+	if (status & Task::STATUS_OVERDUE) {
 		if (subheadingRowIndexes[(char)SubheadingType::OVERDUE] == -1) {
 			subheadingRowIndexes[(char)SubheadingType::OVERDUE] = index;
 			displaySubheading("Overdue tasks");
 		}
-	} else if (currentTasks[index].isDueToday()) {
+	} else if (status & Task::STATUS_DUE_TODAY) {
 		if (subheadingRowIndexes[(char)SubheadingType::DUE_TODAY] == -1) {
 			subheadingRowIndexes[(char)SubheadingType::DUE_TODAY] = index;
 			displaySubheading("Today's tasks");
@@ -618,8 +622,8 @@ void TaskWindow::jumpToCurrentlySelectedTask() {
 void TaskWindow::highlightCurrentlySelectedTask(int prevSize) {
 	// Dehighlight if previous state is not empty
 	if ((isInRange(previouslySelectedTask)) && (prevSize!=0)) { 
-		Task t2 = currentTasks[previouslySelectedTask];
-		TaskEntry * entry2 = createEntry(t2);
+		const Task& t2 = currentTasks[previouslySelectedTask];
+		TaskEntry * entry2 = createEntry(t2, currentTasks.idAt(previouslySelectedTask));
 		int prevSelectedRow = getTaskEntryRow(previouslySelectedTask);
 		addListItemToRow(entry2, prevSelectedRow, "deselect");
 		ui.taskList->takeItem(prevSelectedRow + 1);
@@ -627,8 +631,8 @@ void TaskWindow::highlightCurrentlySelectedTask(int prevSize) {
 
 	// Highlight currently selected
 	if(isInRange(currentlySelectedTask)) {
-		Task t = currentTasks[currentlySelectedTask];
-		TaskEntry * entry = createEntry(t);
+		const Task& t = currentTasks[currentlySelectedTask];
+		TaskEntry * entry = createEntry(t, currentTasks.idAt(currentlySelectedTask));
 		int currSelectedRow = getTaskEntryRow(currentlySelectedTask);
 		addListItemToRow(entry, currSelectedRow, "select");
 		ui.taskList->takeItem(currSelectedRow + 1);
@@ -17,6 +17,7 @@
 #include <QPoint>
 #include <QPropertyAnimation>
 #include "Task.h"
+#include "TaskView.h"
 #include "HotKeyThread.h"
 #include "TaskEntry.h"
 #include "TutorialWidget.h"
@@ -36,7 +37,7 @@ public:
 
 	// Handles task list display
 	void highlightTask(int taskID);
-	void showTasks(const QList<Task>& tasks, const QString& title = "");
+	void showTasks(const TaskView& tasks, const QString& title = "");
 
 	// Handles scrolling (public because InputWindow accesses)
 	void scrollUp();
@@ -91,7 +92,7 @@ private:
 	Ui::TaskWindowClass ui;	
 	QPoint mpos;
 	qreal wOpacity;
-	QList<Task> currentTasks;
+	TaskView currentTasks;
 	QPropertyAnimation animation;
     QProgressBar progressBar;
 	TutorialWidget tutorial;
@@ -121,10 +122,10 @@ private:
 	qreal getOpacity() const;
 
 	//  Private helper functions for task display
-	TaskEntry* createEntry(const Task& t);
+	TaskEntry* createEntry(const Task& t, int id);
 	void addListItemToRow(TaskEntry* entry, int row, const QString& type);
 	void addListItem(TaskEntry* entry);
-	void displayTask(const Task& t);
+	void displayTask(const Task& t, int id);
 	int getTaskEntryRow(int taskID) const;
 
 	// Private helper functions for subheadings display
@@ -1,5 +1,6 @@
 //@author A0096836M
 
+#include <cassert>
 #include <thread>
 #include <glog/logging.h>
 #include <QMessageBox>
@@ -25,8 +26,11 @@ Tasuke::Tasuke() : QObject(nullptr) {
 	
 	loadDictionary();
 	
-	storage = new Storage();
-	storage->loadFile();
+	Storage* diskStorage = new Storage();
+	diskStorage->loadFile();
+	connect(diskStorage, SIGNAL(reloaded(int)),
+		this, SLOT(handleStorageReloaded(int)));
+	storage = diskStorage;
 
 	taskWindow = nullptr;
 	inputWindow = nullptr;
@@ -35,13 +39,9 @@ Tasuke::Tasuke() : QObject(nullptr) {
 	systemTrayWidget = nullptr;
 	hotKeyManager = nullptr;
 
-	// generate interpreter formats on another thread so the user
-	// can use Tasuke as early as possible without waiting for
-	// generation to finish
-	std::thread dateFormatGeneratorThread([]() {
-		Interpreter::initFormats();
-	});
-	dateFormatGeneratorThread.detach();
+	batchDepth = 0;
+	refreshPending = false;
+	pendingHighlight = 0;
 
 	// set up the on the fly input evaluation system
 	qRegisterMetaType<TRY_RESULT>(METATYPE_TRY_RESULT);
@@ -144,7 +144,7 @@ void Tasuke::initGui(){
 	systemTrayWidget = new SystemTrayWidget();
 	hotKeyManager = new HotKeyManager();
 	
-	updateTaskWindow(storage->getTasks());
+	updateTaskWindow(storage->view());
 	showTaskWindow();
 
 	connect(inputWindow, SIGNAL(inputChanged(QString)), 
@@ -194,6 +194,7 @@ void Tasuke::setStorage(IStorage* _storage) {
 	LOG(INFO) << MSG_TASUKE_STORAGE_CHANGED;
 
 	storage = _storage;
+	parseCache.clear();
 }
 
 // Getter for inputwindow. Should only be used when gui mode is enabled.
@@ -366,16 +367,42 @@ void Tasuke::showMessage(QString message) {
 
 // Updates task windows with the latest task and tile.
 // If not title is given, defaults to no title
-void Tasuke::updateTaskWindow(QList<Task> tasks, QString title) {
+// In a batch, only the title is kept and the window is redrawn by
+// commitBatch().
+void Tasuke::updateTaskWindow(const TaskView& tasks, QString title) {
 	if (!guiMode) {
 		return;
 	}
 
+	if (batchDepth > 0) {
+		refreshPending = true;
+		pendingTitle = title;
+		return;
+	}
+
 	LOG(INFO) << MSG_TASUKE_UPDATING_TASKWINDOW(QString::number(tasks.size()));
 
 	taskWindow->showTasks(tasks, title);
 }
 
+// Updates the task window with all tasks in storage that are not done. In a
+// batch, the window is only redrawn by commitBatch(), so the list of tasks is
+// not built for every change.
+// This method acts as a facade interface for other classes to use.
+void Tasuke::refreshTaskWindow() {
+	if (!guiMode) {
+		return;
+	}
+
+	if (batchDepth > 0) {
+		refreshPending = true;
+		pendingTitle = "";
+		return;
+	}
+
+	updateTaskWindow(storage->view());
+}
+
 // Highlight the task with the given id in the task window.
 // The id must be a valid id in the storage
 // This method acts as a facade interface for other classes to use.
@@ -389,6 +416,54 @@ void Tasuke::highlightTask(int id) {
 	taskWindow->highlightTask(id);
 }
 
+// Highlight task in the task window. In a batch, the IDs of tasks are not
+// up to date, so the task is highlighted by commitBatch() instead.
+// This method acts as a facade interface for other classes to use.
+void Tasuke::highlightTask(const Task& task) {
+	if (batchDepth > 0) {
+		pendingHighlight = task.getUid();
+		return;
+	}
+
+	int id = storage->idOf(task.getUid());
+	if (id >= 0) {
+		highlightTask(id);
+	}
+}
+
+// Starts a batch of changes to storage. Until the matching commitBatch(),
+// the task window is not redrawn, and the changes are not published by
+// storage. Batches can be nested.
+void Tasuke::beginBatch() {
+	batchDepth++;
+	storage->beginBatch();
+}
+
+// Ends the batch started by the last beginBatch(). If it was the outermost
+// one, storage publishes the changes and the task window is redrawn once,
+// highlighting the last task that was asked to be highlighted.
+void Tasuke::commitBatch() {
+	assert(batchDepth > 0);
+	storage->commit();
+	batchDepth--;
+	if (batchDepth > 0) {
+		return;
+	}
+
+	if (refreshPending) {
+		refreshPending = false;
+		updateTaskWindow(storage->view(), pendingTitle);
+	}
+
+	if (pendingHighlight != 0) {
+		int id = storage->idOf(pendingHighlight);
+		pendingHighlight = 0;
+		if (id >= 0) {
+			highlightTask(id);
+		}
+	}
+}
+
 // Check if word is correctly spelt or ignored by spell checked.
 // Returns true if accepted, or false is incorrectly spelt.
 // If spell checking is disabled because of missing dictionaries, this
@@ -504,6 +579,15 @@ QString Tasuke::formatTooltipMessage(QString commandString,
 	} else if (commandType == COMMAND_EXIT) {
 		formatPart = FORMAT_EXIT;
 		descriptionPart = DESCRIPTION_EXIT;
+	} else if (commandType == COMMAND_RETAG) {
+		formatPart = FORMAT_RETAG;
+		descriptionPart = DESCRIPTION_RETAG;
+	} else if (commandType == COMMAND_IMPORT) {
+		formatPart = FORMAT_IMPORT;
+		descriptionPart = DESCRIPTION_IMPORT;
+	} else if (commandType == COMMAND_EXPORT) {
+		formatPart = FORMAT_EXPORT;
+		descriptionPart = DESCRIPTION_EXPORT;
 	}
 
 	// highlights the parts marked by pseudo tags
@@ -540,9 +624,16 @@ void Tasuke::runCommand(QString commandString) {
 	}
 
 	try {
-		// interpret the command
-		QSharedPointer<ICommand> command = 
-			QSharedPointer<ICommand>(Interpreter::interpret(commandString));
+		// reuse what the dry run made of the command if storage has not
+		// changed since, otherwise interpret the command
+		QSharedPointer<ICommand> command;
+		if (parseCache.take(commandString, storage->getRevisionNumber(),
+			command)) {
+			LOG(INFO) << MSG_TASUKE_REUSING_DRY_RUN;
+		} else {
+			command = QSharedPointer<ICommand>(
+				Interpreter::interpret(commandString));
+		}
 
 		// if gui enabled update ui
 		if (guiMode) {
@@ -557,6 +648,7 @@ void Tasuke::runCommand(QString commandString) {
 
 		// actually run the object
 		command->run();
+		parseCache.evict(storage->getRevisionNumber());
 
 		// put object into command history
 		LOG(INFO) << MSG_TASUKE_COMMAND_STACK_PUSH;
@@ -628,14 +720,16 @@ void Tasuke::handleInputTimeout() {
 	}
 
 	// spawn another thread to evaluate command
-	std::thread tryThread([&]() {
+	QString text = input;
+	quint64 revision = storage->getRevisionNumber();
+	std::thread tryThread([this, text, revision]() {
 		try {
 			// dry run interpret
-			ICommand* command = Interpreter::interpret(input, true);
+			ICommand* command = Interpreter::interpret(text, true);
 
-			// clean up if required
+			// keep the command for when the user presses enter
 			if (command != nullptr) {
-				delete command;
+				parseCache.putCommand(text, revision, command);
 			}
 		
 			// capture results
@@ -646,12 +740,13 @@ void Tasuke::handleInputTimeout() {
 			// something went wrong, find out what and where
 			QString errorString = exception.what();
 			QString errorWhere = exception.where();
+			parseCache.putError(text, revision, exception);
 
 			// capture the errors
 			TRY_RESULT result;
 			result.status = InputStatus::NORMAL;
 			result.message = 
-				formatTooltipMessage(input, errorString, errorWhere);
+				formatTooltipMessage(text, errorString, errorWhere);
 			emit tryFinish(result);
 		}
 	});
@@ -670,6 +765,14 @@ void Tasuke::handleTryFinish(TRY_RESULT result) {
 	mutex.unlock();
 }
 
+// Redraws the tasks once storage has picked up changes made to the saved
+// tasks outside Tasuke.
+void Tasuke::handleStorageReloaded(int changes) {
+	if (changes > 0) {
+		refreshTaskWindow();
+	}
+}
+
 // Undos the last command
 // If there was no last command, nothing happens
 // This should be primarily called from interpreter
@@ -684,6 +787,7 @@ void Tasuke::undoCommand() {
 	commandUndoHistory.pop_back();
 	command->undo();
 	commandRedoHistory.push_back(command);
+	parseCache.evict(storage->getRevisionNumber());
 	storage->saveFile();
 
 	limitUndoRedo();
@@ -703,6 +807,7 @@ void Tasuke::redoCommand() {
 	commandRedoHistory.pop_back();
 	command->run();
 	commandUndoHistory.push_back(command);
+	parseCache.evict(storage->getRevisionNumber());
 	storage->saveFile();
 
 	limitUndoRedo();
@@ -17,6 +17,7 @@
 #include "SettingsWindow.h"
 #include "SystemTrayWidget.h"
 #include "HotKeyManager.h"
+#include "ParseCache.h"
 
 // This class handles the control flow of the entire program. This class is a
 // singleton; it cannot be created anywhere else because its constructor and
@@ -51,8 +52,12 @@ public:
 	void showSettingsWindow();
 	void showTutorial();
 	void showMessage(QString message);
-	void updateTaskWindow(QList<Task> tasks, QString title = "");
+	void updateTaskWindow(const TaskView& tasks, QString title = "");
+	void refreshTaskWindow();
 	void highlightTask(int id);
+	void highlightTask(const Task& task);
+	void beginBatch();
+	void commitBatch();
 	bool spellCheck(QString word);
 	bool setRunOnStartup(bool yes);
 	QString formatTooltipMessage(QString commandString, 
@@ -79,6 +84,7 @@ private slots:
 	void handleInputChanged(QString text);
 	void handleInputTimeout();
 	void handleTryFinish(TRY_RESULT result);
+	void handleStorageReloaded(int changes);
 
 private:
 	static bool guiMode;
@@ -95,7 +101,12 @@ private:
 	QMutex mutex;
 	QTimer inputTimer;
 	QString input;
+	ParseCache parseCache;
 	bool spellCheckEnabled;
+	int batchDepth;
+	bool refreshPending;
+	QString pendingTitle;
+	quint64 pendingHighlight;
 
 	Tasuke();
 	Tasuke(const Tasuke& old);
@@ -19,7 +19,23 @@ HEADERS += ./Interpreter.h \
     ./TooltipWidget.h \
     ./SubheadingEntry.h \
     ./ThemeStylesheets.h \
-    ./NotificationManager.h
+    ./NotificationManager.h \
+    ./Journal.h \
+    ./Snapshot.h \
+    ./PersistenceWorker.h \
+    ./TaskOrderIndex.h \
+    ./TimeSnapshot.h \
+    ./TagIndex.h \
+    ./TrigramIndex.h \
+    ./TaskView.h \
+    ./IntervalIndex.h \
+    ./Revision.h \
+    ./TaskTable.h \
+    ./TagDictionary.h \
+    ./TaskTransfer.h \
+    ./DateParser.h \
+    ./Substituter.h \
+    ./ParseCache.h
 SOURCES += ./AboutWindow.cpp \
     ./HotKeyManager.cpp \
     ./InputHighlighter.cpp \
@@ -41,7 +57,23 @@ SOURCES += ./AboutWindow.cpp \
     ./TooltipWidget.cpp \
     ./SubheadingEntry.cpp \
     ./ThemeStylesheets.cpp \
-    ./NotificationManager.cpp
+    ./NotificationManager.cpp \
+    ./Journal.cpp \
+    ./Snapshot.cpp \
+    ./PersistenceWorker.cpp \
+    ./TaskOrderIndex.cpp \
+    ./TimeSnapshot.cpp \
+    ./TagIndex.cpp \
+    ./TrigramIndex.cpp \
+    ./TaskView.cpp \
+    ./IntervalIndex.cpp \
+    ./Revision.cpp \
+    ./TaskTable.cpp \
+    ./TagDictionary.cpp \
+    ./TaskTransfer.cpp \
+    ./DateParser.cpp \
+    ./Substituter.cpp \
+    ./ParseCache.cpp
 FORMS += ./TaskWindow.ui \
     ./InputWindow.ui \
     ./AboutWindow.ui \
@@ -0,0 +1,108 @@
+//@author A0096863M
+#include <QThreadStorage>
+#include "Constants.h"
+#include "TimeSnapshot.h"
+
+// The time frozen on a thread, and how many FrozenTimes are holding it.
+struct FrozenState {
+	int depth;
+	TimeSnapshot snapshot;
+
+	FrozenState() : depth(0) {
+	}
+};
+
+static QThreadStorage<FrozenState> frozenStates;
+
+// Reads the clock.
+TimeSnapshot::TimeSnapshot() : hasDays(false) {
+	now = QDateTime::currentDateTime();
+	nowMSecs = now.toMSecsSinceEpoch();
+}
+
+// Takes _now as the time instead of reading the clock.
+TimeSnapshot::TimeSnapshot(const QDateTime& _now) : hasDays(false) {
+	now = _now;
+	nowMSecs = now.toMSecsSinceEpoch();
+}
+
+// Returns the time of this snapshot.
+QDateTime TimeSnapshot::getDateTime() const {
+	return now;
+}
+
+// Returns the time of this snapshot in milliseconds since the epoch.
+qint64 TimeSnapshot::getMSecs() const {
+	return nowMSecs;
+}
+
+// Returns the start of the day of this snapshot in milliseconds since the
+// epoch.
+qint64 TimeSnapshot::getTodayStart() const {
+	computeDays();
+	return todayStart;
+}
+
+// Returns the end of the day of this snapshot in milliseconds since the epoch.
+qint64 TimeSnapshot::getTodayEnd() const {
+	computeDays();
+	return todayEnd;
+}
+
+// Returns the start of the day after this snapshot in milliseconds since the
+// epoch.
+qint64 TimeSnapshot::getTomorrowStart() const {
+	computeDays();
+	return tomorrowStart;
+}
+
+// Returns the end of the day after this snapshot in milliseconds since the
+// epoch.
+qint64 TimeSnapshot::getTomorrowEnd() const {
+	computeDays();
+	return tomorrowEnd;
+}
+
+// Returns the time frozen on this thread if there is one, otherwise reads the
+// clock.
+TimeSnapshot TimeSnapshot::current() {
+	if (frozenStates.hasLocalData() && frozenStates.localData().depth > 0) {
+		return frozenStates.localData().snapshot;
+	}
+
+	return TimeSnapshot();
+}
+
+// Works out the bounds of today and tomorrow the first time they are needed.
+// Converting dates to local time is much slower than reading the clock, and a
+// snapshot often only needs the time itself.
+void TimeSnapshot::computeDays() const {
+	if (hasDays) {
+		return;
+	}
+
+	QDate today = now.date();
+	QDate tomorrow = today.addDays(1);
+	todayStart = QDateTime(today, BEGINNING_OF_DAY).toMSecsSinceEpoch();
+	todayEnd = QDateTime(today, END_OF_DAY).toMSecsSinceEpoch();
+	tomorrowStart = QDateTime(tomorrow, BEGINNING_OF_DAY).toMSecsSinceEpoch();
+	tomorrowEnd = QDateTime(tomorrow, END_OF_DAY).toMSecsSinceEpoch();
+	hasDays = true;
+}
+
+// Freezes the current time on this thread unless it is already frozen. The
+// day bounds are computed up front as every copy handed out by current()
+// would otherwise compute them again.
+FrozenTime::FrozenTime() {
+	FrozenState& state = frozenStates.localData();
+	if (state.depth == 0) {
+		state.snapshot = TimeSnapshot();
+		state.snapshot.getTodayStart();
+	}
+	state.depth++;
+}
+
+// Unfreezes the time on this thread once the outermost freeze ends.
+FrozenTime::~FrozenTime() {
+	frozenStates.localData().depth--;
+}
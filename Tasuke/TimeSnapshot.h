@@ -0,0 +1,52 @@
+//@author A0096863M
+#ifndef TIMESNAPSHOT_H
+#define TIMESNAPSHOT_H
+
+#include <QDateTime>
+
+// A single reading of the clock, together with the bounds of the current day
+// and the next day. Whether a task is overdue, ongoing, due today or due
+// tomorrow is always decided against a snapshot, so that every task looked at
+// during one operation is judged at the same instant and the clock is only
+// read once for all of them.
+class TimeSnapshot {
+public:
+	TimeSnapshot();
+	explicit TimeSnapshot(const QDateTime& _now);
+
+	QDateTime getDateTime() const;
+	qint64 getMSecs() const;
+	qint64 getTodayStart() const;
+	qint64 getTodayEnd() const;
+	qint64 getTomorrowStart() const;
+	qint64 getTomorrowEnd() const;
+
+	static TimeSnapshot current();
+
+private:
+	QDateTime now;
+	qint64 nowMSecs;
+	mutable bool hasDays;
+	mutable qint64 todayStart;
+	mutable qint64 todayEnd;
+	mutable qint64 tomorrowStart;
+	mutable qint64 tomorrowEnd;
+
+	void computeDays() const;
+};
+
+// Freezes the time seen by TimeSnapshot::current() on this thread for as long
+// as it exists. Operations that look at the status of many tasks, like
+// searching or showing the list, create one of these first. Nested freezes
+// keep the time of the outermost one.
+class FrozenTime {
+public:
+	FrozenTime();
+	~FrozenTime();
+
+private:
+	FrozenTime(const FrozenTime&);
+	FrozenTime& operator=(const FrozenTime&);
+};
+
+#endif
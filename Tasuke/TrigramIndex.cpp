@@ -0,0 +1,157 @@
+//@author A0096863M
+#include "TrigramIndex.h"
+
+// Rough sizes, in bytes, of the hash nodes, buckets and headers behind each
+// entry, used by memoryUsage(). They are about right for 64-bit builds.
+static const int BYTES_PER_POSTING = 32;
+static const int BYTES_PER_TRIGRAM = 96;
+static const int BYTES_PER_DESCRIPTION = 56;
+
+static const int TRIGRAM_LENGTH = 3;
+
+TrigramIndex::TrigramIndex() : totalPostings(0) {
+
+}
+
+// Removes every task from the index.
+void TrigramIndex::clear() {
+	postings.clear();
+	descriptions.clear();
+	totalPostings = 0;
+}
+
+// Indexes the description of task.
+void TrigramIndex::insert(const Task* task) {
+	QString folded = task->getDescription().toCaseFolded();
+	descriptions.insert(task, folded);
+
+	foreach (quint64 trigram, trigrams(folded)) {
+		postings[trigram].insert(task);
+		totalPostings++;
+	}
+}
+
+// Removes task from the index.
+void TrigramIndex::remove(const Task* task) {
+	QHash<const Task*, QString>::iterator it = descriptions.find(task);
+	if (it == descriptions.end()) {
+		return;
+	}
+
+	foreach (quint64 trigram, trigrams(it.value())) {
+		QHash<quint64, QSet<const Task*> >::iterator posting =
+			postings.find(trigram);
+		if (posting == postings.end()) {
+			continue;
+		}
+
+		if (posting.value().remove(task)) {
+			totalPostings--;
+		}
+		if (posting.value().isEmpty()) {
+			postings.erase(posting);
+		}
+	}
+
+	descriptions.erase(it);
+}
+
+// Returns every task with a description that contains keyword, in no
+// particular order. The candidates are the tasks in the smallest posting list
+// of the keyword's trigrams that are also in all of the others.
+QList<const Task*> TrigramIndex::find(const QString& keyword,
+									  Qt::CaseSensitivity caseSensitivity) const {
+	QList<const Task*> results;
+	QString foldedKeyword = keyword.toCaseFolded();
+	QSet<quint64> keywordTrigrams = trigrams(foldedKeyword);
+
+	if (keywordTrigrams.isEmpty()) {
+		QHash<const Task*, QString>::const_iterator it;
+		for (it = descriptions.constBegin(); it != descriptions.constEnd(); it++) {
+			if (matches(it.key(), it.value(), keyword, foldedKeyword,
+				caseSensitivity)) {
+				results.push_back(it.key());
+			}
+		}
+		return results;
+	}
+
+	QList<const QSet<const Task*>*> lists;
+	const QSet<const Task*>* smallest = nullptr;
+	foreach (quint64 trigram, keywordTrigrams) {
+		QHash<quint64, QSet<const Task*> >::const_iterator posting =
+			postings.constFind(trigram);
+		if (posting == postings.constEnd()) {
+			return results;
+		}
+
+		lists.push_back(&posting.value());
+		if (smallest == nullptr || posting.value().size() < smallest->size()) {
+			smallest = &posting.value();
+		}
+	}
+
+	foreach (const Task* task, *smallest) {
+		bool inAll = true;
+		for (int i=0; i<lists.size() && inAll; i++) {
+			if (lists[i] != smallest && !lists[i]->contains(task)) {
+				inAll = false;
+			}
+		}
+
+		if (inAll && matches(task, descriptions.value(task), keyword,
+			foldedKeyword, caseSensitivity)) {
+			results.push_back(task);
+		}
+	}
+
+	return results;
+}
+
+// Returns the number of distinct trigrams in the index.
+int TrigramIndex::trigramCount() const {
+	return postings.size();
+}
+
+// Returns the number of (trigram, task) pairs in the index.
+qint64 TrigramIndex::postingCount() const {
+	return totalPostings;
+}
+
+// Returns roughly how many bytes the index takes up.
+qint64 TrigramIndex::memoryUsage() const {
+	qint64 bytes = totalPostings * BYTES_PER_POSTING
+		+ (qint64) postings.size() * BYTES_PER_TRIGRAM;
+
+	QHash<const Task*, QString>::const_iterator it;
+	for (it = descriptions.constBegin(); it != descriptions.constEnd(); it++) {
+		bytes += BYTES_PER_DESCRIPTION + it.value().size() * sizeof(QChar);
+	}
+
+	return bytes;
+}
+
+// Returns every distinct trigram of folded, each packed into an integer.
+QSet<quint64> TrigramIndex::trigrams(const QString& folded) {
+	QSet<quint64> results;
+
+	for (int i=0; i+TRIGRAM_LENGTH<=folded.size(); i++) {
+		quint64 trigram = ((quint64) folded[i].unicode() << 32)
+			| ((quint64) folded[i+1].unicode() << 16)
+			| (quint64) folded[i+2].unicode();
+		results.insert(trigram);
+	}
+
+	return results;
+}
+
+// Returns true if the description of task contains keyword.
+bool TrigramIndex::matches(const Task* task, const QString& folded,
+						   const QString& keyword, const QString& foldedKeyword,
+						   Qt::CaseSensitivity caseSensitivity) {
+	if (caseSensitivity == Qt::CaseSensitive) {
+		return task->getDescription().contains(keyword, Qt::CaseSensitive);
+	}
+
+	return folded.contains(foldedKeyword);
+}
@@ -0,0 +1,45 @@
+//@author A0096863M
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include "Task.h"
+
+// Finds the tasks whose description contains some keyword without looking at
+// every task.
+//
+// Every run of three characters in every case folded description maps to the
+// tasks whose descriptions contain it. A description can only contain the
+// keyword if it contains every trigram of the keyword, so the candidates are
+// the intersection of those tasks, and only the candidates are checked with
+// QString::contains. Keywords shorter than three characters have no trigrams
+// and fall back to checking every task.
+class TrigramIndex {
+public:
+	TrigramIndex();
+
+	void clear();
+	void insert(const Task* task);
+	void remove(const Task* task);
+	QList<const Task*> find(const QString& keyword,
+		Qt::CaseSensitivity caseSensitivity) const;
+
+	int trigramCount() const;
+	qint64 postingCount() const;
+	qint64 memoryUsage() const;
+
+private:
+	QHash<quint64, QSet<const Task*> > postings;
+	QHash<const Task*, QString> descriptions;
+	qint64 totalPostings;
+
+	static QSet<quint64> trigrams(const QString& folded);
+	static bool matches(const Task* task, const QString& folded,
+		const QString& keyword, const QString& foldedKeyword,
+		Qt::CaseSensitivity caseSensitivity);
+};
+
+#endif
@@ -48,5 +48,10 @@ int main(int argc, char *argv[]) {
 	// Create tasuke for the first and only time
 	Tasuke::instance();
 
-	return app.exec();
+	int exitCode = app.exec();
+
+	// writes to disk happen in the background, wait for the last ones
+	Tasuke::instance().getStorage().flush();
+
+	return exitCode;
 }
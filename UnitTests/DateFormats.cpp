@@ -0,0 +1,286 @@
+//@author A0096863M
+#include "Constants.h"
+#include "Interpreter.h"
+#include "DateFormats.h"
+
+// Parses the date by trying every format in turn, the way
+// Interpreter::parseDate() used to.
+QDateTime DateFormats::parse(QString dateString, bool isEnd) {
+	dateString = Interpreter::substituteForDate(dateString);
+	dateString = dateString.trimmed();
+	dateString = dateString.toLower();
+
+	QDate currentDate = QDate::currentDate();
+	QTime timePart = TIME_BEFORE_MIDNIGHT;
+	if (!isEnd) {
+		timePart = TIME_MIDNIGHT;
+	}
+
+	const Lists& formats = lists();
+	QDateTime retVal;
+
+	if (dateString.contains(TIME_AM) || dateString.contains(TIME_PM)) {
+		// if the datetime contains am/pm means we can cut our search space
+
+		// these formats need the date added
+		foreach(QString timeFormat, formats.timeFormatsAp) {
+			QTime timePart = QTime::fromString(dateString, timeFormat);
+			if (timePart.isValid()) {
+				retVal.setDate(currentDate);
+				retVal.setTime(timePart);
+				return retVal;
+			}
+		}
+
+		// these formats need the year added
+		foreach(QString dateTimeFormat, formats.dateTimeFormatsWithoutYearAp) {
+			retVal = QDateTime::fromString(dateString, dateTimeFormat);
+			if (retVal.isValid()) {
+				QDate date = retVal.date();
+				retVal.setDate(QDate(currentDate.year(), date.month(), 
+					date.day()));
+				return retVal;
+			}
+		}
+
+		// these formats are complete
+		foreach(QString dateTimeFormat, formats.dateTimeFormatsAp) {
+			retVal = QDateTime::fromString(dateString, dateTimeFormat);
+			if (retVal.isValid()) {
+				QDate date = retVal.date();
+				if (date.year() < 2000) {
+					// add a century
+					date = date.addYears(100);
+					retVal.setDate(date);
+				}
+				return retVal;
+			}
+		}
+
+		// the other formats do not include am/pm so probably invalid
+		return retVal;
+	}
+
+	// these formats need the date added
+	foreach(QString timeFormat, formats.timeFormats) {
+		QTime timePart = QTime::fromString(dateString, timeFormat);
+		if (timePart.isValid()) {
+			retVal.setDate(currentDate);
+			retVal.setTime(timePart);
+			return retVal;
+		}
+	}
+
+	// these formats need the current year and time added
+	foreach(QString dateFormat, formats.dateFormatsWithoutYear) {
+		retVal = QDateTime::fromString(dateString, dateFormat);
+		if (retVal.isValid()) {
+			QDate date = retVal.date();
+			retVal.setDate(QDate(currentDate.year(), date.month(), 
+				date.day()));
+			retVal.setTime(timePart);
+			return retVal;
+		}
+	}
+	
+	// these formats need the year added
+	foreach(QString dateTimeFormat, formats.dateTimeFormatsWithoutYear) {
+		retVal = QDateTime::fromString(dateString, dateTimeFormat);
+		if (retVal.isValid()) {
+			QDate date = retVal.date();
+			retVal.setDate(QDate(currentDate.year(), date.month(), 
+				date.day()));
+			return retVal;
+		}
+	}
+
+	// these formats need the time added
+	foreach(QString dateFormat, formats.dateFormats) {
+		retVal = QDateTime::fromString(dateString, dateFormat);
+		if (retVal.isValid()) {
+			QDate date = retVal.date();
+			if (date.year() < YEARS_MILIENIUM) {
+				// add a century
+				date = date.addYears(YEARS_CENTURY);
+				retVal.setDate(date);
+			}
+			retVal.setTime(timePart);
+			return retVal;
+		}
+	}
+
+	// these formats are complete
+	foreach(QString dateTimeFormat, formats.dateTimeFormats) {
+		retVal = QDateTime::fromString(dateString, dateTimeFormat);
+		if (retVal.isValid()) {
+			QDate date = retVal.date();
+			if (date.year() < YEARS_MILIENIUM) {
+				// add a century
+				date = date.addYears(YEARS_CENTURY);
+				retVal.setDate(date);
+			}
+			return retVal;
+		}
+	}
+
+	return retVal;
+}
+
+// Returns every date format, in the order parse() tries them within each
+// list.
+QStringList DateFormats::all() {
+	const Lists& formats = lists();
+
+	QStringList all;
+	all << formats.timeFormats << formats.timeFormatsAp
+		<< formats.dateFormatsWithoutYear << formats.dateTimeFormatsWithoutYear
+		<< formats.dateTimeFormatsWithoutYearAp << formats.dateFormats
+		<< formats.dateTimeFormats << formats.dateTimeFormatsAp;
+	return all;
+}
+
+// Returns the formats, generating them the first time. Safe to call from any
+// thread.
+const DateFormats::Lists& DateFormats::lists() {
+	static const Lists formats = generate();
+	return formats;
+}
+
+// Generates every list of formats.
+DateFormats::Lists DateFormats::generate() {
+	Lists lists;
+	generateTimeFormats(lists);
+	generateDateFormatsWithoutYear(lists);
+	generateDateFormats(lists);
+
+	lists.dateTimeFormatsWithoutYear =
+		pair(lists.dateFormatsWithoutYear, lists.timeFormats);
+	lists.dateTimeFormatsWithoutYearAp =
+		pair(lists.dateFormatsWithoutYear, lists.timeFormatsAp);
+	lists.dateTimeFormats = pair(lists.dateFormats, lists.timeFormats);
+	lists.dateTimeFormatsAp = pair(lists.dateFormats, lists.timeFormatsAp);
+	return lists;
+}
+
+// Times: h or hh, then ' ', ':' or '.', then mm, and hhmm'hrs'. Times with am
+// or pm are each of those except hhmm'hrs', then an optional space and ap,
+// then h or hh, an optional space and ap.
+void DateFormats::generateTimeFormats(Lists& lists) {
+	QStringList hourFormats;
+	QStringList minuteFormats;
+	QStringList amPmFormats;
+	QStringList separators;
+	QStringList optionalSpaces;
+
+	hourFormats << "h" << "hh";
+	minuteFormats << "mm";
+	amPmFormats << "ap";
+	separators << " " << ":" << ".";
+	optionalSpaces << " " << "";
+
+	foreach(QString hourFormat, hourFormats) {
+		foreach(QString minuteFormat, minuteFormats) {
+			foreach(QString separator, separators) {
+				lists.timeFormats << (hourFormat + separator + minuteFormat);
+			}
+		}
+	}
+	foreach(QString timeFormat, lists.timeFormats) {
+		foreach(QString amPmFormat, amPmFormats) {
+			foreach(QString optionalSpace, optionalSpaces) {
+				lists.timeFormatsAp << (timeFormat + optionalSpace
+					+ amPmFormat);
+			}
+		}
+	}
+
+	// military time:
+	lists.timeFormats << "hhmm'hrs'";
+	// 5pm:
+	foreach(QString hourFormat, hourFormats) {
+		foreach(QString amPmFormat, amPmFormats) {
+			foreach(QString optionalSpace, optionalSpaces) {
+				lists.timeFormatsAp << (hourFormat + optionalSpace
+					+ amPmFormat);
+			}
+		}
+	}
+}
+
+// Days: d or dd with MMM or MMMM on either side, then d or dd, '/' or '-',
+// M or MM.
+void DateFormats::generateDateFormatsWithoutYear(Lists& lists) {
+	QStringList dayFormats;
+	QStringList speltMonthFormats;
+	QStringList monthFormats;
+	QStringList dateSeparators;
+
+	dayFormats << "d" << "dd";
+	speltMonthFormats << "MMM" << "MMMM";
+	monthFormats << "M" << "MM";
+	dateSeparators << "/" << "-";
+
+	foreach(QString dayFormat, dayFormats) {
+		foreach(QString speltMonthFormat, speltMonthFormats) {
+			lists.dateFormatsWithoutYear << (dayFormat + " "
+				+ speltMonthFormat);
+			// american format:
+			lists.dateFormatsWithoutYear << (speltMonthFormat + " "
+				+ dayFormat);
+		}
+	}
+
+	foreach(QString dayFormat, dayFormats) {
+		foreach(QString monthFormat, monthFormats) {
+			foreach(QString dateSeparator, dateSeparators) {
+				lists.dateFormatsWithoutYear << (dayFormat + dateSeparator
+					+ monthFormat);
+			}
+		}
+	}
+}
+
+// Dates: each day above with yy or yyyy on either side, then d or dd, M or MM
+// and yy or yyyy separated by two '/' or two '-'.
+void DateFormats::generateDateFormats(Lists& lists) {
+	QStringList dayFormats;
+	QStringList monthFormats;
+	QStringList yearFormats;
+	QStringList dateSeparators;
+
+	dayFormats << "d" << "dd";
+	monthFormats << "M" << "MM";
+	yearFormats << "yy" << "yyyy";
+	dateSeparators << "/" << "-";
+
+	foreach(QString dateFormatWithoutYear, lists.dateFormatsWithoutYear) {
+		foreach(QString yearFormat, yearFormats) {
+			lists.dateFormats << (dateFormatWithoutYear + " " + yearFormat);
+			lists.dateFormats << (yearFormat + " " + dateFormatWithoutYear);
+		}
+	}
+
+	foreach(QString dayFormat, dayFormats) {
+		foreach(QString monthFormat, monthFormats) {
+			foreach(QString yearFormat, yearFormats) {
+				foreach(QString dateSeparator, dateSeparators) {
+					lists.dateFormats << (dayFormat + dateSeparator
+						+ monthFormat + dateSeparator + yearFormat);
+				}
+			}
+		}
+	}
+}
+
+// Returns each format in first with each format in second on either side.
+QStringList DateFormats::pair(const QStringList& first,
+							  const QStringList& second) {
+	QStringList pairs;
+	foreach(QString firstFormat, first) {
+		foreach(QString secondFormat, second) {
+			pairs << (firstFormat + " " + secondFormat);
+			pairs << (secondFormat + " " + firstFormat);
+		}
+	}
+	return pairs;
+}
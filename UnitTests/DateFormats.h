@@ -0,0 +1,43 @@
+//@author A0096863M
+#ifndef DATEFORMATS_H
+#define DATEFORMATS_H
+
+#include <QDateTime>
+#include <QStringList>
+
+// Reads dates the way Interpreter::parseDate() did before DateParser, by
+// trying QDateTime formats in turn. Only the tests and the benchmarks use it,
+// as the reference that DateParser is checked and timed against, so the
+// formats are not built into the application.
+//
+// The formats are generated the first time they are needed, the same way
+// Interpreter::initFormats() used to: each list is every combination of its
+// parts, and a list built from two others has both orders of each pair next
+// to each other.
+class DateFormats {
+public:
+	static QDateTime parse(QString dateString, bool isEnd = true);
+	static QStringList all();
+
+private:
+	struct Lists {
+		QStringList timeFormats;
+		QStringList timeFormatsAp;
+		QStringList dateFormatsWithoutYear;
+		QStringList dateFormats;
+		QStringList dateTimeFormatsWithoutYear;
+		QStringList dateTimeFormatsWithoutYearAp;
+		QStringList dateTimeFormats;
+		QStringList dateTimeFormatsAp;
+	};
+
+	static const Lists& lists();
+	static Lists generate();
+	static void generateTimeFormats(Lists& lists);
+	static void generateDateFormatsWithoutYear(Lists& lists);
+	static void generateDateFormats(Lists& lists);
+	static QStringList pair(const QStringList& first,
+		const QStringList& second);
+};
+
+#endif
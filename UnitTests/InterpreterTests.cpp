@@ -32,6 +32,91 @@ namespace InterpreterTests {
 		delete app;
 	}
 
+	// Substitutes commands the way substitute() did before Substituter, by
+	// running a regular expression for each word in turn.
+	QString legacySubstitute(QString text) {
+		QStringList at;
+		at << "by" << "at" << "from" << "on";
+		foreach (const QString& word, at) {
+			text.replace(QRegExp("(?:\\s)" + word + "\\b"), EQUIV_AT_REPLACE);
+		}
+
+		QList<QStringList> words;
+		words << (QStringList() << "do" << "create" << "a")
+			<< (QStringList() << "change" << "update" << "modify" << "e")
+			<< (QStringList() << "rm" << "delete")
+			<< (QStringList() << "ls" << "search" << "find" << "list" << "display")
+			<< (QStringList() << "d")
+			<< (QStringList() << "nd" << "not done")
+			<< (QStringList() << "u")
+			<< (QStringList() << "r")
+			<< (QStringList() << "tutorial" << "guide" << "instructions")
+			<< (QStringList() << "next free time")
+			<< (QStringList() << "options")
+			<< (QStringList() << "quit" << "q");
+		QStringList commands;
+		commands << COMMAND_ADD << COMMAND_EDIT << COMMAND_REMOVE << COMMAND_SHOW
+			<< COMMAND_DONE << COMMAND_UNDONE << COMMAND_UNDO << COMMAND_REDO
+			<< COMMAND_HELP << COMMAND_NEXT << COMMAND_SETTINGS << COMMAND_EXIT;
+		for (int i=0; i<commands.size(); i++) {
+			foreach (const QString& word, words[i]) {
+				text.replace(QRegExp("^" + word + "\\b"), commands[i]);
+			}
+		}
+
+		return text;
+	}
+
+	// Substitutes dates the way substituteForDate() did before Substituter.
+	QString legacySubstituteForDate(QString text) {
+		QDate today = QDate::currentDate();
+		text = text.toLower();
+
+		text.remove(QRegExp(",\\b"));
+		text.remove(QRegExp("\\bthis\\b"));
+		text.remove(QRegExp("\\bnext\\b"));
+		text.remove(QRegExp("\\bnthe\\b"));
+
+		QStringList abbreviations;
+		abbreviations << "2day" << "tmr" << "tml" << "mon" << "tue" << "tues"
+			<< "wed" << "thu" << "thur" << "thurs" << "fri" << "sat" << "sun";
+		QStringList abbreviated;
+		abbreviated << "today" << "tomorrow" << "tomorrow" << "monday"
+			<< "tuesday" << "tuesday" << "wednesday" << "thursday" << "thursday"
+			<< "thursday" << "friday" << "saturday" << "sunday";
+		for (int i=0; i<abbreviations.size(); i++) {
+			text.replace(QRegExp("\\b" + abbreviations[i] + "\\b"),
+				abbreviated[i]);
+		}
+
+		QStringList relative;
+		relative << "yesterday" << "today" << "tomorrow" << "day after tomorrow";
+		for (int i=0; i<relative.size(); i++) {
+			text.replace(QRegExp("\\b" + relative[i] + "\\b"),
+				today.addDays(i - 1).toString(DATE_FORMAT));
+		}
+
+		QStringList days;
+		days << "monday" << "tuesday" << "wednesday" << "thursday" << "friday"
+			<< "saturday" << "sunday";
+		for (int i=0; i<days.size(); i++) {
+			QDate date = today;
+			while (date.dayOfWeek() != i + 1) {
+				date = date.addDays(1);
+			}
+			text.replace(days[i], date.toString(DATE_FORMAT));
+		}
+
+		QStringList times;
+		times << "dawn" << "morning" << "noon" << "afternoon" << "evening"
+			<< "night" << "midnight";
+		for (int i=0; i<times.size(); i++) {
+			text.replace(QRegExp("\\b" + times[i] + "\\b"), TIME_NAMED[i]);
+		}
+
+		return text;
+	}
+
 	TEST_CLASS(InterpreterTests) {
 
 	public:
@@ -185,6 +270,22 @@ namespace InterpreterTests {
 			Tasuke::instance().runCommand("undone 4");
 		}
 
+		// Try interpretting bulk commands with and without a valid condition
+		TEST_METHOD(InterpretWhere) {
+			ICommand* command = Interpreter::interpret("remove where #work");
+			Assert::IsTrue(typeid(*command) == typeid(RemoveWhereCommand));
+			delete command;
+			command = Interpreter::interpret("done where overdue");
+			Assert::IsTrue(typeid(*command) == typeid(EditWhereCommand));
+			delete command;
+			command = Interpreter::interpret("retag #work to #job");
+			Assert::IsTrue(typeid(*command) == typeid(EditWhereCommand));
+			delete command;
+			Assert::ExpectException<ExceptionBadCommand>([] {
+				Interpreter::interpret("remove where sometime");
+			});
+		}
+
 		// Try interpretting all commands with nullptr return
 		TEST_METHOD(InterpretNullReturn) {
 			ICommand* command = Interpreter::interpret("show");
@@ -196,5 +297,83 @@ namespace InterpreterTests {
 			command = Interpreter::interpret("help");
 			Assert::IsTrue(command == nullptr);
 		}
+
+		// The single pass date parser should read every date and time the
+		// generated formats read, to the same value, and reject the rest.
+		TEST_METHOD(ParseDateMatchesFormats) {
+			QList<QDateTime> samples;
+			samples << QDateTime(QDate(2014, 4, 5), QTime(14, 7))
+				<< QDateTime(QDate(2031, 12, 25), QTime(9, 30))
+				<< QDateTime(QDate(2000, 2, 29), QTime(0, 5))
+				<< QDateTime(QDate(2014, 1, 14), QTime(12, 45));
+
+			QStringList inputs;
+			foreach (const QString& format, DateFormats::all()) {
+				foreach (const QDateTime& sample, samples) {
+					inputs << sample.toString(format);
+				}
+			}
+			inputs << "" << "5" << "5 ja" << "32/1" << "12:" << "13 pm"
+				<< "0930 hrs" << "29 feb" << "5  jan" << "sept 5" << "1/2/3/4"
+				<< "+5 jan" << "5:+5" << "12+5hrs" << "1+43hrs"
+				<< "12345 jan" << "123456789012345678901234567890123"
+				<< "+++++++++++++++++++++++++++++++++ jan";
+
+			foreach (const QString& input, inputs) {
+				Assert::IsTrue(Interpreter::parseDate(input)
+					== DateFormats::parse(input));
+				Assert::IsTrue(Interpreter::parseDate(input, false)
+					== DateFormats::parse(input, false));
+			}
+		}
+
+		// Named days should be read as the dates they stand for, including
+		// their abbreviations and names of more than one word.
+		TEST_METHOD(ParseDateNamedDays) {
+			QDate today = QDate::currentDate();
+			QString tomorrow = today.addDays(1).toString(DATE_FORMAT);
+			QString afterTomorrow = today.addDays(2).toString(DATE_FORMAT);
+
+			Assert::IsTrue(Interpreter::parseDate("tmr")
+				== Interpreter::parseDate(tomorrow));
+			Assert::IsTrue(Interpreter::parseDate("this tomorrow night")
+				== Interpreter::parseDate(tomorrow + " 10:00 pm"));
+			Assert::IsTrue(Interpreter::parseDate("day after tomorrow")
+				== Interpreter::parseDate(afterTomorrow));
+		}
+
+		// Substituting in one pass should give what the old regular
+		// expressions gave, apart from "day after tomorrow", which is now
+		// replaced as a whole instead of having "tomorrow" replaced first.
+		TEST_METHOD(SubstituteMatchesRegexCascade) {
+			QStringList commands;
+			commands << "" << "a" << "do buy milk by 5pm" << "create x from 2 on fri"
+				<< "rm 3" << "delete 1-3" << "ls #work" << "search by the sea"
+				<< "d 4" << "nd 4" << "not done 4" << "u" << "r" << "u2 concert on"
+				<< "tutorial" << "next free time" << "options" << "q" << "quit now"
+				<< "done" << "donut at at 5" << "e 2 change name" << "show\tby"
+				<< " do it" << "address book on,by";
+			foreach (const QString& command, commands) {
+				Assert::IsTrue(Interpreter::substitute(command)
+					== legacySubstitute(command));
+			}
+
+			QStringList dates;
+			dates << "" << "tmr" << "this fri, 5pm" << "next tues night"
+				<< "2day noon" << "tml dawn" << "yesterday midnight"
+				<< "today,evening" << "mondays" << "Sunday Afternoon"
+				<< "thurs, 12 jan" << "nthe morning" << "sat/sun" << "fri,sat"
+				<< "tomorrowland" << "5 jan, 2014" << "TMR\tnight";
+			foreach (const QString& date, dates) {
+				Assert::IsTrue(Interpreter::substituteForDate(date)
+					== legacySubstituteForDate(date));
+			}
+
+			QDate today = QDate::currentDate();
+			Assert::IsTrue(Interpreter::substituteForDate("day after tomorrow 5pm")
+				== today.addDays(2).toString(DATE_FORMAT) + " 5pm");
+			Assert::IsTrue(legacySubstituteForDate("day after tomorrow 5pm")
+				== "day after " + today.addDays(1).toString(DATE_FORMAT) + " 5pm");
+		}
 	};
 }
\ No newline at end of file
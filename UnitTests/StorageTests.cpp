@@ -31,6 +31,29 @@ namespace StorageTests {
 		delete app;
 	}
 
+	// Sorts tasks the way storage used to after every change, with one stable
+	// sort per key, from the least important key to the most important.
+	void sortBySixPasses(QList<Task>& tasks) {
+		qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+			return t1.getDescription().toLower() < t2.getDescription().toLower();
+		});
+		qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+			return t1.getEnd() < t2.getEnd();
+		});
+		qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+			return t1.isDueToday() > t2.isDueToday();
+		});
+		qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+			return t1.isOverdue() > t2.isOverdue();
+		});
+		qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+			return t1.getEnd().isValid() && !t2.getEnd().isValid();
+		});
+		qStableSort(tasks.begin(), tasks.end(), [](const Task& t1, const Task& t2) {
+			return t1.isDone() < t2.isDone();
+		});
+	}
+
 	TEST_CLASS(StorageTests) {
 
 	public:
@@ -187,6 +210,39 @@ namespace StorageTests {
 			Assert::IsFalse(task.isDueOn(QDate::currentDate()));
 		}
 
+		// The cached status should be recomputed at each transition, and
+		// when asked about an earlier time than it was computed for.
+		TEST_METHOD(TaskStatusChangesAtTransitions) {
+			QDateTime begin(QDate(2014, 4, 1), QTime(9, 0));
+			QDateTime end(QDate(2014, 4, 2), QTime(12, 0));
+			Task task;
+			task.setBegin(begin);
+			task.setEnd(end);
+
+			TimeSnapshot dayBefore(QDateTime(QDate(2014, 4, 1), QTime(8, 0)));
+			Assert::AreEqual((int)Task::STATUS_DUE_TOMORROW,
+				(int)task.getStatus(dayBefore));
+			Assert::IsTrue(task.getNextStatusChange(dayBefore)
+				== begin.toMSecsSinceEpoch() + 1);
+
+			TimeSnapshot dueDay(QDateTime(QDate(2014, 4, 2), QTime(10, 0)));
+			Assert::AreEqual((int)(Task::STATUS_ONGOING | Task::STATUS_DUE_TODAY),
+				(int)task.getStatus(dueDay));
+
+			TimeSnapshot afterEnd(end.addSecs(1));
+			Assert::AreEqual((int)(Task::STATUS_OVERDUE | Task::STATUS_DUE_TODAY),
+				(int)task.getStatus(afterEnd));
+
+			TimeSnapshot dayAfter(QDateTime(QDate(2014, 4, 3), QTime(0, 0)));
+			Assert::AreEqual((int)Task::STATUS_OVERDUE,
+				(int)task.getStatus(dayAfter));
+			Assert::IsTrue(task.getNextStatusChange(dayAfter)
+				== Task::NO_STATUS_CHANGE);
+
+			Assert::AreEqual((int)Task::STATUS_DUE_TOMORROW,
+				(int)task.getStatus(dayBefore));
+		}
+
 		/********** Tests for STORAGE class **********/
 		
 		TEST_METHOD(StorageSearchByDescription) {
@@ -205,6 +261,216 @@ namespace StorageTests {
 			Assert::AreEqual(storage->searchByDescription("DeScRiPtIoN").size(), 4);
 			Assert::AreEqual(storage->searchByDescription("nonexistent").size(), 0);
 		}
+
+		// A view should keep the tasks it was made from after storage changes,
+		// and pages should be clamped to the view.
+		TEST_METHOD(StorageQueryReturnsViewOfSnapshot) {
+			Tasuke::instance().runCommand("add one");
+			Tasuke::instance().runCommand("add two");
+			Tasuke::instance().runCommand("add three");
+			Tasuke::instance().runCommand("done 1");
+
+			TaskView undone = storage->query(PREDICATE_UNDONE);
+			Assert::AreEqual(undone.size(), 2);
+			Assert::IsTrue(undone.toList() == storage->search(PREDICATE_UNDONE));
+
+			Tasuke::instance().runCommand("add four");
+			Assert::AreEqual(undone.size(), 2);
+			Assert::AreEqual(storage->view().size(), 3);
+
+			TaskView page = undone.page(1, 5);
+			Assert::AreEqual(page.size(), 1);
+			Assert::IsTrue(page[0] == undone[1]);
+			Assert::IsTrue(undone.page(5, 1).isEmpty());
+		}
+
+		// The columnar filters should pick out exactly the tasks whose own
+		// status says they pass, in display order.
+		TEST_METHOD(StorageFiltersMatchTaskStatus) {
+			FrozenTime frozen;
+			QDateTime now = TimeSnapshot::current().getDateTime();
+			qint64 offsets[] = { -3 * 86400, -3600, -60, 60, 3600, 86400,
+				3 * 86400 };
+
+			for (int i=0; i<7; i++) {
+				for (int j=0; j<7; j++) {
+					Task task(QString("task %1 %2").arg(i).arg(j));
+					if (i > 0) {
+						task.setBegin(now.addSecs(offsets[i - 1]));
+					}
+					task.setEnd(now.addSecs(offsets[j]));
+					task.setDone((i + j) % 2 == 0);
+					storage->addTask(task);
+				}
+			}
+			storage->addTask(Task("floating"));
+
+			QList<TaskTable::Filter> filters;
+			QList< std::function<bool(const Task&)> > predicates;
+			filters << PREDICATE_DONE << PREDICATE_UNDONE << PREDICATE_ONGOING
+				<< PREDICATE_OVERDUE << PREDICATE_TODAY << PREDICATE_TOMORROW;
+			predicates << [](const Task& task) { return task.isDone(); }
+				<< [](const Task& task) { return !task.isDone(); }
+				<< [](const Task& task) { return task.isOngoing(); }
+				<< [](const Task& task) { return task.isOverdue(); }
+				<< [](const Task& task) { return task.isDueToday(); }
+				<< [](const Task& task) { return task.isDueTomorrow(); };
+
+			for (int i=0; i<filters.size(); i++) {
+				Assert::IsTrue(storage->search(filters[i])
+					== storage->search(predicates[i]));
+			}
+		}
+
+		// Tasks should share one ID per tag, compare equal whatever order
+		// their tags were added in, and keep their tag names through the
+		// IDs.
+		TEST_METHOD(TaskTagsAreInterned) {
+			Task first("first"), second("second");
+			first.addTag("home");
+			first.addTag("work");
+			second.addTag("work");
+			second.addTag("home");
+
+			Assert::IsTrue(first.getTagIds() == second.getTagIds());
+			Assert::IsTrue(first.getTagsSet() == second.getTagsSet());
+			Assert::IsTrue(first.hasTag(TagDictionary::find("work")));
+			Assert::AreEqual(TagDictionary::find("Work"), -1);
+
+			second.setDescription("first");
+			Assert::IsTrue(first == second);
+
+			Assert::IsTrue(second.removeTag("work"));
+			Assert::IsFalse(second.removeTag("work"));
+			Assert::IsFalse(second.removeTag("never seen"));
+			Assert::IsTrue(first != second);
+			Assert::AreEqual(second.getTags().size(), 1);
+			Assert::AreEqual(second.getTags()[0], QString("home"));
+		}
+
+		// A reader on another thread should only ever see whole revisions,
+		// each at least as new as the last one it saw, while tasks are added.
+		TEST_METHOD(StorageReadersSeeWholeRevisions) {
+			const int count = 200;
+			std::atomic<bool> consistent(true);
+			std::atomic<bool> adding(true);
+
+			std::thread reader([&]() {
+				int lastSize = 0;
+				while (adding) {
+					TaskView tasks = storage->view(false);
+					if (tasks.size() < lastSize) {
+						consistent = false;
+					}
+					for (int i=0; i<tasks.size(); i++) {
+						if (tasks[i].getDescription().isEmpty()) {
+							consistent = false;
+						}
+					}
+					lastSize = tasks.size();
+				}
+			});
+
+			for (int i=0; i<count; i++) {
+				Task task("task " + QString::number(i));
+				storage->addTask(task);
+			}
+			adding = false;
+			reader.join();
+
+			Assert::IsTrue(consistent);
+			Assert::AreEqual(storage->totalTasks(), count);
+		}
+
+		// Short keywords have no trigrams and are checked against every task;
+		// longer ones should follow edits and removals.
+		TEST_METHOD(StorageSearchByDescriptionFollowsChanges) {
+			Tasuke::instance().runCommand("add buy milk");
+			Tasuke::instance().runCommand("add buy bread");
+			Tasuke::instance().runCommand("add call mum");
+
+			Assert::AreEqual(storage->searchByDescription("u").size(), 3);
+			Assert::AreEqual(storage->searchByDescription("buy").size(), 2);
+
+			Task task = storage->getTask(0);
+			task.setDescription("sell bread");
+			storage->editTask(0, task);
+			Assert::AreEqual(storage->searchByDescription("buy").size(), 1);
+			Assert::AreEqual(storage->searchByDescription("BREAD").size(), 2);
+
+			storage->removeTask(0);
+			Assert::AreEqual(storage->searchByDescription("bread").size(), 1);
+		}
+
+		// Searches inside a batch should see the tasks added and edited in
+		// it, at the positions they will have once the batch is committed.
+		TEST_METHOD(StorageSearchInBatchFollowsChanges) {
+			Tasuke::instance().runCommand("add buy milk");
+			Tasuke::instance().runCommand("add call mum");
+
+			storage->beginBatch();
+			Task added("buy bread");
+			storage->addTask(added);
+			Task edited = storage->getTask(1);
+			edited.setDescription("buy flowers for mum");
+			storage->editTask(1, edited);
+
+			TaskView results = storage->queryByDescription("buy");
+			Assert::AreEqual(results.size(), 3);
+			for (int i=0; i<results.size(); i++) {
+				Assert::IsTrue(results[i].getDescription()
+					== storage->getTask(results.idAt(i)).getDescription());
+			}
+			storage->commit();
+		}
+
+		// Overlapping and touching events should form one busy block, and
+		// removing the event that joined them should split it again.
+		TEST_METHOD(StorageFreeSlotsBetweenEvents) {
+			QDateTime day(QDate(2014, 3, 3), QTime(0, 0));
+			qint64 hour = 3600 * 1000;
+
+			Task morning("morning");
+			morning.setBegin(day.addSecs(9 * 3600));
+			morning.setEnd(day.addSecs(11 * 3600));
+			Task lunch("lunch");
+			lunch.setBegin(day.addSecs(10 * 3600));
+			lunch.setEnd(day.addSecs(13 * 3600));
+			Task afternoon("afternoon");
+			afternoon.setBegin(day.addSecs(13 * 3600));
+			afternoon.setEnd(day.addSecs(14 * 3600));
+			Task evening("evening");
+			evening.setBegin(day.addSecs(16 * 3600));
+			evening.setEnd(day.addSecs(17 * 3600));
+			storage->addTask(morning);
+			storage->addTask(lunch);
+			storage->addTask(afternoon);
+			storage->addTask(evening);
+
+			QList<FreeSlot> gaps = storage->freeSlots(day.addSecs(8 * 3600),
+				day.addSecs(18 * 3600), hour);
+			Assert::AreEqual(gaps.size(), 3);
+			Assert::IsTrue(gaps[0] == FreeSlot(day.addSecs(8 * 3600),
+				day.addSecs(9 * 3600)));
+			Assert::IsTrue(gaps[1] == FreeSlot(day.addSecs(14 * 3600),
+				day.addSecs(16 * 3600)));
+			Assert::IsTrue(gaps[2] == FreeSlot(day.addSecs(17 * 3600),
+				day.addSecs(18 * 3600)));
+
+			gaps = storage->freeSlots(day.addSecs(8 * 3600),
+				day.addSecs(18 * 3600), 2 * hour);
+			Assert::AreEqual(gaps.size(), 1);
+
+			Assert::AreEqual(storage->queryOverlapping(day.addSecs(12 * 3600),
+				day.addSecs(16 * 3600)).size(), 2);
+
+			storage->removeTask(storage->queryByDescription("lunch").idAt(0));
+			gaps = storage->freeSlots(day.addSecs(11 * 3600),
+				day.addSecs(13 * 3600), hour);
+			Assert::AreEqual(gaps.size(), 1);
+			Assert::IsTrue(gaps[0] == FreeSlot(day.addSecs(11 * 3600),
+				day.addSecs(13 * 3600)));
+		}
 		
 		TEST_METHOD(StorageSearchByTag) {
 			// Add the test cases
@@ -230,7 +496,32 @@ namespace StorageTests {
 			Assert::AreEqual(storage->searchByTag("TAGCASE").size(), 2);
 			Assert::AreEqual(storage->searchByTag("tagcase").size(), 2);
 		}
+
+		// Tasks with several matching tags should only be returned once, in
+		// display order, and the index should follow edits and removals.
+		TEST_METHOD(StorageSearchByPartialTagReturnsEachTaskOnce) {
+			Tasuke::instance().runCommand("add task1 #tagcase #tag1 #tag3");
+			Tasuke::instance().runCommand("add task2 #TAGCASE #tag1");
+			Tasuke::instance().runCommand("add task3 #tag3 #tag2 #tag1");
+
+			TaskView results = storage->queryByTag("tag");
+			Assert::AreEqual(results.size(), 3);
+			for (int i=0; i<results.size(); i++) {
+				Assert::AreEqual(results.idAt(i), i);
+			}
+			Assert::AreEqual(storage->searchByTag("ag1").size(), 3);
+
+			Task task = storage->getTask(0);
+			task.removeTag("tag1");
+			storage->editTask(0, task);
+			Assert::AreEqual(storage->searchByTag("ag1").size(), 2);
+
+			storage->removeTask(0);
+			Assert::AreEqual(storage->searchByTag("tag").size(), 2);
+			Assert::AreEqual(storage->searchByTag("missing").size(), 0);
+		}
 		
+		// Storage keeps the tasks sorted as they are added.
 		TEST_METHOD(StorageSortByDescription) {
 			QList<Task> correct;
 
@@ -251,11 +542,10 @@ namespace StorageTests {
 			Tasuke::instance().runCommand("add cccc");
 			Tasuke::instance().runCommand("add bbbb");
 
-			storage->sortByDescription();
-
 			Assert::IsTrue(storage->getTasks() == correct);
 		}
 
+		// Storage keeps the tasks sorted as they are added.
 		TEST_METHOD(StorageSortByEndDate) {
 			QList<Task> correct;
 
@@ -277,9 +567,431 @@ namespace StorageTests {
 			storage->addTask(task3);
 			storage->addTask(task2);
 			storage->addTask(task1);
-			storage->sortByEndDate();
 
 			Assert::IsTrue(storage->getTasks() == correct);
 		}
+
+		/********** Tests for the journal **********/
+
+		// Changes saved to the journal should be replayed on the next load.
+		TEST_METHOD(StorageJournalReplay) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-journal-test.ini");
+			QFile::remove(path);
+			QFile::remove(QDir::temp().absoluteFilePath("tasuke-journal-test-0.journal"));
+			QFile::remove(QDir::temp().absoluteFilePath("tasuke-journal-test.snapshot"));
+
+			Task task1("task1"), task2("task2"), task3("task3");
+			task2.addTag("tag");
+
+			{
+				Storage journaled(path);
+				journaled.loadFile();
+				journaled.addTask(task1);
+				journaled.addTask(task2);
+				journaled.addTask(task3);
+				journaled.removeTask(0);
+				Task done = journaled.getTask(0);
+				done.setDone(true);
+				journaled.editTask(0, done);
+				journaled.saveFile();
+			}
+
+			Storage reloaded(path);
+			reloaded.loadFile();
+
+			Assert::AreEqual(2, reloaded.totalTasks());
+			Assert::IsTrue(reloaded.getTask(0) == task3);
+			Assert::IsTrue(reloaded.getTask(1).isDone());
+			Assert::IsTrue(reloaded.getTask(1).getTags().contains("tag"));
+		}
+
+		// A task should keep its unique ID when other tasks are removed, when
+		// it is edited and when it is saved and loaded again.
+		TEST_METHOD(StorageUidsAreStable) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-uid-test.ini");
+			QFile::remove(path);
+			QFile::remove(QDir::temp().absoluteFilePath("tasuke-uid-test-0.journal"));
+			QFile::remove(QDir::temp().absoluteFilePath("tasuke-uid-test.snapshot"));
+
+			Task task1("task1"), task2("task2"), task3("task3");
+			quint64 uid = 0;
+
+			{
+				Storage journaled(path);
+				journaled.loadFile();
+				journaled.addTask(task1);
+				journaled.addTask(task2);
+				uid = journaled.addTask(task3).getUid();
+				Assert::AreNotEqual(uid, (quint64) 0);
+
+				journaled.removeTask(0);
+				Assert::AreEqual(journaled.idOf(uid), 1);
+
+				Task edited = journaled.getTaskByUid(uid);
+				edited.setDescription("task3 edited");
+				Assert::AreEqual(journaled.editTaskByUid(uid, edited).getUid(), uid);
+				journaled.saveFile();
+			}
+
+			Storage reloaded(path);
+			reloaded.loadFile();
+
+			Assert::IsTrue(reloaded.getTaskByUid(uid).getDescription() == "task3 edited");
+			reloaded.removeTaskByUid(uid);
+			Assert::AreEqual(reloaded.idOf(uid), -1);
+			Assert::AreEqual(reloaded.totalTasks(), 1);
+		}
+
+		// Old done tasks should leave memory when loading, keep their unique
+		// IDs reserved while archived, and be listed after the tasks in memory
+		// by queries that ask for them without coming back. Changing one by
+		// the ID it is listed at should bring it back and drop it from the
+		// archive.
+		TEST_METHOD(StorageArchivesOldDoneTasks) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-archive-test.ini");
+			QStringList files;
+			files << path << "tasuke-archive-test-0.journal"
+				<< "tasuke-archive-test.snapshot" << "tasuke-archive-test.archive";
+			foreach (const QString& file, files) {
+				QFile::remove(QDir::temp().absoluteFilePath(file));
+			}
+
+			Task old("old"), recent("recent"), active("active");
+			old.setEnd(QDateTime::currentDateTime().addDays(-60));
+			old.setDone(true);
+			recent.setEnd(QDateTime::currentDateTime().addDays(-1));
+			recent.setDone(true);
+			active.setEnd(QDateTime::currentDateTime().addDays(-60));
+			quint64 uid = 0;
+
+			{
+				Storage first(path);
+				first.setArchiveAge(30);
+				first.loadFile();
+				uid = first.addTask(old).getUid();
+				first.addTask(recent);
+				first.addTask(active);
+				first.saveFile();
+			}
+
+			{
+				Storage archiving(path);
+				archiving.setArchiveAge(30);
+				archiving.loadFile();
+				Assert::AreEqual(archiving.totalTasks(), 2);
+				Assert::AreEqual(archiving.idOf(uid), -1);
+				Task added("new");
+				Assert::IsTrue(archiving.addTask(added).getUid() > uid);
+				archiving.saveFile();
+			}
+
+			Storage reloaded(path);
+			reloaded.setArchiveAge(30);
+			reloaded.loadFile();
+			Assert::AreEqual(reloaded.totalTasks(), 3);
+
+			TaskView done = reloaded.query(PREDICATE_DONE, true);
+			Assert::AreEqual(done.size(), 2);
+			Assert::IsTrue(done[1].getDescription() == "old");
+			Assert::AreEqual(done.idAt(1), 3);
+			Assert::AreEqual(reloaded.totalTasks(), 3);
+			Assert::AreEqual(reloaded.totalTasks(true), 4);
+			Assert::IsTrue(reloaded.getTask(3).getUid() == uid);
+			Assert::AreEqual(reloaded.queryByDescription("OLD",
+				Qt::CaseInsensitive, true).size(), 1);
+
+			QString archivePath =
+				QDir::temp().absoluteFilePath("tasuke-archive-test.archive");
+			reloaded.saveFile();
+			reloaded.flush();
+			Assert::IsTrue(QFile::exists(archivePath));
+
+			Task undone = reloaded.getTaskByUid(uid);
+			undone.setDone(false);
+			reloaded.editTask(3, undone);
+			reloaded.saveFile();
+			reloaded.flush();
+			Assert::AreEqual(reloaded.totalTasks(), 4);
+			Assert::AreEqual(reloaded.totalTasks(true), 4);
+			Assert::IsFalse(reloaded.getTaskByUid(uid).isDone());
+
+			Snapshot archived;
+			Assert::IsTrue(archived.open(archivePath));
+			Assert::AreEqual(archived.size(), 0);
+		}
+
+		// Changes written to the saved tasks by another instance should be
+		// picked up by a reload, which touches only the tasks that differ.
+		TEST_METHOD(StorageReloadAppliesOutsideChanges) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-reload-test.ini");
+			QStringList files;
+			files << path << "tasuke-reload-test-0.journal"
+				<< "tasuke-reload-test.snapshot";
+			foreach (const QString& file, files) {
+				QFile::remove(QDir::temp().absoluteFilePath(file));
+			}
+
+			Task task1("task1"), task2("task2"), task3("task3"), task4("task4");
+
+			Storage watching(path);
+			watching.loadFile();
+			quint64 uid1 = watching.addTask(task1).getUid();
+			quint64 uid2 = watching.addTask(task2).getUid();
+			watching.addTask(task3);
+			watching.saveFile();
+			watching.flush();
+			Assert::AreEqual(0, watching.reload());
+
+			{
+				Storage other(path);
+				other.loadFile();
+				Task edited = other.getTaskByUid(uid1);
+				edited.setDone(true);
+				other.editTaskByUid(uid1, edited);
+				other.removeTaskByUid(uid2);
+				other.addTask(task4);
+				other.saveFile();
+			}
+
+			Assert::AreEqual(3, watching.reload());
+			Assert::AreEqual(3, watching.totalTasks());
+			Assert::IsTrue(watching.getTaskByUid(uid1).isDone());
+			Assert::AreEqual(-1, watching.idOf(uid2));
+			Assert::AreEqual(1, watching.searchByDescription("task4").size());
+			Assert::AreEqual(0, watching.reload());
+
+			// the journal was opened again, so new changes are not lost
+			watching.addTask(task2);
+			watching.saveFile();
+			watching.flush();
+			Storage reloaded(path);
+			reloaded.loadFile();
+			Assert::AreEqual(4, reloaded.totalTasks());
+		}
+
+		// A .ini file edited after the tasks were last saved should replace
+		// them when reloading, and still be what is loaded afterwards.
+		TEST_METHOD(StorageReloadImportsEditedIni) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-ini-test.ini");
+			QStringList files;
+			files << path << "tasuke-ini-test-0.journal"
+				<< "tasuke-ini-test-1.journal" << "tasuke-ini-test-2.journal"
+				<< "tasuke-ini-test.snapshot";
+			foreach (const QString& file, files) {
+				QFile::remove(QDir::temp().absoluteFilePath(file));
+			}
+
+			Task task1("task1"), task2("task2"), edited("edited");
+
+			{
+				Storage watching(path);
+				watching.loadFile();
+				watching.addTask(task1);
+				watching.addTask(task2);
+				watching.saveFile();
+				watching.flush();
+
+				// file times may only be kept to the second
+				std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+				QList<Task> editedTasks;
+				editedTasks << edited;
+				Assert::IsTrue(Storage::writeIni(path, editedTasks, 0));
+
+				Assert::AreEqual(3, watching.reload());
+				Assert::AreEqual(1, watching.totalTasks());
+				Assert::IsTrue(watching.getTask(0).getDescription() == "edited");
+				watching.flush();
+			}
+
+			Storage reloaded(path);
+			reloaded.loadFile();
+			Assert::AreEqual(1, reloaded.totalTasks());
+			Assert::IsTrue(reloaded.getTask(0).getDescription() == "edited");
+		}
+
+		// Reloading a .ini file edited by hand should keep the unique IDs of
+		// the tasks in it, so that only the edited task changes and commands
+		// run before the reload can still be undone.
+		TEST_METHOD(StorageReloadFromIniKeepsUndo) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-undo-test.ini");
+			QStringList files;
+			files << path << "tasuke-undo-test-0.journal"
+				<< "tasuke-undo-test-1.journal" << "tasuke-undo-test-2.journal"
+				<< "tasuke-undo-test.snapshot";
+			foreach (const QString& file, files) {
+				QFile::remove(QDir::temp().absoluteFilePath(file));
+			}
+
+			Task task1("task1"), task2("task2"), edited("edited");
+
+			Storage watching(path);
+			Tasuke::instance().setStorage(&watching);
+			watching.loadFile();
+			quint64 uid1 = watching.addTask(task1).getUid();
+			quint64 uid2 = watching.addTask(task2).getUid();
+			EditCommand command(watching.idOf(uid1), edited);
+			command.run();
+			watching.saveFile();
+			watching.flush();
+
+			// file times may only be kept to the second
+			std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+			QList<Task> editedTasks = watching.getTasks();
+			for (int i=0; i<editedTasks.size(); i++) {
+				if (editedTasks[i].getUid() == uid2) {
+					editedTasks[i].setDescription("task2 edited by hand");
+				}
+			}
+			Assert::IsTrue(Storage::writeIni(path, editedTasks, 0));
+
+			Assert::AreEqual(1, watching.reload());
+			Assert::AreEqual(2, watching.totalTasks());
+			Assert::IsTrue(watching.getTaskByUid(uid2).getDescription()
+				== "task2 edited by hand");
+
+			command.undo();
+			Assert::IsTrue(watching.getTaskByUid(uid1).getDescription()
+				== "task1");
+			watching.flush();
+			Tasuke::instance().setStorage(storage);
+		}
+
+		/********** Tests for the binary snapshot **********/
+
+		// A snapshot should give back exactly the tasks that were written.
+		TEST_METHOD(SnapshotRoundTrip) {
+			QString path = QDir::temp().absoluteFilePath("tasuke-test.snapshot");
+
+			Task task1("task1"), task2("task2"), task3("");
+			task1.setBegin(QDateTime(QDate(2014, 4, 1), QTime(9, 0)));
+			task1.setEnd(QDateTime(QDate(2014, 4, 1), QTime(10, 30)));
+			task1.addTag("shared");
+			task2.addTag("shared");
+			task2.addTag("other");
+			task2.setDone(true);
+			task2.setUid(42);
+
+			QList<Task> written;
+			written << task1 << task2 << task3;
+			Assert::IsTrue(Snapshot::write(path, written, 7));
+
+			Snapshot snapshot;
+			Assert::IsTrue(snapshot.open(path));
+			Assert::AreEqual(3, snapshot.size());
+			Assert::AreEqual(7, snapshot.generation());
+			for (int i=0; i<written.size(); i++) {
+				Assert::IsTrue(snapshot.task(i) == written[i]);
+			}
+			Assert::IsTrue(snapshot.begin(2).isNull());
+			Assert::IsTrue(snapshot.uid(1) == 42);
+
+			snapshot.close();
+			QFile::remove(path);
+		}
+
+		// Tasks exported to CSV or JSON Lines should be imported back the
+		// same, including quotes, commas and line breaks in descriptions.
+		TEST_METHOD(TaskTransferRoundTrip) {
+			Task task1("buy eggs, milk"), task2("say \"hi\"\nthen leave");
+			task1.setBegin(QDateTime(QDate(2014, 4, 1), QTime(9, 0)));
+			task1.setEnd(QDateTime(QDate(2014, 4, 1), QTime(10, 30)));
+			task1.addTag("shopping");
+			task1.addTag("errand");
+			task2.setDone(true);
+			storage->addTask(task1);
+			storage->addTask(task2);
+
+			QStringList paths;
+			paths << QDir::temp().absoluteFilePath("tasuke-transfer-test.csv")
+				<< QDir::temp().absoluteFilePath("tasuke-transfer-test.jsonl");
+
+			foreach (const QString& path, paths) {
+				qint64 lastDone = -1;
+				Assert::IsTrue(TaskTransfer::exportFile(path, storage->view(false)));
+
+				StorageStub imported;
+				int count = TaskTransfer::importFile(path, imported,
+					[&lastDone](qint64 done, qint64 total) {
+					lastDone = done;
+					Assert::IsTrue(done <= total);
+				});
+				Assert::AreEqual(2, count);
+				Assert::IsTrue(lastDone == QFile(path).size());
+				for (int i=0; i<2; i++) {
+					Assert::IsTrue(imported.getTask(i) == storage->getTask(i));
+				}
+				QFile::remove(path);
+			}
+		}
+
+		/********** Tests for the persistence worker **********/
+
+		// A burst of changes should be written to disk only once.
+		TEST_METHOD(PersistenceWorkerCoalescesWrites) {
+			int written = 0;
+			PersistenceWorker worker([&written]() {
+				written++;
+			});
+			worker.setPolicy(DurabilityPolicy::IDLE, 60000);
+
+			for (int i=0; i<100; i++) {
+				worker.markDirty();
+			}
+			worker.flush();
+
+			Assert::AreEqual(1, written);
+			Assert::AreEqual(1, worker.writeCount());
+		}
+
+		// Nothing marked dirty should be lost when the worker is stopped.
+		TEST_METHOD(PersistenceWorkerWritesOnStop) {
+			int written = 0;
+			PersistenceWorker worker([&written]() {
+				written++;
+			});
+			worker.setPolicy(DurabilityPolicy::INTERVAL, 60000);
+
+			worker.markDirty();
+			worker.stop();
+
+			Assert::AreEqual(1, written);
+		}
+
+		/********** Tests for the order index **********/
+
+		// The incrementally maintained order should be the same as sorting
+		// the list by every key in turn, after adds, edits and removes.
+		TEST_METHOD(StorageOrderMatchesSortingByEveryKey) {
+			QDateTime now = QDateTime::currentDateTime();
+			QStringList descriptions;
+			descriptions << "Zebra" << "apple" << "Apple" << "mango" << "kiwi";
+
+			for (int i=0; i<40; i++) {
+				Task task(descriptions[i % descriptions.size()]);
+				if (i % 4 != 0) {
+					task.setEnd(now.addSecs((i % 7 - 3) * 12 * 3600));
+				}
+				task.setDone(i % 5 == 0);
+				storage->addTask(task);
+			}
+
+			for (int i=0; i<10; i++) {
+				Task task = storage->getTask(i * 3);
+				task.setDescription(descriptions[i % descriptions.size()]);
+				task.setDone(!task.isDone());
+				storage->editTask(i * 3, task);
+			}
+			storage->removeTask(5);
+			storage->popTask();
+
+			QList<Task> ordered = storage->getTasks(false);
+			QList<Task> sorted = ordered;
+			sortBySixPasses(sorted);
+
+			Assert::IsTrue(sorted == ordered);
+			for (int i=0; i<ordered.size(); i++) {
+				Assert::AreEqual(i, storage->idOf(ordered[i].getUid()));
+			}
+		}
 	};
 }
\ No newline at end of file
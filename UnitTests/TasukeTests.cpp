@@ -79,6 +79,114 @@ namespace UnitTest {
 			Assert::AreEqual(storage->totalTasks(), 2);
 		}
 
+		// System testing for commands that pick tasks by a condition
+		TEST_METHOD(TasukeBulkCommands) {
+			Tasuke::instance().runCommand("add buy eggs #shopping");
+			Tasuke::instance().runCommand("add buy milk #Shopping #errand");
+			Tasuke::instance().runCommand("add do homework #school");
+
+			Tasuke::instance().runCommand("retag #shopping to #groceries");
+			Assert::AreEqual(storage->queryWithTag("shopping").size(), 0);
+			Assert::AreEqual(storage->queryWithTag("groceries").size(), 2);
+
+			Tasuke::instance().runCommand("done where #groceries");
+			Assert::AreEqual(storage->query(PREDICATE_DONE).size(), 2);
+
+			Tasuke::instance().runCommand("remove where done");
+			Assert::AreEqual(storage->totalTasks(), 1);
+
+			Tasuke::instance().undoCommand();
+			Tasuke::instance().undoCommand();
+			Tasuke::instance().undoCommand();
+			Assert::AreEqual(storage->totalTasks(), 3);
+			Assert::AreEqual(storage->query(PREDICATE_DONE).size(), 0);
+			Assert::AreEqual(storage->queryWithTag("shopping").size(), 2);
+			Assert::AreEqual(storage->queryWithTag("errand").size(), 1);
+		}
+
+		// System testing for import and export commands
+		TEST_METHOD(TasukeImportExport) {
+			Tasuke::instance().runCommand("add buy eggs #shopping");
+			Tasuke::instance().runCommand("add do homework");
+			Tasuke::instance().runCommand("done 2");
+
+			QString path = QDir::temp().absoluteFilePath("tasuke-export-test.csv");
+			QString quoted = "\"" + path + "\"";
+			QFile::remove(path);
+			Tasuke::instance().runCommand("export " + quoted);
+			Assert::IsTrue(QFile::exists(path));
+
+			Tasuke::instance().runCommand("import " + quoted);
+			Assert::AreEqual(storage->totalTasks(), 4);
+			Assert::AreEqual(storage->queryWithTag("shopping").size(), 2);
+			Assert::AreEqual(storage->query(PREDICATE_DONE).size(), 2);
+
+			Tasuke::instance().undoCommand();
+			Assert::AreEqual(storage->totalTasks(), 2);
+			Tasuke::instance().redoCommand();
+			Assert::AreEqual(storage->totalTasks(), 4);
+
+			QFile::remove(path);
+			Assert::ExpectException<ExceptionBadCommand>([&quoted] {
+				delete Interpreter::interpret("import " + quoted);
+			});
+		}
+
+		// System testing that commands on many tasks publish one revision
+		TEST_METHOD(TasukeCompositeCommandsPublishOnce) {
+			Tasuke::instance().runCommand("add do homework");
+			Tasuke::instance().runCommand("add buy eggs");
+			Tasuke::instance().runCommand("add watch anime");
+
+			quint64 before = storage->getRevisionNumber();
+			Tasuke::instance().runCommand("done 1-3");
+			Assert::IsTrue(storage->getRevisionNumber() == before + 1);
+			Assert::IsTrue(storage->isAllDone());
+			Assert::IsFalse(storage->inBatch());
+
+			Tasuke::instance().undoCommand();
+			Assert::IsTrue(storage->getRevisionNumber() == before + 2);
+			Assert::AreEqual(storage->getTasks().size(), 3);
+			for (int i=0; i<3; i++) {
+				Assert::IsFalse(storage->getTask(i).isDone());
+				Assert::AreEqual(storage->idOf(storage->getTask(i).getUid()), i);
+			}
+
+			Tasuke::instance().runCommand("clear");
+			Assert::AreEqual(storage->totalTasks(), 0);
+			before = storage->getRevisionNumber();
+			Tasuke::instance().undoCommand();
+			Assert::IsTrue(storage->getRevisionNumber() == before + 1);
+			Assert::AreEqual(storage->totalTasks(), 3);
+		}
+
+		// A command built by the dry run should only be reused for the same
+		// text at the same revision, and only once
+		TEST_METHOD(ParseCacheReusesOnlyCurrentRevision) {
+			ParseCache cache;
+			QSharedPointer<ICommand> command;
+			quint64 revision = storage->getRevisionNumber();
+
+			cache.putCommand("add buy eggs", revision,
+				Interpreter::interpret("add buy eggs", true));
+			Assert::IsFalse(cache.take("add buy egg", revision, command));
+			Assert::IsTrue(cache.take("add buy eggs", revision, command));
+			Assert::IsTrue(command != nullptr);
+			Assert::IsFalse(cache.take("add buy eggs", revision, command));
+
+			cache.putError("bad command", revision,
+				ExceptionBadCommand(ERROR_DONT_UNDERSTAND));
+			Assert::ExpectException<ExceptionBadCommand>([&] {
+				cache.take("bad command", revision, command);
+			});
+
+			cache.putCommand("add buy eggs", revision,
+				Interpreter::interpret("add buy eggs", true));
+			command->run();
+			cache.evict(storage->getRevisionNumber());
+			Assert::AreEqual(cache.size(), 0);
+		}
+
 		// System testing for editing commands 
 		TEST_METHOD(TasukeEditingTasks) {
 			Tasuke::instance().runCommand("add do homework");
@@ -24,9 +24,12 @@
 #include "Exceptions.h"
 #include "Constants.h"
 #include "Task.h"
+#include "TagDictionary.h"
+#include "TaskTransfer.h"
 #include "TaskWindow.h"
 #include "InputWindow.h"
 #include "StorageStub.h"
+#include "DateFormats.h"
 
 namespace Microsoft { 
     namespace VisualStudio { 